@@ -0,0 +1,105 @@
+#!/usr/bin/env python3
+# Copyright (c) 2024 The Krepto core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Decode a flight recorder file written by a node started with -flightrecorder."""
+
+import argparse
+import datetime
+import json
+import struct
+import sys
+
+MAGIC = b"KRFLTREC"
+FORMAT_VERSION = 1
+FILE_HEADER_SIZE = 64
+SLOT_HEADER_SIZE = 64
+RECORD_SIZE = 32
+
+# Must be kept in sync with flightrecorder::ConnectPhase, FlushStateMode and TxValidationResult.
+CONNECT_PHASES = ["load_block", "connect_block", "flush_view", "write_chainstate", "postprocess"]
+FLUSH_MODES = ["none", "if_needed", "periodic", "always"]
+TX_RESULTS = [
+    "unset", "consensus", "recent_consensus_change", "inputs_not_standard", "not_standard",
+    "missing_inputs", "premature_spend", "witness_mutated", "witness_stripped", "conflict",
+    "mempool_policy", "no_mempool", "reconsiderable", "unknown",
+]
+
+
+def name_or_number(names, index):
+    return names[index] if index < len(names) else str(index)
+
+
+def message_type(packed):
+    return packed.to_bytes(8, "little").rstrip(b"\0").decode("ascii", errors="replace")
+
+
+def describe(event, aux, a, b):
+    """Return the event name and its fields, matching the documentation of flightrecorder::Event."""
+    if event == 1:
+        return "connect_phase", {"phase": name_or_number(CONNECT_PHASES, aux), "height": a, "duration_us": b / 1000}
+    if event == 2:
+        return "coins_flush", {"mode": name_or_number(FLUSH_MODES, aux), "coins": a, "duration_us": b / 1000}
+    if event in (3, 4):
+        return "message_recv" if event == 3 else "message_send", {"peer": a, "type": message_type(b), "size": aux}
+    if event == 5:
+        return "mempool_accept", {"wtxid_prefix": f"{a:016x}", "vsize": aux, "duration_us": b / 1000}
+    if event == 6:
+        return "mempool_reject", {"wtxid_prefix": f"{a:016x}", "result": name_or_number(TX_RESULTS, aux), "duration_us": b / 1000}
+    return f"unknown_{event}", {"aux": aux, "a": a, "b": b}
+
+
+def read_events(data):
+    if len(data) < FILE_HEADER_SIZE or data[:8] != MAGIC:
+        sys.exit("Not a flight recorder file")
+    version, record_size, threads, per_thread, steady_start, system_start = struct.unpack_from("<IIIIQQ", data, 8)
+    if version != FORMAT_VERSION or record_size != RECORD_SIZE:
+        sys.exit(f"Unsupported flight recorder file version {version} (record size {record_size})")
+    rings_offset = FILE_HEADER_SIZE + threads * SLOT_HEADER_SIZE
+    if len(data) < rings_offset + threads * per_thread * RECORD_SIZE:
+        sys.exit("Flight recorder file is truncated")
+
+    events = []
+    for slot in range(threads):
+        header = FILE_HEADER_SIZE + slot * SLOT_HEADER_SIZE
+        (count,) = struct.unpack_from("<Q", data, header)
+        if count == 0:
+            continue
+        thread = data[header + 8:header + SLOT_HEADER_SIZE].split(b"\0", 1)[0].decode(errors="replace") or f"slot{slot}"
+        ring = rings_offset + slot * per_thread * RECORD_SIZE
+        # Only the last per_thread records are still in the ring.
+        for i in range(max(0, count - per_thread), count):
+            time_ns, event, _, aux, a, b = struct.unpack_from("<QHHIQQ", data, ring + (i % per_thread) * RECORD_SIZE)
+            name, fields = describe(event, aux, a, b)
+            events.append({
+                "time": (system_start + time_ns - steady_start) / 1e9,
+                "thread": thread,
+                "event": name,
+                **fields,
+            })
+    events.sort(key=lambda e: e["time"])
+    return events
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("file", help="flightrecorder.dat (or flightrecorder.dat.old) from the data directory")
+    parser.add_argument("--json", action="store_true", help="print one JSON object per event")
+    parser.add_argument("--event", action="append", help="only print events of this type (may be repeated)")
+    args = parser.parse_args()
+
+    with open(args.file, "rb") as f:
+        events = read_events(f.read())
+    for e in events:
+        if args.event and e["event"] not in args.event:
+            continue
+        if args.json:
+            print(json.dumps(e))
+            continue
+        when = datetime.datetime.fromtimestamp(e["time"], datetime.timezone.utc).strftime("%Y-%m-%dT%H:%M:%S.%fZ")
+        fields = " ".join(f"{k}={v}" for k, v in e.items() if k not in ("time", "thread", "event"))
+        print(f"{when} {e['thread']:<16} {e['event']:<15} {fields}")
+
+
+if __name__ == "__main__":
+    main()
@@ -86,6 +86,73 @@ static void CoinSelection(benchmark::Bench& bench)
     });
 }
 
+// Wallet holding many UTXOs of varied value, like those of a payout service
+static wallet::CoinsResult MakeLargeWalletCoins(const CWallet& wallet, std::vector<std::unique_ptr<CWalletTx>>& wtxs, int num_coins)
+{
+    for (int i = 0; i < num_coins; ++i) {
+        addCoin((1 + (i * 7919) % 5000) * 10'000, wallet, wtxs);
+    }
+    wallet::CoinsResult available_coins;
+    for (const auto& wtx : wtxs) {
+        const auto txout = wtx->tx->vout.at(0);
+        available_coins.coins[OutputType::BECH32].emplace_back(COutPoint(wtx->GetHash(), 0), txout, /*depth=*/6 * 24, CalculateMaximumSignedInputSize(txout, &wallet, /*coin_control=*/nullptr), /*spendable=*/true, /*solvable=*/true, /*safe=*/true, wtx->GetTxTime(), /*from_me=*/true, /*fees=*/ 0);
+    }
+    return available_coins;
+}
+
+static CoinSelectionParams MakeLargeWalletParams(FastRandomContext& rand, bool avoid_partial)
+{
+    return CoinSelectionParams{
+        rand,
+        /*change_output_size=*/ 31,
+        /*change_spend_size=*/ 68,
+        /*min_change_target=*/ CHANGE_LOWER,
+        /*effective_feerate=*/ CFeeRate(40'000),
+        /*long_term_feerate=*/ CFeeRate(10'000),
+        /*discard_feerate=*/ CFeeRate(3000),
+        /*tx_noinputs_size=*/ 0,
+        /*avoid_partial=*/ avoid_partial,
+    };
+}
+
+static void CoinSelectionLargeWallet(benchmark::Bench& bench)
+{
+    NodeContext node;
+    auto chain = interfaces::MakeChain(node);
+    CWallet wallet(chain.get(), "", CreateMockableWalletDatabase());
+    std::vector<std::unique_ptr<CWalletTx>> wtxs;
+    LOCK(wallet.cs_wallet);
+
+    const auto available_coins{MakeLargeWalletCoins(wallet, wtxs, 20'000)};
+    const CoinEligibilityFilter filter_standard(1, 6, 0);
+    FastRandomContext rand{/*fDeterministic=*/true};
+    const CoinSelectionParams coin_selection_params{MakeLargeWalletParams(rand, /*avoid_partial=*/false)};
+    auto group = wallet::GroupOutputs(wallet, available_coins, coin_selection_params, {{filter_standard}})[filter_standard];
+    bench.run([&] {
+        auto result = AttemptSelection(wallet.chain(), 12.3456 * COIN, group, coin_selection_params, /*allow_mixed_output_types=*/true);
+        assert(result);
+        assert(result->GetSelectedValue() >= 12.3456 * COIN);
+    });
+}
+
+static void GroupOutputsLargeWallet(benchmark::Bench& bench)
+{
+    NodeContext node;
+    auto chain = interfaces::MakeChain(node);
+    CWallet wallet(chain.get(), "", CreateMockableWalletDatabase());
+    std::vector<std::unique_ptr<CWalletTx>> wtxs;
+    LOCK(wallet.cs_wallet);
+
+    const auto available_coins{MakeLargeWalletCoins(wallet, wtxs, 20'000)};
+    const CoinEligibilityFilter filter_standard(1, 6, 0);
+    FastRandomContext rand{/*fDeterministic=*/true};
+    const CoinSelectionParams coin_selection_params{MakeLargeWalletParams(rand, /*avoid_partial=*/true)};
+    bench.run([&] {
+        auto groups = wallet::GroupOutputs(wallet, available_coins, coin_selection_params, {{filter_standard}});
+        assert(!groups[filter_standard].all_groups.positive_group.empty());
+    });
+}
+
 // Copied from src/wallet/test/coinselector_tests.cpp
 static void add_coin(const CAmount& nValue, int nInput, std::vector<OutputGroup>& set)
 {
@@ -126,3 +193,5 @@ static void BnBExhaustion(benchmark::Bench& bench)
 
 BENCHMARK(CoinSelection, benchmark::PriorityLevel::HIGH);
 BENCHMARK(BnBExhaustion, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CoinSelectionLargeWallet, benchmark::PriorityLevel::HIGH);
+BENCHMARK(GroupOutputsLargeWallet, benchmark::PriorityLevel::HIGH);
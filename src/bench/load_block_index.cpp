@@ -0,0 +1,88 @@
+// Copyright (c) 2024 The Krepto core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <common/args.h>
+#include <dbwrapper.h>
+#include <node/blockstorage.h>
+#include <pow.h>
+#include <primitives/block.h>
+#include <sync.h>
+#include <test/util/setup_common.h>
+#include <uint256.h>
+#include <util/chaintype.h>
+#include <util/fs.h>
+#include <util/signalinterrupt.h>
+#include <validation.h>
+
+#include <cassert>
+#include <deque>
+#include <memory>
+#include <vector>
+
+using kernel::BlockTreeDB;
+
+//! Roughly a year of blocks.
+static constexpr int NUM_HEADERS{50'000};
+
+/** A block tree database holding a chain of NUM_HEADERS regtest headers, and optionally a snapshot of it. */
+static std::unique_ptr<BlockTreeDB> MakeBlockTreeDB(const CChainParams& params, const fs::path& path, bool snapshot)
+{
+    auto db{std::make_unique<BlockTreeDB>(DBParams{.path = path, .cache_bytes = 8 << 20, .wipe_data = true})};
+    std::vector<uint256> hashes;
+    hashes.reserve(NUM_HEADERS);
+    std::deque<CBlockIndex> indexes;
+    CBlockHeader header;
+    header.nTime = params.GenesisBlock().nTime;
+    header.nBits = params.GenesisBlock().nBits;
+    for (int height = 0; height < NUM_HEADERS; ++height) {
+        header.hashPrevBlock = height > 0 ? hashes.back() : uint256{};
+        ++header.nTime;
+        while (!CheckProofOfWork(header.GetHash(), header.nBits, params.GetConsensus())) ++header.nNonce;
+        hashes.push_back(header.GetHash());
+        CBlockIndex& index{indexes.emplace_back(header)};
+        index.phashBlock = &hashes.back();
+        index.pprev = height > 0 ? &indexes[height - 1] : nullptr;
+        index.nHeight = height;
+        index.nTx = 1;
+        index.nStatus = BLOCK_HAVE_DATA | BLOCK_VALID_SCRIPTS;
+        index.nDataPos = height;
+    }
+    std::vector<const CBlockIndex*> blockinfo;
+    for (const CBlockIndex& index : indexes) blockinfo.push_back(&index);
+    assert(db->WriteBatchSync({}, 0, blockinfo));
+    if (snapshot) assert(db->WriteBlockIndexSnapshot(blockinfo));
+    return db;
+}
+
+/** Read the whole block index, as done at every startup. */
+static void LoadBlockIndex(benchmark::Bench& bench, bool snapshot)
+{
+    const auto testing_setup{MakeNoLogFileContext<const BasicTestingSetup>()};
+    const auto params{CreateChainParams(ArgsManager{}, ChainType::REGTEST)};
+    const auto db{MakeBlockTreeDB(*params, testing_setup->m_path_root / "blocks_index", snapshot)};
+    util::SignalInterrupt interrupt;
+    node::BlockMap block_index;
+    const auto insert_block_index{[&](const uint256& hash) -> CBlockIndex* {
+        if (hash.IsNull()) return nullptr;
+        const auto [it, inserted]{block_index.try_emplace(hash)};
+        if (inserted) it->second.phashBlock = &it->first;
+        return &it->second;
+    }};
+
+    LOCK(cs_main);
+    bench.unit("header").batch(NUM_HEADERS).run([&] {
+        block_index.clear();
+        assert(db->LoadBlockIndexGuts(params->GetConsensus(), insert_block_index, interrupt));
+        assert(block_index.size() == size_t{NUM_HEADERS});
+    });
+}
+
+static void LoadBlockIndexGuts(benchmark::Bench& bench) { LoadBlockIndex(bench, /*snapshot=*/false); }
+static void LoadBlockIndexSnapshot(benchmark::Bench& bench) { LoadBlockIndex(bench, /*snapshot=*/true); }
+
+BENCHMARK(LoadBlockIndexGuts, benchmark::PriorityLevel::HIGH);
+BENCHMARK(LoadBlockIndexSnapshot, benchmark::PriorityLevel::HIGH);
@@ -11,6 +11,7 @@
 #include <util/chaintype.h>
 #include <validation.h>
 
+#include <list>
 #include <vector>
 
 static void AddTx(const CTransactionRef& tx, CTxMemPool& pool) EXCLUSIVE_LOCKS_REQUIRED(cs_main, pool.cs)
@@ -118,5 +119,43 @@ static void MempoolCheck(benchmark::Bench& bench)
     });
 }
 
+/** Link every entry to the two before it, read the links and unlink them
+ *  again, as the parent and child links of entries are updated when they enter
+ *  and leave the mempool. Few entries have more than two of either. */
+template <typename LinkSet>
+static void MempoolLinks(benchmark::Bench& bench)
+{
+    std::list<CTxMemPoolEntry> entries;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        CMutableTransaction tx;
+        tx.vout.resize(1);
+        tx.nLockTime = i;
+        entries.emplace_back(MakeTransactionRef(tx), /*fee=*/1000, /*time=*/0, /*entry_height=*/1, /*entry_sequence=*/0,
+                             /*spends_coinbase=*/false, /*sigops_cost=*/4, LockPoints{});
+    }
+    const std::vector<std::reference_wrapper<const CTxMemPoolEntry>> refs(entries.begin(), entries.end());
+    std::vector<LinkSet> links(refs.size());
+
+    bench.run([&] {
+        for (size_t i = 0; i < refs.size(); ++i) {
+            for (size_t j = 1; j <= 2 && j <= i; ++j) links[i].insert(refs[i - j]);
+        }
+        int64_t size{0};
+        for (const auto& entry_links : links) {
+            for (const CTxMemPoolEntry& linked : entry_links) size += linked.GetTxSize();
+        }
+        ankerl::nanobench::doNotOptimizeAway(size);
+        for (size_t i = 0; i < refs.size(); ++i) {
+            for (size_t j = 1; j <= 2 && j <= i; ++j) links[i].erase(refs[i - j]);
+        }
+    });
+}
+
+static void MempoolLinksSmallVector(benchmark::Bench& bench) { MempoolLinks<CTxMemPoolEntry::Links>(bench); }
+//! The std::set the links used to be stored in, for comparison.
+static void MempoolLinksStdSet(benchmark::Bench& bench) { MempoolLinks<CTxMemPoolEntry::Parents>(bench); }
+
 BENCHMARK(ComplexMemPool, benchmark::PriorityLevel::HIGH);
 BENCHMARK(MempoolCheck, benchmark::PriorityLevel::HIGH);
+BENCHMARK(MempoolLinksSmallVector, benchmark::PriorityLevel::HIGH);
+BENCHMARK(MempoolLinksStdSet, benchmark::PriorityLevel::HIGH);
@@ -12,6 +12,10 @@
 
 #include <univalue.h>
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
 
 static void AddTx(const CTransactionRef& tx, const CAmount& fee, CTxMemPool& pool) EXCLUSIVE_LOCKS_REQUIRED(cs_main, pool.cs)
 {
@@ -19,22 +23,27 @@ static void AddTx(const CTransactionRef& tx, const CAmount& fee, CTxMemPool& poo
     pool.addUnchecked(CTxMemPoolEntry(tx, fee, /*time=*/0, /*entry_height=*/1, /*entry_sequence=*/0, /*spends_coinbase=*/false, /*sigops_cost=*/4, lp));
 }
 
+static CTransactionRef MakeTx(int i)
+{
+    CMutableTransaction tx = CMutableTransaction();
+    tx.vin.resize(1);
+    tx.vin[0].scriptSig = CScript() << OP_1;
+    tx.vin[0].scriptWitness.stack.push_back({1});
+    tx.vout.resize(1);
+    tx.vout[0].scriptPubKey = CScript() << OP_1 << OP_EQUAL;
+    tx.vout[0].nValue = i;
+    return MakeTransactionRef(tx);
+}
+
 static void RpcMempool(benchmark::Bench& bench)
 {
     const auto testing_setup = MakeNoLogFileContext<const ChainTestingSetup>(ChainType::MAIN);
     CTxMemPool& pool = *Assert(testing_setup->m_node.mempool);
-    LOCK2(cs_main, pool.cs);
-
-    for (int i = 0; i < 1000; ++i) {
-        CMutableTransaction tx = CMutableTransaction();
-        tx.vin.resize(1);
-        tx.vin[0].scriptSig = CScript() << OP_1;
-        tx.vin[0].scriptWitness.stack.push_back({1});
-        tx.vout.resize(1);
-        tx.vout[0].scriptPubKey = CScript() << OP_1 << OP_EQUAL;
-        tx.vout[0].nValue = i;
-        const CTransactionRef tx_r{MakeTransactionRef(tx)};
-        AddTx(tx_r, /*fee=*/i, pool);
+    {
+        LOCK2(cs_main, pool.cs);
+        for (int i = 0; i < 1000; ++i) {
+            AddTx(MakeTx(i), /*fee=*/i, pool);
+        }
     }
 
     bench.run([&] {
@@ -42,4 +51,38 @@ static void RpcMempool(benchmark::Bench& bench)
     });
 }
 
+/** Measure how long adding and removing a transaction takes while other threads keep polling the verbose mempool RPC. */
+static void RpcMempoolConcurrentReaders(benchmark::Bench& bench)
+{
+    const auto testing_setup = MakeNoLogFileContext<const ChainTestingSetup>(ChainType::MAIN);
+    CTxMemPool& pool = *Assert(testing_setup->m_node.mempool);
+    {
+        LOCK2(cs_main, pool.cs);
+        for (int i = 0; i < 1000; ++i) {
+            AddTx(MakeTx(i), /*fee=*/i, pool);
+        }
+    }
+
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 2; ++i) {
+        readers.emplace_back([&] {
+            while (!stop) {
+                (void)MempoolToJSON(pool, /*verbose=*/true);
+            }
+        });
+    }
+
+    const CTransactionRef tx{MakeTx(1000)};
+    bench.run([&] {
+        LOCK2(cs_main, pool.cs);
+        AddTx(tx, /*fee=*/1000, pool);
+        pool.removeRecursive(*tx, MemPoolRemovalReason::REPLACED);
+    });
+
+    stop = true;
+    for (auto& reader : readers) reader.join();
+}
+
 BENCHMARK(RpcMempool, benchmark::PriorityLevel::HIGH);
+BENCHMARK(RpcMempoolConcurrentReaders, benchmark::PriorityLevel::HIGH);
@@ -0,0 +1,76 @@
+// Copyright (c) 2024 The Krepto core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <compat/compat.h>
+#include <net.h>
+#include <protocol.h>
+#include <span.h>
+#include <test/util/setup_common.h>
+#include <util/sock.h>
+
+#include <cassert>
+#include <vector>
+
+#ifndef WIN32
+static constexpr size_t MESSAGES_PER_BATCH{64};
+
+/**
+ * Send a batch of small messages through a V1Transport over a local socket, as
+ * CConnman::SocketSendData does, and read them back on the other end. Sending
+ * a message's header and payload separately takes two send(2) calls per
+ * message, gathering them takes one sendmsg(2) call.
+ */
+static void SendMessages(benchmark::Bench& bench, bool gathered)
+{
+    const auto testing_setup{MakeNoLogFileContext<const BasicTestingSetup>()};
+    int fds[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    const Sock sender{static_cast<SOCKET>(fds[0])};
+    const Sock receiver{static_cast<SOCKET>(fds[1])};
+
+    V1Transport transport{/*node_id=*/0};
+    // About the size of an inv or a small transaction
+    const std::vector<unsigned char> payload(200);
+    std::vector<unsigned char> received(MESSAGES_PER_BATCH * (CMessageHeader::HEADER_SIZE + payload.size()));
+    std::vector<Span<const uint8_t>> buffers;
+
+    bench.batch(MESSAGES_PER_BATCH).unit("message").run([&] {
+        for (size_t i{0}; i < MESSAGES_PER_BATCH; ++i) {
+            CSerializedNetMsg msg;
+            msg.m_type = NetMsgType::TX;
+            msg.data = payload;
+            assert(transport.SetMessageToSend(msg));
+            while (true) {
+                ssize_t sent;
+                if (gathered) {
+                    transport.GetBuffersToSend(/*have_next_message=*/false, buffers);
+                    size_t size{0};
+                    for (const auto& buffer : buffers) size += buffer.size();
+                    if (size == 0) break;
+                    sent = sender.SendMany(buffers, MSG_NOSIGNAL);
+                } else {
+                    const auto& [bytes, more, msg_type] = transport.GetBytesToSend(/*have_next_message=*/false);
+                    if (bytes.empty()) break;
+                    sent = sender.Send(bytes.data(), bytes.size(), MSG_NOSIGNAL);
+                }
+                assert(sent > 0);
+                transport.MarkBytesSent(sent);
+            }
+        }
+        size_t read{0};
+        while (read < received.size()) {
+            const ssize_t ret{receiver.Recv(received.data() + read, received.size() - read, 0)};
+            assert(ret > 0);
+            read += ret;
+        }
+    });
+}
+
+static void SendMessagesHeaderThenPayload(benchmark::Bench& bench) { SendMessages(bench, /*gathered=*/false); }
+static void SendMessagesGathered(benchmark::Bench& bench) { SendMessages(bench, /*gathered=*/true); }
+
+BENCHMARK(SendMessagesHeaderThenPayload, benchmark::PriorityLevel::HIGH);
+BENCHMARK(SendMessagesGathered, benchmark::PriorityLevel::HIGH);
+#endif // WIN32
@@ -47,7 +47,8 @@ uint64_t CBlockHeaderAndShortTxIDs::GetShortID(const Wtxid& wtxid) const {
 
 
 
-ReadStatus PartiallyDownloadedBlock::InitData(const CBlockHeaderAndShortTxIDs& cmpctblock, const std::vector<CTransactionRef>& extra_txn) {
+ReadStatus PartiallyDownloadedBlock::InitData(const CBlockHeaderAndShortTxIDs& cmpctblock, const std::vector<CTransactionRef>& extra_txn,
+                                              const PartiallyDownloadedBlock* sibling) {
     if (cmpctblock.header.IsNull() || (cmpctblock.shorttxids.empty() && cmpctblock.prefilledtxn.empty()))
         return READ_STATUS_INVALID;
     if (cmpctblock.shorttxids.size() + cmpctblock.prefilledtxn.size() > MAX_BLOCK_WEIGHT / MIN_SERIALIZABLE_TRANSACTION_WEIGHT)
@@ -105,32 +106,54 @@ ReadStatus PartiallyDownloadedBlock::InitData(const CBlockHeaderAndShortTxIDs& c
         return READ_STATUS_FAILED; // Short ID collision
 
     std::vector<bool> have_txn(txn_available.size());
-    {
-    LOCK(pool->cs);
-    for (const auto& tx : pool->txns_randomized) {
-        uint64_t shortid = cmpctblock.GetShortID(tx->GetWitnessHash());
-        std::unordered_map<uint64_t, uint16_t>::iterator idit = shorttxids.find(shortid);
-        if (idit != shorttxids.end()) {
-            if (!have_txn[idit->second]) {
-                txn_available[idit->second] = tx;
-                have_txn[idit->second]  = true;
+
+    // Another peer's cmpctblock for the same header describes the same
+    // transactions at the same positions, so whatever that reconstruction
+    // already resolved only needs checking against our short IDs. This costs
+    // O(block) hashes instead of O(mempool), and when it resolves everything
+    // the mempool scan below is skipped entirely.
+    if (sibling && sibling->txn_available.size() == txn_available.size() &&
+        !sibling->header.IsNull() && sibling->header.GetHash() == header.GetHash()) {
+        for (const auto& [shortid, index] : shorttxids) {
+            const CTransactionRef& tx = sibling->txn_available[index];
+            if (tx && cmpctblock.GetShortID(tx->GetWitnessHash()) == shortid) {
+                txn_available[index] = tx;
+                have_txn[index] = true;
                 mempool_count++;
-            } else {
-                // If we find two mempool txn that match the short id, just request it.
-                // This should be rare enough that the extra bandwidth doesn't matter,
-                // but eating a round-trip due to FillBlock failure would be annoying
-                if (txn_available[idit->second]) {
-                    txn_available[idit->second].reset();
-                    mempool_count--;
-                }
+                sibling_count++;
             }
         }
-        // Though ideally we'd continue scanning for the two-txn-match-shortid case,
-        // the performance win of an early exit here is too good to pass up and worth
-        // the extra risk.
-        if (mempool_count == shorttxids.size())
-            break;
     }
+
+    if (mempool_count < shorttxids.size()) {
+        LOCK(pool->cs);
+        for (const auto& tx : pool->txns_randomized) {
+            uint64_t shortid = cmpctblock.GetShortID(tx->GetWitnessHash());
+            std::unordered_map<uint64_t, uint16_t>::iterator idit = shorttxids.find(shortid);
+            if (idit != shorttxids.end()) {
+                if (!have_txn[idit->second]) {
+                    txn_available[idit->second] = tx;
+                    have_txn[idit->second]  = true;
+                    mempool_count++;
+                } else {
+                    // If we find two mempool txn that match the short id, just request it.
+                    // This should be rare enough that the extra bandwidth doesn't matter,
+                    // but eating a round-trip due to FillBlock failure would be annoying
+                    // Transactions taken from the sibling are also in the mempool, so
+                    // compare witness hashes before treating this as a collision.
+                    if (txn_available[idit->second] &&
+                            txn_available[idit->second]->GetWitnessHash() != tx->GetWitnessHash()) {
+                        txn_available[idit->second].reset();
+                        mempool_count--;
+                    }
+                }
+            }
+            // Though ideally we'd continue scanning for the two-txn-match-shortid case,
+            // the performance win of an early exit here is too good to pass up and worth
+            // the extra risk.
+            if (mempool_count == shorttxids.size())
+                break;
+        }
     }
 
     for (size_t i = 0; i < extra_txn.size(); i++) {
@@ -167,7 +190,7 @@ ReadStatus PartiallyDownloadedBlock::InitData(const CBlockHeaderAndShortTxIDs& c
             break;
     }
 
-    LogPrint(BCLog::CMPCTBLOCK, "Initialized PartiallyDownloadedBlock for block %s using a cmpctblock of size %lu\n", cmpctblock.header.GetHash().ToString(), GetSerializeSize(cmpctblock));
+    LogPrint(BCLog::CMPCTBLOCK, "Initialized PartiallyDownloadedBlock for block %s using a cmpctblock of size %lu (%lu txn reused from another peer's reconstruction)\n", cmpctblock.header.GetHash().ToString(), GetSerializeSize(cmpctblock), sibling_count);
 
     return READ_STATUS_OK;
 }
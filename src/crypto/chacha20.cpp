@@ -5,6 +5,8 @@
 // Based on the public domain implementation 'merged' by D. J. Bernstein
 // See https://cr.yp.to/chacha.html.
 
+#include <config/bitcoin-config.h> // IWYU pragma: keep
+
 #include <crypto/common.h>
 #include <crypto/chacha20.h>
 #include <support/cleanse.h>
@@ -14,6 +16,20 @@
 #include <bit>
 #include <string.h>
 
+#if defined(__GNUC__) && (defined(__SSE2__) || defined(__ARM_NEON))
+#define ENABLE_CHACHA20_4WAY
+#include <crypto/chacha20_vec.ipp>
+#endif
+
+#if defined(ENABLE_AVX2)
+#include <compat/cpuid.h>
+
+namespace chacha20_avx2
+{
+size_t Crypt_8way(const uint32_t* input, const unsigned char* in, unsigned char* out, size_t blocks) noexcept;
+}
+#endif
+
 #define QUARTERROUND(a,b,c,d) \
   a += b; d = std::rotl(d ^ a, 16); \
   c += d; b = std::rotl(b ^ c, 12); \
@@ -22,6 +38,58 @@
 
 #define REPEAT10(a) do { {a}; {a}; {a}; {a}; {a}; {a}; {a}; {a}; {a}; {a}; } while(0)
 
+namespace {
+
+/** Multi-block keystream/encryption function, see ChaCha20Lanes::Crypt. */
+using CryptMultiBlockFn = size_t (*)(const uint32_t* input, const unsigned char* in, unsigned char* out, size_t blocks) noexcept;
+
+struct MultiBlockImpl {
+    CryptMultiBlockFn fn{nullptr};
+    /** Smallest number of blocks fn processes in one go. */
+    size_t lanes{0};
+};
+
+MultiBlockImpl DetectMultiBlock()
+{
+    MultiBlockImpl ret;
+#if defined(ENABLE_CHACHA20_4WAY)
+    ret = {ChaCha20Lanes<vec128>::Crypt, 4};
+#endif
+#if defined(ENABLE_AVX2) && defined(HAVE_GETCPUID)
+    uint32_t eax, ebx, ecx, edx;
+    GetCPUID(1, 0, eax, ebx, ecx, edx);
+    const bool have_xsave = (ecx >> 27) & 1;
+    const bool have_avx = (ecx >> 28) & 1;
+    if (have_xsave && have_avx) {
+        uint32_t a, d;
+        __asm__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+        GetCPUID(7, 0, eax, ebx, ecx, edx);
+        if ((a & 6) == 6 && ((ebx >> 5) & 1)) {
+            ret = {chacha20_avx2::Crypt_8way, 8};
+        }
+    }
+#endif
+    return ret;
+}
+
+/**
+ * Run as many leading blocks as possible through the multi-block
+ * implementation, advancing the block counter in input[8..9] accordingly.
+ * Returns the number of blocks processed.
+ */
+size_t CryptMultiBlock(uint32_t* input, const unsigned char* in, unsigned char* out, size_t blocks) noexcept
+{
+    static const MultiBlockImpl impl{DetectMultiBlock()};
+    if (impl.fn == nullptr || blocks < impl.lanes) return 0;
+    const size_t done{impl.fn(input, in, out, blocks)};
+    const uint64_t counter{(uint64_t{input[9]} << 32 | input[8]) + done};
+    input[8] = counter;
+    input[9] = counter >> 32;
+    return done;
+}
+
+} // namespace
+
 void ChaCha20Aligned::SetKey(Span<const std::byte> key) noexcept
 {
     assert(key.size() == KEYLEN);
@@ -63,6 +131,10 @@ inline void ChaCha20Aligned::Keystream(Span<std::byte> output) noexcept
     size_t blocks = output.size() / BLOCKLEN;
     assert(blocks * BLOCKLEN == output.size());
 
+    const size_t done = CryptMultiBlock(input, nullptr, c, blocks);
+    blocks -= done;
+    c += done * BLOCKLEN;
+
     uint32_t x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
     uint32_t j4, j5, j6, j7, j8, j9, j10, j11, j12, j13, j14, j15;
 
@@ -166,6 +238,11 @@ inline void ChaCha20Aligned::Crypt(Span<const std::byte> in_bytes, Span<std::byt
     size_t blocks = out_bytes.size() / BLOCKLEN;
     assert(blocks * BLOCKLEN == out_bytes.size());
 
+    const size_t done = CryptMultiBlock(input, m, c, blocks);
+    blocks -= done;
+    c += done * BLOCKLEN;
+    m += done * BLOCKLEN;
+
     uint32_t x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
     uint32_t j4, j5, j6, j7, j8, j9, j10, j11, j12, j13, j14, j15;
 
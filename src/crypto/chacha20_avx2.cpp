@@ -0,0 +1,18 @@
+// Copyright (c) 2024 The Krepto core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifdef ENABLE_AVX2
+
+#include <crypto/chacha20_vec.ipp>
+
+namespace chacha20_avx2 {
+
+size_t Crypt_8way(const uint32_t* input, const unsigned char* in, unsigned char* out, size_t blocks) noexcept
+{
+    return ChaCha20Lanes<vec256>::Crypt(input, in, out, blocks);
+}
+
+} // namespace chacha20_avx2
+
+#endif
@@ -16,12 +16,25 @@
 namespace poly1305_donna {
 
 // Based on the public domain implementation by Andrew Moon
+// poly1305-donna-64.h (where 128-bit multiplication is available) and
 // poly1305-donna-32.h from https://github.com/floodyberry/poly1305-donna
 
+#ifdef __SIZEOF_INT128__
+#define POLY1305_DONNA_64
+#endif
+
 typedef struct {
+#ifdef POLY1305_DONNA_64
+    /* 44/44/42-bit limbs */
+    uint64_t r[3];
+    uint64_t h[3];
+    uint64_t pad[2];
+#else
+    /* 26-bit limbs */
     uint32_t r[5];
     uint32_t h[5];
     uint32_t pad[4];
+#endif
     size_t leftover;
     unsigned char buffer[POLY1305_BLOCK_SIZE];
     unsigned char final;
@@ -29,6 +29,26 @@ struct DBOptions {
     bool force_compact = false;
 };
 
+//! LevelDB compacts level 1 into level 2 once it holds more than 10 MiB. With
+//! table files larger than that, every compaction into level 1 would overflow
+//! it and be followed by another one right away.
+static constexpr size_t DB_MAX_TABLE_FILE_SIZE{8 << 20};
+
+//! LevelDB settings matching how a database is accessed. Any of them can be
+//! changed for an existing database.
+struct DBTuning {
+    //! Keep a bloom filter (10 bits per key) for each table file, so that
+    //! looking up a key that is not in a file does not read from it. Worth the
+    //! memory for databases with frequent lookups of absent keys.
+    bool bloom_filter{true};
+    //! Approximate size of the unit of data read from disk and cached. Small
+    //! blocks suit random point lookups, larger ones iteration.
+    size_t block_size{4 << 10};
+    //! Size at which table files are split. Larger files mean fewer files to
+    //! search and keep open in large databases. At most DB_MAX_TABLE_FILE_SIZE.
+    size_t max_file_size{2 << 20};
+};
+
 //! Application-specific storage settings.
 struct DBParams {
     //! Location in the filesystem where leveldb data will be stored.
@@ -42,6 +62,8 @@ struct DBParams {
     //! If true, store data obfuscated via simple XOR. If false, XOR with a
     //! zero'd byte array.
     bool obfuscate = false;
+    //! Settings for the access pattern of this database.
+    DBTuning tuning{};
     //! Passed-through options.
     DBOptions options{};
 };
@@ -11,18 +11,23 @@
 #include <netaddress.h>
 #include <rpc/protocol.h>
 #include <rpc/server.h>
+#include <sync.h>
 #include <util/fs.h>
 #include <util/fs_helpers.h>
 #include <util/strencodings.h>
 #include <util/string.h>
+#include <util/time.h>
 #include <walletinitinterface.h>
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <iterator>
 #include <map>
 #include <memory>
 #include <optional>
 #include <set>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -32,6 +37,53 @@ using util::TrimStringView;
 /** WWW-Authenticate to present with 401 Unauthorized response */
 static const char* WWW_AUTH_HEADER_DATA = "Basic realm=\"jsonrpc\"";
 
+/** Serialized JSON replies larger than this are sent in chunks */
+static constexpr size_t RPC_REPLY_CHUNK_SIZE{1 << 20};
+
+/** Maximum number of threads executing the entries of one batch */
+static int g_rpc_batch_threads{DEFAULT_RPC_BATCH_THREADS};
+
+/** Methods without side effects, whose calls within a batch may run concurrently */
+static const std::set<std::string, std::less<>> PARALLEL_BATCH_METHODS{
+    "decoderawtransaction",
+    "decodescript",
+    "getbestblockhash",
+    "getblock",
+    "getblockcount",
+    "getblockfilter",
+    "getblockhash",
+    "getblockheader",
+    "getblockstats",
+    "getmempoolancestors",
+    "getmempooldescendants",
+    "getmempoolentry",
+    "getrawtransaction",
+    "gettxout",
+    "gettxoutproof",
+    "validateaddress",
+    "verifytxoutproof",
+};
+
+/** Methods that can run for minutes, and always run at low priority */
+static const std::set<std::string, std::less<>> LOW_PRIORITY_METHODS{
+    "dumptxoutset",
+    "gettxoutsetinfo",
+    "importdescriptors",
+    "importmulti",
+    "importwallet",
+    "loadtxoutset",
+    "rescanblockchain",
+    "scanblocks",
+    "scantxoutset",
+    "verifychain",
+};
+/** Number of calls to a method before its measured execution time sets its priority */
+static constexpr uint64_t RPC_PRIORITY_MIN_CALLS{10};
+/** Methods taking at most this long on average over their recent calls run at high priority */
+static constexpr auto RPC_FAST_METHOD_TIME{10ms};
+/** Methods taking at least this long on average over their recent calls run at low priority */
+static constexpr auto RPC_SLOW_METHOD_TIME{1s};
+
 /** Simple one-shot callback timer to be used by the RPC mechanism to e.g.
  * re-lock the wallet.
  */
@@ -99,6 +151,25 @@ static void JSONErrorReply(HTTPRequest* req, UniValue objError, const JSONRPCReq
     req->WriteReply(nStatus, strReply);
 }
 
+void WriteJSONReply(HTTPRequest* req, int nStatus, const UniValue& reply)
+{
+    req->WriteHeader("Content-Type", "application/json");
+    std::string buf;
+    bool chunked{false};
+    reply.write(buf, [&](std::string& out) {
+        req->WriteReplyChunk(nStatus, std::as_bytes(std::span{out}));
+        out.clear();
+        chunked = true;
+    }, RPC_REPLY_CHUNK_SIZE);
+    buf += '\n';
+    if (!chunked) {
+        req->WriteReply(nStatus, buf);
+        return;
+    }
+    req->WriteReplyChunk(nStatus, std::as_bytes(std::span{buf}));
+    req->EndChunkedReply();
+}
+
 //This function checks username and password against -rpcauth
 //entries from config file.
 static bool multiUserAuthorized(std::string strUserPass)
@@ -154,6 +225,94 @@ static bool RPCAuthorized(const std::string& strAuth, std::string& strAuthUserna
     return multiUserAuthorized(strUserPass);
 }
 
+/** RPCAuthorized for the authorization header of a request, checked once per request */
+static bool RequestAuthorized(HTTPRequest* req, std::string& user)
+{
+    if (!req->GetAuthResult()) {
+        const auto auth_header{req->GetHeader("authorization")};
+        HTTPRequest::AuthResult result{};
+        result.authorized = auth_header.first && RPCAuthorized(auth_header.second, result.user);
+        req->SetAuthResult(std::move(result));
+    }
+    user = req->GetAuthResult()->user;
+    return req->GetAuthResult()->authorized;
+}
+
+/** Whether a batch entry calls a method in PARALLEL_BATCH_METHODS */
+static bool IsParallelBatchEntry(const UniValue& request)
+{
+    if (!request.isObject()) return false;
+    const UniValue& method{request.find_value("method")};
+    return method.isStr() && PARALLEL_BATCH_METHODS.contains(method.get_str());
+}
+
+/** Execute one entry of a batch. Returns no response for notifications. */
+static std::optional<UniValue> ExecBatchEntry(JSONRPCRequest jreq, const UniValue& request)
+{
+    // Batches never throw HTTP errors, they are always just included
+    // in "HTTP OK" responses. Notifications never get any response.
+    UniValue response;
+    try {
+        jreq.parse(request);
+        response = JSONRPCExec(jreq, /*catch_errors=*/true);
+    } catch (UniValue& e) {
+        response = JSONRPCReplyObj(NullUniValue, std::move(e), jreq.id, jreq.m_json_version);
+    } catch (const std::exception& e) {
+        response = JSONRPCReplyObj(NullUniValue, JSONRPCError(RPC_PARSE_ERROR, e.what()), jreq.id, jreq.m_json_version);
+    }
+    if (jreq.IsNotification()) return std::nullopt;
+    return response;
+}
+
+/** Entries of a batch being executed by several threads. Shared with the
+ * helper threads, which may only start after the batch is done. */
+struct BatchExecution {
+    const JSONRPCRequest& jreq;
+    const UniValue& batch;
+    std::vector<std::optional<UniValue>>& responses;
+    const size_t end;
+    std::atomic<size_t> next;
+    Mutex mutex;
+    std::condition_variable cond;
+    size_t remaining GUARDED_BY(mutex);
+
+    BatchExecution(const JSONRPCRequest& jreq_in, const UniValue& batch_in, std::vector<std::optional<UniValue>>& responses_in, size_t begin, size_t end_in)
+        : jreq{jreq_in}, batch{batch_in}, responses{responses_in}, end{end_in}, next{begin}, remaining{end_in - begin} {}
+
+    /** Execute entries until none are left to start. Only the entries
+     * claimed here are accessed, so this is safe to call at any time. */
+    void Work() EXCLUSIVE_LOCKS_REQUIRED(!mutex)
+    {
+        size_t done{0};
+        for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < end; ++done) {
+            responses[i] = ExecBatchEntry(jreq, batch[i]);
+        }
+        if (done == 0) return;
+        LOCK(mutex);
+        remaining -= done;
+        if (remaining == 0) cond.notify_all();
+    }
+};
+
+/** Execute the entries [begin, end) of a batch, filling in their responses.
+ * Other entries are executed on idle HTTP worker threads, up to -rpcbatchthreads
+ * threads at once including this one. */
+static void ExecBatch(const JSONRPCRequest& jreq, const UniValue& batch, size_t begin, size_t end, std::vector<std::optional<UniValue>>& responses)
+{
+    if (end - begin == 1 || g_rpc_batch_threads <= 1) {
+        for (size_t i{begin}; i < end; ++i) responses[i] = ExecBatchEntry(jreq, batch[i]);
+        return;
+    }
+    auto execution{std::make_shared<BatchExecution>(jreq, batch, responses, begin, end)};
+    const size_t helpers{std::min<size_t>(g_rpc_batch_threads, end - begin) - 1};
+    for (size_t i{0}; i < helpers; ++i) {
+        if (!TryRunOnIdleHTTPWorker([execution] { execution->Work(); })) break;
+    }
+    execution->Work();
+    WAIT_LOCK(execution->mutex, lock);
+    execution->cond.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(execution->mutex) { return execution->remaining == 0; });
+}
+
 static bool HTTPReq_JSONRPC(const std::any& context, HTTPRequest* req)
 {
     // JSONRPC handles only POST
@@ -172,7 +331,7 @@ static bool HTTPReq_JSONRPC(const std::any& context, HTTPRequest* req)
     JSONRPCRequest jreq;
     jreq.context = context;
     jreq.peerAddr = req->GetPeer().ToStringAddrPort();
-    if (!RPCAuthorized(authHeader.second, jreq.authUser)) {
+    if (!RequestAuthorized(req, jreq.authUser)) {
         LogPrintf("ThreadRPCServer incorrect password attempt from %s\n", jreq.peerAddr);
 
         /* Deter brute-forcing
@@ -244,22 +403,20 @@ static bool HTTPReq_JSONRPC(const std::any& context, HTTPRequest* req)
             }
 
             // Execute each request
-            reply = UniValue::VARR;
-            for (size_t i{0}; i < valRequest.size(); ++i) {
-                // Batches never throw HTTP errors, they are always just included
-                // in "HTTP OK" responses. Notifications never get any response.
-                UniValue response;
-                try {
-                    jreq.parse(valRequest[i]);
-                    response = JSONRPCExec(jreq, /*catch_errors=*/true);
-                } catch (UniValue& e) {
-                    response = JSONRPCReplyObj(NullUniValue, std::move(e), jreq.id, jreq.m_json_version);
-                } catch (const std::exception& e) {
-                    response = JSONRPCReplyObj(NullUniValue, JSONRPCError(RPC_PARSE_ERROR, e.what()), jreq.id, jreq.m_json_version);
-                }
-                if (!jreq.IsNotification()) {
-                    reply.push_back(std::move(response));
+            std::vector<std::optional<UniValue>> responses(valRequest.size());
+            for (size_t i{0}; i < valRequest.size();) {
+                // Consecutive calls to methods without side effects run
+                // concurrently, any other call runs on its own.
+                size_t end{i + 1};
+                if (IsParallelBatchEntry(valRequest[i])) {
+                    while (end < valRequest.size() && IsParallelBatchEntry(valRequest[end])) ++end;
                 }
+                ExecBatch(jreq, valRequest, i, end, responses);
+                i = end;
+            }
+            reply = UniValue::VARR;
+            for (auto& response : responses) {
+                if (response) reply.push_back(std::move(*response));
             }
             // Return no response for an all-notification batch, but only if the
             // batch request is non-empty. Technically according to the JSON-RPC
@@ -278,8 +435,7 @@ static bool HTTPReq_JSONRPC(const std::any& context, HTTPRequest* req)
         else
             throw JSONRPCError(RPC_PARSE_ERROR, "Top-level object parse error");
 
-        req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, reply.write() + "\n");
+        WriteJSONReply(req, HTTP_OK, reply);
     } catch (UniValue& e) {
         JSONErrorReply(req, std::move(e), jreq);
         return false;
@@ -355,16 +511,106 @@ static bool InitRPCAuthentication()
     return true;
 }
 
+bool HasFullRPCAuthorization(HTTPRequest* req)
+{
+    std::string user;
+    if (!RequestAuthorized(req, user)) return false;
+    return !g_rpc_whitelist.count(user) && !g_rpc_whitelist_default;
+}
+
+/** Position of the quote ending the JSON string whose opening quote is at pos */
+static std::optional<size_t> FindJSONStringEnd(std::string_view body, size_t pos)
+{
+    while (true) {
+        pos = body.find_first_of("\"\\", pos + 1);
+        if (pos == std::string_view::npos) return std::nullopt;
+        if (body[pos] == '"') return pos;
+        ++pos; // skip the escaped character
+    }
+}
+
+/** The "method" of a JSON-RPC request object, if it can be found by a simple scan.
+ * Only keys of the top-level object are considered. */
+static std::optional<std::string_view> PeekJSONRPCMethod(std::string_view body)
+{
+    constexpr std::string_view whitespace{" \t\r\n"};
+    int depth{0};
+    bool expect_key{false};
+    for (size_t pos{0}; pos < body.size(); ++pos) {
+        switch (body[pos]) {
+        case '{':
+        case '[':
+            expect_key = ++depth == 1;
+            break;
+        case '}':
+        case ']':
+            if (--depth <= 0) return std::nullopt;
+            break;
+        case ',':
+            expect_key = depth == 1;
+            break;
+        case '"': {
+            const auto end{FindJSONStringEnd(body, pos)};
+            if (!end) return std::nullopt;
+            const bool is_method_key{expect_key && body.substr(pos + 1, *end - pos - 1) == "method"};
+            expect_key = false;
+            pos = *end;
+            if (!is_method_key) break;
+
+            pos = body.find_first_not_of(whitespace, pos + 1);
+            if (pos == std::string_view::npos || body[pos] != ':') return std::nullopt;
+            pos = body.find_first_not_of(whitespace, pos + 1);
+            if (pos == std::string_view::npos || body[pos] != '"') return std::nullopt;
+            // Method names never need escaping.
+            const size_t value_end{body.find_first_of("\"\\", pos + 1)};
+            if (value_end == std::string_view::npos || body[value_end] != '"') return std::nullopt;
+            return body.substr(pos + 1, value_end - pos - 1);
+        }
+        }
+    }
+    return std::nullopt;
+}
+
+HTTPPriority GetJSONRPCPriority(std::string_view body)
+{
+    // Batches are run at normal priority, whatever they contain.
+    const size_t start{body.find_first_not_of(" \t\r\n")};
+    if (start == std::string_view::npos || body[start] != '{') return HTTPPriority::NORMAL;
+    const auto method{PeekJSONRPCMethod(body)};
+    if (!method) return HTTPPriority::NORMAL;
+    if (LOW_PRIORITY_METHODS.contains(*method)) return HTTPPriority::LOW;
+
+    const auto& latency{tableRPC.GetMethodLatency()};
+    const auto it{latency.find(std::string{*method})};
+    if (it == latency.end()) return HTTPPriority::NORMAL;
+    if (it->second.GetCount() < RPC_PRIORITY_MIN_CALLS) return HTTPPriority::NORMAL;
+    // A moving average rather than the mean since startup, so that a method
+    // which became slow (e.g. as a wallet grew) loses its HIGH priority.
+    const auto mean{tableRPC.GetRecentMethodLatency(it->first)};
+    if (!mean) return HTTPPriority::NORMAL;
+    if (*mean <= RPC_FAST_METHOD_TIME) return HTTPPriority::HIGH;
+    if (*mean >= RPC_SLOW_METHOD_TIME) return HTTPPriority::LOW;
+    return HTTPPriority::NORMAL;
+}
+
 bool StartHTTPRPC(const std::any& context)
 {
     LogPrint(BCLog::RPC, "Starting HTTP RPC server\n");
     if (!InitRPCAuthentication())
         return false;
+    g_rpc_batch_threads = std::max<int>(gArgs.GetIntArg("-rpcbatchthreads", DEFAULT_RPC_BATCH_THREADS), 1);
 
     auto handle_rpc = [context](HTTPRequest* req, const std::string&) { return HTTPReq_JSONRPC(context, req); };
-    RegisterHTTPHandler("/", true, handle_rpc);
+    auto rpc_priority = [](HTTPRequest* req, const std::string&) {
+        // Only authenticated requests may jump the queue, or get the deeper
+        // queue of HIGH priority requests.
+        std::string user;
+        if (!RequestAuthorized(req, user)) return HTTPPriority::NORMAL;
+        return GetJSONRPCPriority(req->PeekBody());
+    };
+    RegisterHTTPHandler("/", true, handle_rpc, rpc_priority);
     if (g_wallet_init_interface.HasWalletSupport()) {
-        RegisterHTTPHandler("/wallet/", false, handle_rpc);
+        RegisterHTTPHandler("/wallet/", false, handle_rpc, rpc_priority);
     }
     struct event_base* eventBase = EventBase();
     assert(eventBase);
@@ -5,7 +5,15 @@
 #ifndef BITCOIN_HTTPRPC_H
 #define BITCOIN_HTTPRPC_H
 
+#include <httpserver.h>
+
 #include <any>
+#include <string_view>
+
+class UniValue;
+
+/** Default for -rpcbatchthreads */
+static const int DEFAULT_RPC_BATCH_THREADS{4};
 
 /** Start HTTP RPC subsystem.
  * Precondition; HTTP and RPC has been started.
@@ -19,6 +27,25 @@ void InterruptHTTPRPC();
  */
 void StopHTTPRPC();
 
+/** Priority of a JSON-RPC request body on the HTTP worker threads. Methods
+ * that are known to be expensive, or measured to be slow over their recent
+ * calls, run at LOW priority and methods measured to be fast at HIGH priority.
+ * The method is found without parsing the body, as every prioritized request
+ * is classified before its handler runs. Does not check authentication.
+ */
+HTTPPriority GetJSONRPCPriority(std::string_view body);
+
+/** Serialize a JSON reply and send it, streaming it as a chunked reply once
+ * the serialized size exceeds 1 MiB so that large results, of RPC or REST
+ * requests, are never held as a single string.
+ */
+void WriteJSONReply(HTTPRequest* req, int nStatus, const UniValue& reply);
+
+/** Whether a request carries the credentials of an RPC user that may call
+ * every method, i.e. one not restricted by -rpcwhitelist. Does not reply.
+ */
+bool HasFullRPCAuthorization(HTTPRequest* req);
+
 /** Start HTTP REST subsystem.
  * Precondition; HTTP and RPC has been started.
  */
@@ -31,4 +58,12 @@ void InterruptREST();
  */
 void StopREST();
 
+/** Start serving the /metrics endpoint to RPC users (see HasFullRPCAuthorization).
+ * Precondition; HTTP and RPC has been started.
+ */
+void StartMetrics(const std::any& context);
+/** Stop serving the /metrics endpoint.
+ */
+void StopMetrics();
+
 #endif // BITCOIN_HTTPRPC_H
@@ -20,6 +20,8 @@
 #include <util/threadnames.h>
 #include <util/translation.h>
 
+#include <array>
+#include <chrono>
 #include <condition_variable>
 #include <cstdio>
 #include <cstdlib>
@@ -66,8 +68,9 @@ private:
     HTTPRequestHandler func;
 };
 
-/** Simple work queue for distributing work over multiple threads.
- * Work items are simply callable objects.
+/** Work queue for distributing work over multiple threads.
+ * Work items are simply callable objects. They are run in order of priority,
+ * and in the order they were queued within a priority.
  */
 template <typename WorkItem>
 class WorkQueue
@@ -75,25 +78,59 @@ class WorkQueue
 private:
     Mutex cs;
     std::condition_variable cond GUARDED_BY(cs);
-    std::deque<std::unique_ptr<WorkItem>> queue GUARDED_BY(cs);
+    //! One queue per HTTPPriority.
+    std::array<std::deque<std::unique_ptr<WorkItem>>, 3> queues GUARDED_BY(cs);
+    size_t m_queued GUARDED_BY(cs){0};
+    //! Number of threads waiting for an item.
+    size_t m_idle GUARDED_BY(cs){0};
+    //! Number of LOW priority items being run.
+    size_t m_low_running GUARDED_BY(cs){0};
     bool running GUARDED_BY(cs){true};
     const size_t maxDepth;
+    const size_t m_max_low_running;
+
+    /** The queue to take the next item from, or nullptr if none may be run now. */
+    std::deque<std::unique_ptr<WorkItem>>* NextQueue() EXCLUSIVE_LOCKS_REQUIRED(cs)
+    {
+        for (auto priority : {HTTPPriority::HIGH, HTTPPriority::NORMAL}) {
+            auto& queue{queues[static_cast<size_t>(priority)]};
+            if (!queue.empty()) return &queue;
+        }
+        auto& queue{queues[static_cast<size_t>(HTTPPriority::LOW)]};
+        // Drain the queue regardless of the limit when shutting down.
+        if (!queue.empty() && (m_low_running < m_max_low_running || !running)) return &queue;
+        return nullptr;
+    }
 
 public:
-    explicit WorkQueue(size_t _maxDepth) : maxDepth(_maxDepth)
+    /** @param[in] threads Number of threads that will call Run(). */
+    WorkQueue(size_t _maxDepth, size_t threads) : maxDepth(_maxDepth), m_max_low_running(std::max<size_t>(threads, 2) - 1)
     {
     }
     /** Precondition: worker threads have all stopped (they have been joined).
      */
     ~WorkQueue() = default;
     /** Enqueue a work item */
-    bool Enqueue(WorkItem* item) EXCLUSIVE_LOCKS_REQUIRED(!cs)
+    bool Enqueue(WorkItem* item, HTTPPriority priority = HTTPPriority::NORMAL) EXCLUSIVE_LOCKS_REQUIRED(!cs)
+    {
+        LOCK(cs);
+        if (!running || m_queued >= (priority == HTTPPriority::HIGH ? 2 * maxDepth : maxDepth)) {
+            return false;
+        }
+        queues[static_cast<size_t>(priority)].emplace_back(std::unique_ptr<WorkItem>(item));
+        ++m_queued;
+        cond.notify_one();
+        return true;
+    }
+    /** Enqueue a work item at NORMAL priority if an idle thread can run it right away */
+    bool EnqueueIfIdle(WorkItem* item) EXCLUSIVE_LOCKS_REQUIRED(!cs)
     {
         LOCK(cs);
-        if (!running || queue.size() >= maxDepth) {
+        if (!running || m_queued >= m_idle) {
             return false;
         }
-        queue.emplace_back(std::unique_ptr<WorkItem>(item));
+        queues[static_cast<size_t>(HTTPPriority::NORMAL)].emplace_back(std::unique_ptr<WorkItem>(item));
+        ++m_queued;
         cond.notify_one();
         return true;
     }
@@ -102,16 +139,30 @@ public:
     {
         while (true) {
             std::unique_ptr<WorkItem> i;
+            bool low;
             {
                 WAIT_LOCK(cs, lock);
-                while (running && queue.empty())
+                std::deque<std::unique_ptr<WorkItem>>* queue;
+                while (!(queue = NextQueue()) && running) {
+                    ++m_idle;
                     cond.wait(lock);
-                if (!running && queue.empty())
+                    --m_idle;
+                }
+                if (!queue)
                     break;
-                i = std::move(queue.front());
-                queue.pop_front();
+                i = std::move(queue->front());
+                queue->pop_front();
+                --m_queued;
+                low = queue == &queues[static_cast<size_t>(HTTPPriority::LOW)];
+                if (low) ++m_low_running;
             }
             (*i)();
+            if (low) {
+                LOCK(cs);
+                --m_low_running;
+                // Another LOW priority item may have been waiting for this one.
+                cond.notify_one();
+            }
         }
     }
     /** Interrupt and exit loops */
@@ -123,15 +174,27 @@ public:
     }
 };
 
+/** Work item running a function */
+class HTTPFunctionWorkItem final : public HTTPClosure
+{
+public:
+    explicit HTTPFunctionWorkItem(std::function<void()> func) : m_func(std::move(func)) {}
+    void operator()() override { m_func(); }
+
+private:
+    std::function<void()> m_func;
+};
+
 struct HTTPPathHandler
 {
-    HTTPPathHandler(std::string _prefix, bool _exactMatch, HTTPRequestHandler _handler):
-        prefix(_prefix), exactMatch(_exactMatch), handler(_handler)
+    HTTPPathHandler(std::string _prefix, bool _exactMatch, HTTPRequestHandler _handler, HTTPPriorityFunction _priority):
+        prefix(_prefix), exactMatch(_exactMatch), handler(_handler), priority(_priority)
     {
     }
     std::string prefix;
     bool exactMatch;
     HTTPRequestHandler handler;
+    HTTPPriorityFunction priority;
 };
 
 /** HTTP module state */
@@ -150,6 +213,39 @@ static std::vector<HTTPPathHandler> pathHandlers GUARDED_BY(g_httppathhandlers_m
 //! Bound listening sockets
 static std::vector<evhttp_bound_socket *> boundSockets;
 
+/** Queue a work item for the worker threads, or reject its request if the queue is too deep */
+static void QueueHTTPWorkItem(std::unique_ptr<HTTPClosure> item, HTTPRequest& req, HTTPPriority priority)
+{
+    assert(g_work_queue);
+    if (g_work_queue->Enqueue(item.get(), priority)) {
+        item.release(); /* if true, queue took ownership */
+    } else {
+        LogPrintf("WARNING: request rejected because http work queue depth exceeded, it can be increased with the -rpcworkqueue= setting\n");
+        req.WriteReply(HTTP_SERVICE_UNAVAILABLE, "Work queue depth exceeded");
+    }
+}
+
+/** Work item deciding the priority of a request, and queueing the request at that priority */
+class HTTPPriorityWorkItem final : public HTTPClosure
+{
+public:
+    HTTPPriorityWorkItem(std::unique_ptr<HTTPWorkItem> item, const std::string& path, const HTTPPriorityFunction& priority) :
+        m_item(std::move(item)), m_path(path), m_priority(priority)
+    {
+    }
+    void operator()() override
+    {
+        HTTPRequest& req{*m_item->req};
+        const HTTPPriority priority{m_priority(&req, m_path)};
+        QueueHTTPWorkItem(std::move(m_item), req, priority);
+    }
+
+private:
+    std::unique_ptr<HTTPWorkItem> m_item;
+    std::string m_path;
+    HTTPPriorityFunction m_priority;
+};
+
 /**
  * @brief Helps keep track of open `evhttp_connection`s with active `evhttp_requests`
  *
@@ -324,13 +420,14 @@ static void http_request_cb(struct evhttp_request* req, void* arg)
 
     // Dispatch to worker thread
     if (i != iend) {
-        std::unique_ptr<HTTPWorkItem> item(new HTTPWorkItem(std::move(hreq), path, i->handler));
-        assert(g_work_queue);
-        if (g_work_queue->Enqueue(item.get())) {
-            item.release(); /* if true, queue took ownership */
+        auto item{std::make_unique<HTTPWorkItem>(std::move(hreq), path, i->handler)};
+        HTTPRequest& req{*item->req};
+        if (i->priority) {
+            // Deciding the priority may take checking credentials, which is left to a worker
+            // thread. Until then the request may queue as deep as a HIGH priority one.
+            QueueHTTPWorkItem(std::make_unique<HTTPPriorityWorkItem>(std::move(item), path, i->priority), req, HTTPPriority::HIGH);
         } else {
-            LogPrintf("WARNING: request rejected because http work queue depth exceeded, it can be increased with the -rpcworkqueue= setting\n");
-            item->req->WriteReply(HTTP_SERVICE_UNAVAILABLE, "Work queue depth exceeded");
+            QueueHTTPWorkItem(std::move(item), req, HTTPPriority::NORMAL);
         }
     } else {
         hreq->WriteReply(HTTP_NOT_FOUND);
@@ -462,9 +559,10 @@ bool InitHTTPServer(const util::SignalInterrupt& interrupt)
 
     LogPrint(BCLog::HTTP, "Initialized HTTP server\n");
     int workQueueDepth = std::max((long)gArgs.GetIntArg("-rpcworkqueue", DEFAULT_HTTP_WORKQUEUE), 1L);
+    int rpcThreads = std::max((long)gArgs.GetIntArg("-rpcthreads", DEFAULT_HTTP_THREADS), 1L);
     LogDebug(BCLog::HTTP, "creating work queue of depth %d\n", workQueueDepth);
 
-    g_work_queue = std::make_unique<WorkQueue<HTTPClosure>>(workQueueDepth);
+    g_work_queue = std::make_unique<WorkQueue<HTTPClosure>>(workQueueDepth, rpcThreads);
     // transfer ownership to eventBase/HTTP via .release()
     eventBase = base_ctr.release();
     eventHTTP = http_ctr.release();
@@ -577,6 +675,31 @@ void HTTPEvent::trigger(struct timeval* tv)
     else
         evtimer_add(ev, tv); // trigger after timeval passed
 }
+/** Most bytes of a chunked reply that may wait in the output buffer of the connection */
+static constexpr size_t MAX_CHUNKED_REPLY_BUFFER{4 << 20};
+
+struct HTTPRequest::ChunkedReplyState {
+    Mutex m_mutex;
+    std::condition_variable m_cv;
+    //! Bytes of the reply not yet known to have been written to the socket
+    size_t m_buffered GUARDED_BY(m_mutex){0};
+    //! Whether the connection has gone away
+    bool m_closed GUARDED_BY(m_mutex){false};
+
+    //! Refresh the state from the connection. Only call from the event thread.
+    void Update(evhttp_connection* conn) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        bufferevent* bev{conn ? evhttp_connection_get_bufferevent(conn) : nullptr};
+        LOCK(m_mutex);
+        if (bev) {
+            m_buffered = evbuffer_get_length(bufferevent_get_output(bev));
+        } else {
+            m_closed = true;
+        }
+        m_cv.notify_all();
+    }
+};
+
 HTTPRequest::HTTPRequest(struct evhttp_request* _req, const util::SignalInterrupt& interrupt, bool _replySent)
     : req(_req), m_interrupt(interrupt), replySent(_replySent)
 {
@@ -584,7 +707,21 @@ HTTPRequest::HTTPRequest(struct evhttp_request* _req, const util::SignalInterrup
 
 HTTPRequest::~HTTPRequest()
 {
-    if (!replySent) {
+    if (!replySent && m_chunked) {
+        // Sending the final chunk would present the truncated body as a
+        // complete reply, so drop the connection instead.
+        LogPrintf("%s: Unterminated chunked reply, closing connection\n", __func__);
+        auto req_copy = req;
+        HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, state = m_chunked]{
+            if (evhttp_connection* conn = evhttp_request_get_connection(req_copy)) {
+                evhttp_connection_free(conn);
+            } else {
+                // The client is already gone, this only frees the request.
+                evhttp_send_reply_end(req_copy);
+            }
+        });
+        ev->trigger(nullptr);
+    } else if (!replySent) {
         // Keep track of whether reply was sent to avoid request leaks
         LogPrintf("%s: Unhandled request\n", __func__);
         WriteReply(HTTP_INTERNAL_SERVER_ERROR, "Unhandled request");
@@ -623,6 +760,19 @@ std::string HTTPRequest::ReadBody()
     return rv;
 }
 
+std::string_view HTTPRequest::PeekBody()
+{
+    struct evbuffer* buf = evhttp_request_get_input_buffer(req);
+    if (!buf)
+        return {};
+    size_t size = evbuffer_get_length(buf);
+    // Making the buffer contiguous here also saves ReadBody() from doing it.
+    const char* data = (const char*)evbuffer_pullup(buf, size);
+    if (!data)
+        return {};
+    return {data, size};
+}
+
 void HTTPRequest::WriteHeader(const std::string& hdr, const std::string& value)
 {
     struct evkeyvalq* headers = evhttp_request_get_output_headers(req);
@@ -665,6 +815,77 @@ void HTTPRequest::WriteReply(int nStatus, std::span<const std::byte> reply)
     req = nullptr; // transferred back to main thread
 }
 
+void HTTPRequest::WriteReplyChunk(int nStatus, std::span<const std::byte> chunk)
+{
+    assert(!replySent && req);
+    auto req_copy = req;
+    if (!m_chunked) {
+        if (m_interrupt) {
+            WriteHeader("Connection", "close");
+        }
+        HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, nStatus]{
+            evhttp_send_reply_start(req_copy, nStatus, nullptr);
+        });
+        ev->trigger(nullptr);
+        m_chunked = std::make_shared<ChunkedReplyState>();
+    }
+    if (chunk.empty()) return;
+    ChunkedReplyState& state{*m_chunked};
+    {
+        WAIT_LOCK(state.m_mutex, lock);
+        // Wait for the client to catch up. The connection reports when its
+        // output buffer has been drained; the probes make sure a client that
+        // disconnected meanwhile is noticed as well.
+        while (state.m_buffered > MAX_CHUNKED_REPLY_BUFFER && !state.m_closed && !m_interrupt) {
+            if (state.m_cv.wait_for(lock, std::chrono::milliseconds{100}) == std::cv_status::timeout) {
+                HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, state_copy = m_chunked]{
+                    state_copy->Update(evhttp_request_get_connection(req_copy));
+                });
+                ev->trigger(nullptr);
+            }
+        }
+        if (state.m_closed) return;
+        state.m_buffered += chunk.size();
+    }
+    // Copy the chunk into its own buffer here, the event runs after the
+    // caller has reused its memory.
+    struct evbuffer* evb = evbuffer_new();
+    assert(evb);
+    evbuffer_add(evb, chunk.data(), chunk.size());
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, evb, state_copy = m_chunked]{
+        // The callback is replaced by the next chunk and by the end of the
+        // reply, both of which keep the state alive until they have run.
+        evhttp_send_reply_chunk_with_cb(req_copy, evb, [](evhttp_connection* conn, void* arg) {
+            static_cast<ChunkedReplyState*>(arg)->Update(conn);
+        }, state_copy.get());
+        evbuffer_free(evb);
+        state_copy->Update(evhttp_request_get_connection(req_copy));
+    });
+    ev->trigger(nullptr);
+}
+
+void HTTPRequest::EndChunkedReply()
+{
+    assert(!replySent && req && m_chunked);
+    auto req_copy = req;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, state = m_chunked]{
+        evhttp_send_reply_end(req_copy);
+        // Re-enable reading from the socket, see WriteReply.
+        if (event_get_version_number() >= 0x02010600 && event_get_version_number() < 0x02010900) {
+            evhttp_connection* conn = evhttp_request_get_connection(req_copy);
+            if (conn) {
+                bufferevent* bev = evhttp_connection_get_bufferevent(conn);
+                if (bev) {
+                    bufferevent_enable(bev, EV_READ | EV_WRITE);
+                }
+            }
+        }
+    });
+    ev->trigger(nullptr);
+    replySent = true;
+    req = nullptr; // transferred back to main thread
+}
+
 CService HTTPRequest::GetPeer() const
 {
     evhttp_connection* con = evhttp_request_get_connection(req);
@@ -740,11 +961,20 @@ std::optional<std::string> GetQueryParameterFromUri(const char* uri, const std::
     return result;
 }
 
-void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler)
+bool TryRunOnIdleHTTPWorker(std::function<void()> func)
+{
+    if (!g_work_queue) return false;
+    auto item{std::make_unique<HTTPFunctionWorkItem>(std::move(func))};
+    if (!g_work_queue->EnqueueIfIdle(item.get())) return false;
+    item.release(); // the queue took ownership
+    return true;
+}
+
+void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler, const HTTPPriorityFunction& priority)
 {
     LogPrint(BCLog::HTTP, "Registering HTTP handler for %s (exactmatch %d)\n", prefix, exactMatch);
     LOCK(g_httppathhandlers_mutex);
-    pathHandlers.emplace_back(prefix, exactMatch, handler);
+    pathHandlers.emplace_back(prefix, exactMatch, handler, priority);
 }
 
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch)
@@ -6,9 +6,11 @@
 #define BITCOIN_HTTPSERVER_H
 
 #include <functional>
+#include <memory>
 #include <optional>
 #include <span>
 #include <string>
+#include <string_view>
 
 namespace util {
 class SignalInterrupt;
@@ -40,16 +42,37 @@ void StopHTTPServer();
 /** Change logging level for libevent. */
 void UpdateHTTPServerLogging(bool enable);
 
+/** Order in which queued requests are handed to the worker threads. */
+enum class HTTPPriority {
+    //! Cheap requests, which may also queue beyond -rpcworkqueue so they are
+    //! not rejected while the queue is full of more expensive ones.
+    HIGH,
+    NORMAL,
+    //! Expensive requests, which are never run on all worker threads at once
+    //! (unless there is only one), so that others are not starved.
+    LOW,
+};
+
 /** Handler for requests to a certain HTTP path */
 typedef std::function<bool(HTTPRequest* req, const std::string &)> HTTPRequestHandler;
+/** Priority of a request to a certain HTTP path. Called on a worker thread,
+ * ahead of the requests already queued, before the request is queued at the
+ * returned priority; so it should be cheap compared with the handler. */
+typedef std::function<HTTPPriority(HTTPRequest* req, const std::string &)> HTTPPriorityFunction;
 /** Register handler for prefix.
  * If multiple handlers match a prefix, the first-registered one will
- * be invoked.
+ * be invoked. Requests run at NORMAL priority unless a priority function is given.
  */
-void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler);
+void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler, const HTTPPriorityFunction& priority = {});
 /** Unregister handler for prefix */
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch);
 
+/** Run a function on an HTTP worker thread, but only if one is idle and can
+ * start it right away, so that requests from other clients are not delayed.
+ * Returns whether the function was queued.
+ */
+bool TryRunOnIdleHTTPWorker(std::function<void()> func);
+
 /** Return evhttp event base. This can be used by submodules to
  * queue timers or custom events.
  */
@@ -64,6 +87,19 @@ private:
     struct evhttp_request* req;
     const util::SignalInterrupt& m_interrupt;
     bool replySent;
+    struct ChunkedReplyState;
+    //! Flow control state of a chunked reply, set once WriteReplyChunk started one
+    std::shared_ptr<ChunkedReplyState> m_chunked;
+
+public:
+    /** Outcome of checking the credentials of a request */
+    struct AuthResult {
+        bool authorized;
+        std::string user;
+    };
+
+private:
+    std::optional<AuthResult> m_auth_result;
 
 public:
     explicit HTTPRequest(struct evhttp_request* req, const util::SignalInterrupt& interrupt, bool replySent = false);
@@ -106,6 +142,14 @@ public:
      */
     std::pair<bool, std::string> GetHeader(const std::string& hdr) const;
 
+    /**
+     * Get or set the outcome of checking the request's credentials, so that
+     * both the priority function and the handler may use it but they are
+     * only hashed once.
+     */
+    const std::optional<AuthResult>& GetAuthResult() const { return m_auth_result; }
+    void SetAuthResult(AuthResult result) { m_auth_result = std::move(result); }
+
     /**
      * Read request body.
      *
@@ -114,6 +158,13 @@ public:
      */
     std::string ReadBody();
 
+    /**
+     * Get the request body without consuming it.
+     *
+     * @note The view is invalidated by ReadBody().
+     */
+    std::string_view PeekBody();
+
     /**
      * Write output header.
      *
@@ -134,6 +185,28 @@ public:
         WriteReply(nStatus, std::as_bytes(std::span{reply}));
     }
     void WriteReply(int nStatus, std::span<const std::byte> reply);
+
+    /**
+     * Write part of a chunked HTTP reply.
+     * The first call sends the status line and headers, subsequent calls
+     * append to the body. nStatus is only used by the first call.
+     * Blocks while too much of the reply is waiting to be sent to the client,
+     * so that a slow client does not make the whole reply pile up in memory.
+     * Chunks are dropped once the client has disconnected.
+     *
+     * @note Must be followed by EndChunkedReply. Do not mix with WriteReply.
+     * If the request is destroyed without EndChunkedReply (e.g. because the
+     * handler threw), the connection is closed without terminating the body,
+     * so that the client cannot mistake the truncated reply for a complete one.
+     */
+    void WriteReplyChunk(int nStatus, std::span<const std::byte> chunk);
+
+    /**
+     * Finish a chunked HTTP reply started by WriteReplyChunk.
+     *
+     * @note As with WriteReply, this gives the request back to the main thread.
+     */
+    void EndChunkedReply();
 };
 
 /** Get the query parameter value from request uri for a specified key, or std::nullopt if the key
@@ -31,7 +31,10 @@ public:
 };
 
 TxIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
-    BaseIndex::DB(gArgs.GetDataDirNet() / "indexes" / "txindex", n_cache_size, f_memory, f_wipe)
+    // Unlike in the other indexes, lookups are for arbitrary keys, often ones
+    // that are not indexed (yet).
+    BaseIndex::DB(gArgs.GetDataDirNet() / "indexes" / "txindex", n_cache_size, f_memory, f_wipe, /*f_obfuscate=*/false,
+                  {.bloom_filter = true, .max_file_size = DB_MAX_TABLE_FILE_SIZE})
 {}
 
 bool TxIndex::DB::ReadTxPos(const uint256 &txid, CDiskTxPos& pos) const
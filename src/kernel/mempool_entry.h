@@ -8,12 +8,15 @@
 #include <consensus/amount.h>
 #include <consensus/validation.h>
 #include <core_memusage.h>
+#include <memusage.h>
 #include <policy/policy.h>
 #include <policy/settings.h>
+#include <prevector.h>
 #include <primitives/transaction.h>
 #include <util/epochguard.h>
 #include <util/overflow.h>
 
+#include <algorithm>
 #include <chrono>
 #include <functional>
 #include <memory>
@@ -70,6 +73,47 @@ public:
     typedef std::set<CTxMemPoolEntryRef, CompareIteratorByHash> Parents;
     typedef std::set<CTxMemPoolEntryRef, CompareIteratorByHash> Children;
 
+    /** Direct in-mempool parents or children of an entry, ordered like
+     * CompareIteratorByHash. Most entries only have a handful of them, so a
+     * sorted small vector is used instead of a std::set: up to two links are
+     * stored inline, and larger sets need one allocation instead of a node each. */
+    class Links
+    {
+        prevector<2, CTxMemPoolEntryRef> m_refs;
+
+    public:
+        using const_iterator = prevector<2, CTxMemPoolEntryRef>::const_iterator;
+
+        const_iterator begin() const { return m_refs.begin(); }
+        const_iterator end() const { return m_refs.end(); }
+        const_iterator cbegin() const { return m_refs.begin(); }
+        const_iterator cend() const { return m_refs.end(); }
+        size_t size() const { return m_refs.size(); }
+        bool empty() const { return m_refs.empty(); }
+
+        /** Add entry, returning false if it was already present. */
+        bool insert(const CTxMemPoolEntry& entry)
+        {
+            const CTxMemPoolEntryRef ref{entry};
+            auto it{std::lower_bound(m_refs.begin(), m_refs.end(), ref, CompareIteratorByHash{})};
+            if (it != m_refs.end() && &it->get() == &entry) return false;
+            m_refs.insert(it, ref);
+            return true;
+        }
+
+        /** Remove entry, returning false if it was not present. */
+        bool erase(const CTxMemPoolEntry& entry)
+        {
+            const CTxMemPoolEntryRef ref{entry};
+            auto it{std::lower_bound(m_refs.begin(), m_refs.end(), ref, CompareIteratorByHash{})};
+            if (it == m_refs.end() || &it->get() != &entry) return false;
+            m_refs.erase(it);
+            return true;
+        }
+
+        size_t DynamicMemoryUsage() const { return memusage::DynamicUsage(m_refs); }
+    };
+
 private:
     CTxMemPoolEntry(const CTxMemPoolEntry&) = default;
     struct ExplicitCopyTag {
@@ -77,8 +121,8 @@ private:
     };
 
     const CTransactionRef tx;
-    mutable Parents m_parents;
-    mutable Children m_children;
+    mutable Links m_parents;
+    mutable Links m_children;
     const CAmount nFee;             //!< Cached to avoid expensive parent-transaction lookups
     const int32_t nTxWeight;         //!< ... and avoid recomputing tx weight (also used for GetTxSize())
     const size_t nUsageSize;        //!< ... and total memory usage
@@ -179,10 +223,10 @@ public:
     CAmount GetModFeesWithAncestors() const { return nModFeesWithAncestors; }
     int64_t GetSigOpCostWithAncestors() const { return nSigOpCostWithAncestors; }
 
-    const Parents& GetMemPoolParentsConst() const { return m_parents; }
-    const Children& GetMemPoolChildrenConst() const { return m_children; }
-    Parents& GetMemPoolParents() const { return m_parents; }
-    Children& GetMemPoolChildren() const { return m_children; }
+    const Links& GetMemPoolParentsConst() const { return m_parents; }
+    const Links& GetMemPoolChildrenConst() const { return m_children; }
+    Links& GetMemPoolParents() const { return m_parents; }
+    Links& GetMemPoolChildren() const { return m_children; }
 
     mutable size_t idx_randomized; //!< Index in mempool's txns_randomized
     mutable Epoch::Marker m_epoch_marker; //!< epoch when last touched, useful for graph algorithms
@@ -10,6 +10,7 @@
 #include <util/threadnames.h>
 #include <util/time.h>
 
+#include <algorithm>
 #include <array>
 #include <map>
 #include <optional>
@@ -89,11 +90,46 @@ bool BCLog::Logger::StartLogging()
     m_cur_buffer_memusage = 0;
     if (m_print_to_console) fflush(stdout);
 
+    if (m_log_async) {
+        m_async_running = true;
+        m_async_writer = std::thread{&Logger::AsyncWriterThread, this};
+    }
     return true;
 }
 
+BCLog::Logger::~Logger()
+{
+    StopAsyncWriter();
+}
+
+void BCLog::Logger::StartAsyncWriter()
+{
+    StdLockGuard scoped_lock(m_cs);
+    assert(!m_buffering);
+    if (m_async_writer.joinable()) return;
+    m_async_running = true;
+    m_async_writer = std::thread{&Logger::AsyncWriterThread, this};
+}
+
+void BCLog::Logger::StopAsyncWriter()
+{
+    if (!m_async_writer.joinable()) return;
+    m_async_running = false;
+    // Producers that still saw the writer running finish queueing their record before the
+    // writer's final pass, so nothing is left behind.
+    while (m_async_producers.load() > 0) std::this_thread::yield();
+    {
+        std::lock_guard<std::mutex> lock{m_async_wake_mutex};
+        m_async_stop = true;
+    }
+    m_async_wake.notify_one();
+    m_async_writer.join();
+    m_async_stop = false;
+}
+
 void BCLog::Logger::DisconnectTestLogger()
 {
+    StopAsyncWriter();
     StdLockGuard scoped_lock(m_cs);
     m_buffering = true;
     if (m_fileout != nullptr) fclose(m_fileout);
@@ -384,10 +420,143 @@ void BCLog::Logger::FormatLogStrInPlace(std::string& str, BCLog::LogFlags catego
 
 void BCLog::Logger::LogPrintStr(std::string_view str, std::string_view logging_function, std::string_view source_file, int source_line, BCLog::LogFlags category, BCLog::Level level)
 {
+    if (m_async_running.load(std::memory_order_relaxed) &&
+        LogPrintStrAsync(str, logging_function, source_file, source_line, category, level)) {
+        return;
+    }
     StdLockGuard scoped_lock(m_cs);
     return LogPrintStr_(str, logging_function, source_file, source_line, category, level);
 }
 
+struct BCLog::Logger::AsyncQueue {
+    std::vector<AsyncRecord> records = std::vector<AsyncRecord>(ASYNC_LOG_QUEUE_RECORDS);
+    //! Index (modulo records.size()) of the next record the writer reads. Only the writer stores it.
+    std::atomic<size_t> head{0};
+    //! Index (modulo records.size()) of the next record the producer writes. Only the producer stores it.
+    std::atomic<size_t> tail{0};
+
+    bool TryPush(std::atomic<uint64_t>& sequence, std::string&& str)
+    {
+        const size_t t{tail.load(std::memory_order_relaxed)};
+        if (t - head.load(std::memory_order_acquire) == records.size()) return false;
+        // Only take a sequence number once the record is sure to be queued, so
+        // that the writer never waits for one that was dropped.
+        records[t % records.size()] = {sequence++, std::move(str)};
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    void PopAll(std::vector<AsyncRecord>& out)
+    {
+        const size_t h{head.load(std::memory_order_relaxed)};
+        const size_t t{tail.load(std::memory_order_acquire)};
+        for (size_t i = h; i != t; ++i) {
+            out.push_back(std::move(records[i % records.size()]));
+        }
+        head.store(t, std::memory_order_release);
+    }
+
+    bool Empty() const { return head.load() == tail.load(); }
+};
+
+BCLog::Logger::AsyncQueue& BCLog::Logger::GetThreadAsyncQueue()
+{
+    thread_local const Logger* owner{nullptr};
+    thread_local std::shared_ptr<AsyncQueue> queue;
+    if (owner != this) {
+        queue = std::make_shared<AsyncQueue>();
+        owner = this;
+        StdLockGuard lock(m_async_queues_mutex);
+        m_async_queues.push_back(queue);
+    }
+    return *queue;
+}
+
+bool BCLog::Logger::LogPrintStrAsync(std::string_view str, std::string_view logging_function, std::string_view source_file, int source_line, BCLog::LogFlags category, BCLog::Level level)
+{
+    ++m_async_producers;
+    if (!m_async_running) {
+        --m_async_producers;
+        return false;
+    }
+
+    std::string str_prefixed = LogEscapeMessage(str);
+    const bool starts_new_line = m_started_new_line.exchange(!str.empty() && str[str.size() - 1] == '\n');
+    if (starts_new_line) {
+        FormatLogStrInPlace(str_prefixed, category, level, source_file, source_line, logging_function, util::ThreadGetInternalName(), SystemClock::now(), GetMockTime());
+    }
+    if (!GetThreadAsyncQueue().TryPush(m_async_sequence, std::move(str_prefixed))) {
+        ++m_async_dropped;
+    }
+
+    --m_async_producers;
+    return true;
+}
+
+void BCLog::Logger::AsyncWriterThread()
+{
+    util::ThreadRename("logger");
+    std::vector<AsyncRecord> records;
+    while (true) {
+        // Read the stop flag before draining, so that the last pass sees everything queued.
+        const bool stop{m_async_stop};
+        {
+            StdLockGuard lock(m_async_queues_mutex);
+            for (auto it{m_async_queues.begin()}; it != m_async_queues.end();) {
+                (*it)->PopAll(records);
+                // Forget the queues of threads that have exited.
+                if (it->use_count() == 1 && (*it)->Empty()) {
+                    it = m_async_queues.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+        // By the final pass all producers are done, so nothing is held back.
+        WriteAsyncRecords(records, /*flush=*/stop);
+        if (stop) break;
+
+        std::unique_lock<std::mutex> lock{m_async_wake_mutex};
+        m_async_wake.wait_for(lock, ASYNC_LOG_WRITE_INTERVAL, [&] { return m_async_stop.load(); });
+    }
+}
+
+void BCLog::Logger::WriteAsyncRecords(std::vector<AsyncRecord>& records, bool flush)
+{
+    if (const uint64_t dropped{m_async_dropped.exchange(0)}) {
+        std::string msg{strprintf("%d log messages dropped because the asynchronous logging queue of their thread was full\n", dropped)};
+        FormatLogStrInPlace(msg, BCLog::ALL, Level::Warning, __FILE__, __LINE__, __func__, util::ThreadGetInternalName(), SystemClock::now(), GetMockTime());
+        records.push_back({m_async_sequence++, std::move(msg)});
+    }
+    if (records.empty()) return;
+
+    std::sort(records.begin(), records.end(), [](const AsyncRecord& a, const AsyncRecord& b) { return a.sequence < b.sequence; });
+    // A producer may have taken a lower sequence number than records already
+    // drained from other threads' queues, and not have queued its record yet.
+    // Hold back everything from the first gap on, so the log stays in order.
+    size_t count{0};
+    while (count < records.size() && (flush || records[count].sequence == m_async_next_write)) {
+        m_async_next_write = records[count].sequence + 1;
+        ++count;
+    }
+    if (count == 0) return;
+
+    size_t size{0};
+    for (size_t i = 0; i < count; ++i) size += records[i].str.size();
+    std::string batch;
+    batch.reserve(size);
+    for (size_t i = 0; i < count; ++i) batch += records[i].str;
+
+    {
+        StdLockGuard scoped_lock(m_cs);
+        for (const auto& cb : m_print_callbacks) {
+            for (size_t i = 0; i < count; ++i) cb(records[i].str);
+        }
+        WriteToOutputs(batch);
+    }
+    records.erase(records.begin(), records.begin() + count);
+}
+
 void BCLog::Logger::LogPrintStr_(std::string_view str, std::string_view logging_function, std::string_view source_file, int source_line, BCLog::LogFlags category, BCLog::Level level)
 {
     std::string str_prefixed = LogEscapeMessage(str);
@@ -440,14 +609,19 @@ void BCLog::Logger::LogPrintStr_(std::string_view str, std::string_view logging_
         FormatLogStrInPlace(str_prefixed, category, level, source_file, source_line, logging_function, util::ThreadGetInternalName(), SystemClock::now(), GetMockTime());
     }
 
+    for (const auto& cb : m_print_callbacks) {
+        cb(str_prefixed);
+    }
+    WriteToOutputs(str_prefixed);
+}
+
+void BCLog::Logger::WriteToOutputs(std::string_view str)
+{
     if (m_print_to_console) {
         // print to console
-        fwrite(str_prefixed.data(), 1, str_prefixed.size(), stdout);
+        fwrite(str.data(), 1, str.size(), stdout);
         fflush(stdout);
     }
-    for (const auto& cb : m_print_callbacks) {
-        cb(str_prefixed);
-    }
     if (m_print_to_file) {
         assert(m_fileout != nullptr);
 
@@ -461,7 +635,7 @@ void BCLog::Logger::LogPrintStr_(std::string_view str, std::string_view logging_
                 m_fileout = new_fileout;
             }
         }
-        FileWriteStr(str_prefixed, m_fileout);
+        FileWriteStr(str, m_fileout);
     }
 }
 
@@ -13,11 +13,14 @@
 #include <util/time.h>
 
 #include <atomic>
+#include <condition_variable>
 #include <cstdint>
 #include <functional>
 #include <list>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -27,6 +30,7 @@ static const bool DEFAULT_LOGTIMESTAMPS = true;
 static const bool DEFAULT_LOGTHREADNAMES = false;
 static const bool DEFAULT_LOGSOURCELOCATIONS = false;
 static constexpr bool DEFAULT_LOGLEVELALWAYS = false;
+static constexpr bool DEFAULT_LOGASYNC{false};
 extern const char * const DEFAULT_DEBUGLOGFILE;
 
 extern bool fLogIPs;
@@ -81,6 +85,10 @@ namespace BCLog {
     };
     constexpr auto DEFAULT_LOG_LEVEL{Level::Debug};
     constexpr size_t DEFAULT_MAX_LOG_BUFFER{1'000'000}; // buffer up to 1MB of log data prior to StartLogging
+    //! Log records each thread can have queued for the asynchronous writer before further ones are dropped.
+    constexpr size_t ASYNC_LOG_QUEUE_RECORDS{2048};
+    //! How often the asynchronous writer wakes up to write out queued records.
+    constexpr auto ASYNC_LOG_WRITE_INTERVAL{std::chrono::milliseconds{20}};
 
     class Logger
     {
@@ -132,6 +140,46 @@ namespace BCLog {
         void LogPrintStr_(std::string_view str, std::string_view logging_function, std::string_view source_file, int source_line, BCLog::LogFlags category, BCLog::Level level)
             EXCLUSIVE_LOCKS_REQUIRED(m_cs);
 
+        /** Write an already formatted string to the console and the log file. */
+        void WriteToOutputs(std::string_view str) EXCLUSIVE_LOCKS_REQUIRED(m_cs);
+
+        /** Per-thread single-producer single-consumer queue of records for the asynchronous writer. */
+        struct AsyncQueue;
+        struct AsyncRecord {
+            uint64_t sequence;
+            std::string str;
+        };
+
+        StdMutex m_async_queues_mutex;
+        std::vector<std::shared_ptr<AsyncQueue>> m_async_queues GUARDED_BY(m_async_queues_mutex);
+        std::thread m_async_writer;
+        //! Whether producers should hand records to the asynchronous writer.
+        std::atomic_bool m_async_running{false};
+        //! Producers that saw m_async_running set and have not finished queueing their record.
+        std::atomic<int> m_async_producers{0};
+        //! Orders records across the per-thread queues. Only taken once a record is sure to be queued.
+        std::atomic<uint64_t> m_async_sequence{0};
+        //! Sequence number of the next record to write. Only used by the writer thread.
+        uint64_t m_async_next_write{0};
+        //! Records dropped because their thread's queue was full, not yet reported in the log.
+        std::atomic<uint64_t> m_async_dropped{0};
+        std::mutex m_async_wake_mutex;
+        std::condition_variable m_async_wake;
+        std::atomic_bool m_async_stop{false};
+
+        /** Format and queue a record for the asynchronous writer. Returns false if it is not running. */
+        bool LogPrintStrAsync(std::string_view str, std::string_view logging_function, std::string_view source_file, int source_line, BCLog::LogFlags category, BCLog::Level level)
+            EXCLUSIVE_LOCKS_REQUIRED(!m_async_queues_mutex);
+        AsyncQueue& GetThreadAsyncQueue() EXCLUSIVE_LOCKS_REQUIRED(!m_async_queues_mutex);
+        void AsyncWriterThread() EXCLUSIVE_LOCKS_REQUIRED(!m_cs, !m_async_queues_mutex);
+        /**
+         * Write out and remove the records that continue the sequence without a gap, or all of
+         * them if flush is set. Records after a gap (a producer took the missing sequence number
+         * but has not queued its record yet) are left for the next call. Only called from the
+         * writer thread.
+         */
+        void WriteAsyncRecords(std::vector<AsyncRecord>& records, bool flush) EXCLUSIVE_LOCKS_REQUIRED(!m_cs, !m_async_queues_mutex);
+
         std::string GetLogPrefix(LogFlags category, Level level) const;
 
     public:
@@ -144,12 +192,29 @@ namespace BCLog {
         bool m_log_sourcelocations = DEFAULT_LOGSOURCELOCATIONS;
         bool m_always_print_category_level = DEFAULT_LOGLEVELALWAYS;
 
+        /** Start a writer thread from StartLogging(), see StartAsyncWriter(). */
+        bool m_log_async = DEFAULT_LOGASYNC;
+
         fs::path m_file_path;
         std::atomic<bool> m_reopen_file{false};
 
+        Logger() = default;
+        ~Logger();
+
         /** Send a string to the log output */
         void LogPrintStr(std::string_view str, std::string_view logging_function, std::string_view source_file, int source_line, BCLog::LogFlags category, BCLog::Level level)
-            EXCLUSIVE_LOCKS_REQUIRED(!m_cs);
+            EXCLUSIVE_LOCKS_REQUIRED(!m_cs, !m_async_queues_mutex);
+
+        /**
+         * Have a background thread do the writing. Logging threads then format their records
+         * and append them to a queue of their own without taking any lock; the writer
+         * periodically writes out all queued records in order. Records that do not fit in
+         * their thread's queue (ASYNC_LOG_QUEUE_RECORDS) are dropped, and the number dropped is
+         * logged. Must be called after StartLogging().
+         */
+        void StartAsyncWriter() EXCLUSIVE_LOCKS_REQUIRED(!m_cs);
+        /** Write out all queued records and stop the writer thread. Later records are written synchronously. */
+        void StopAsyncWriter() EXCLUSIVE_LOCKS_REQUIRED(!m_cs, !m_async_queues_mutex);
 
         /** Returns whether logs will be written to any output */
         bool Enabled() const EXCLUSIVE_LOCKS_REQUIRED(!m_cs)
@@ -176,7 +241,7 @@ namespace BCLog {
         /** Start logging (and flush all buffered messages) */
         bool StartLogging() EXCLUSIVE_LOCKS_REQUIRED(!m_cs);
         /** Only for testing */
-        void DisconnectTestLogger() EXCLUSIVE_LOCKS_REQUIRED(!m_cs);
+        void DisconnectTestLogger() EXCLUSIVE_LOCKS_REQUIRED(!m_cs, !m_async_queues_mutex);
 
         /** Disable logging
          * This offers a slight speedup and slightly smaller memory usage
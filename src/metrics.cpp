@@ -0,0 +1,130 @@
+// Copyright (c) 2024 The Krepto core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <httprpc.h>
+
+#include <httpserver.h>
+#include <net.h>
+#include <node/context.h>
+#include <rpc/protocol.h>
+#include <rpc/server.h>
+#include <tinyformat.h>
+#include <txmempool.h>
+#include <util/any.h>
+#include <util/latencyhistogram.h>
+#include <util/time.h>
+#include <validation.h>
+
+#include <any>
+#include <chrono>
+#include <string>
+#include <string_view>
+
+using node::NodeContext;
+
+static const std::string METRICS_PATH{"/metrics"};
+//! Same realm as JSON-RPC, so that the same credentials apply.
+static const char* METRICS_WWW_AUTH_HEADER_DATA{"Basic realm=\"jsonrpc\""};
+//! Quantiles reported for every latency summary.
+static constexpr double METRICS_QUANTILES[]{0.5, 0.9, 0.99, 0.999};
+
+static void AppendMetricHeader(std::string& out, std::string_view name, std::string_view type, std::string_view help)
+{
+    out += strprintf("# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+/** Append a summary of a histogram of microseconds, in seconds as is the Prometheus convention. */
+static void AppendLatencySummary(std::string& out, std::string_view name, std::string_view labels, const LatencyHistogram& histogram)
+{
+    const auto snapshot{histogram.GetSnapshot()};
+    for (double quantile : METRICS_QUANTILES) {
+        out += strprintf("%s{%s,quantile=\"%g\"} %.6f\n", name, labels, quantile, snapshot.Percentile(quantile * 100) / 1e6);
+    }
+    out += strprintf("%s_sum{%s} %.6f\n", name, labels, snapshot.sum / 1e6);
+    out += strprintf("%s_count{%s} %u\n", name, labels, snapshot.count);
+}
+
+/**
+ * Serve the node's metrics in the Prometheus text exposition format. Every
+ * value is read from an atomic maintained where it changes, so a scrape takes
+ * no locks that block validation, the mempool or the network.
+ *
+ * The per-method RPC series reveal wallet activity, so scrapes need the
+ * credentials of an RPC user that may call every method.
+ */
+static bool metrics_handler(const std::any& context, HTTPRequest* req, const std::string&)
+{
+    if (!HasFullRPCAuthorization(req)) {
+        // Deter brute-forcing, as for JSON-RPC.
+        if (req->GetHeader("authorization").first) UninterruptibleSleep(std::chrono::milliseconds{250});
+        req->WriteHeader("WWW-Authenticate", METRICS_WWW_AUTH_HEADER_DATA);
+        req->WriteReply(HTTP_UNAUTHORIZED);
+        return false;
+    }
+    if (req->GetRequestMethod() != HTTPRequest::GET) {
+        req->WriteReply(HTTP_BAD_METHOD, "Only GET is supported");
+        return false;
+    }
+    std::string out;
+
+    const auto krepto_net_message_bytes_total{"krepto_net_message_bytes_total"};
+    AppendMetricHeader(out, krepto_net_message_bytes_total, "counter", "Bytes of P2P messages sent and received, including headers, by message type.");
+    for (size_t i = 0; i < MsgTypeTraffic::COUNTERS; ++i) {
+        out += strprintf("%s{direction=\"sent\",msgtype=\"%s\"} %u\n", krepto_net_message_bytes_total, MsgTypeTraffic::Type(i), g_msg_type_traffic.Sent(i));
+        out += strprintf("%s{direction=\"recv\",msgtype=\"%s\"} %u\n", krepto_net_message_bytes_total, MsgTypeTraffic::Type(i), g_msg_type_traffic.Recv(i));
+    }
+
+    // The node context is only fully set up once initialization has finished.
+    const NodeContext* node{RPCIsInWarmup(nullptr) ? nullptr : util::AnyPtr<NodeContext>(context)};
+    if (node && node->mempool) {
+        const auto stats{node->mempool->GetPublishedStats()};
+        AppendMetricHeader(out, "krepto_mempool_transactions", "gauge", "Number of transactions in the mempool.");
+        out += strprintf("krepto_mempool_transactions %u\n", stats.count);
+        AppendMetricHeader(out, "krepto_mempool_vsize_bytes", "gauge", "Sum of the virtual sizes of the transactions in the mempool.");
+        out += strprintf("krepto_mempool_vsize_bytes %u\n", stats.tx_size);
+        AppendMetricHeader(out, "krepto_mempool_usage_bytes", "gauge", "Memory usage of the mempool.");
+        out += strprintf("krepto_mempool_usage_bytes %u\n", stats.usage);
+    }
+    if (node && node->chainman) {
+        const ChainstateManager& chainman{*node->chainman};
+        AppendMetricHeader(out, "krepto_chain_tip_height", "gauge", "Height of the active chain tip.");
+        out += strprintf("krepto_chain_tip_height %d\n", chainman.m_published_tip_height.load(std::memory_order_relaxed));
+        AppendMetricHeader(out, "krepto_coins_cache_usage_bytes", "gauge", "Memory usage of the UTXO cache of the active chainstate.");
+        out += strprintf("krepto_coins_cache_usage_bytes %u\n", chainman.m_published_coins_tip_usage.load(std::memory_order_relaxed));
+        AppendMetricHeader(out, "krepto_coins_cache_entries", "gauge", "Number of entries in the UTXO cache of the active chainstate.");
+        out += strprintf("krepto_coins_cache_entries %u\n", chainman.m_published_coins_tip_count.load(std::memory_order_relaxed));
+
+        const auto krepto_validation_duration_seconds{"krepto_validation_duration_seconds"};
+        AppendMetricHeader(out, krepto_validation_duration_seconds, "summary", "Time spent in each phase of block validation.");
+        for (size_t i = 0; i < VALIDATION_PHASE_COUNT; ++i) {
+            const auto phase{static_cast<ValidationPhase>(i)};
+            AppendLatencySummary(out, krepto_validation_duration_seconds, strprintf("phase=\"%s\"", ValidationPhaseName(phase)), chainman.GetValidationTiming(phase));
+        }
+    }
+
+    const auto krepto_rpc_duration_seconds{"krepto_rpc_duration_seconds"};
+    AppendMetricHeader(out, krepto_rpc_duration_seconds, "summary", "Time spent executing each RPC method.");
+    for (const auto& [method, histogram] : tableRPC.GetMethodLatency()) {
+        // Most of the methods are never called on a given node.
+        if (histogram.GetCount() == 0) continue;
+        AppendLatencySummary(out, krepto_rpc_duration_seconds, strprintf("method=\"%s\"", method), histogram);
+    }
+
+    req->WriteHeader("Content-Type", "text/plain; version=0.0.4; charset=utf-8");
+    req->WriteReply(HTTP_OK, out);
+    return true;
+}
+
+void StartMetrics(const std::any& context)
+{
+    RegisterHTTPHandler(
+        METRICS_PATH, true,
+        [context](HTTPRequest* req, const std::string& path) { return metrics_handler(context, req, path); },
+        [](HTTPRequest* req, const std::string&) { return HasFullRPCAuthorization(req) ? HTTPPriority::HIGH : HTTPPriority::NORMAL; });
+}
+
+void StopMetrics()
+{
+    UnregisterHTTPHandler(METRICS_PATH, true);
+}
@@ -27,6 +27,7 @@
 #include <protocol.h>
 #include <random.h>
 #include <scheduler.h>
+#include <util/flightrecorder.h>
 #include <util/fs.h>
 #include <util/sock.h>
 #include <util/strencodings.h>
@@ -103,6 +104,7 @@ enum BindFlags {
 static const uint64_t SELECT_TIMEOUT_MILLISECONDS = 50;
 
 const std::string NET_MESSAGE_TYPE_OTHER = "*other*";
+MsgTypeTraffic g_msg_type_traffic;
 
 static const uint64_t RANDOMIZER_ID_NETGROUP = 0x6c0edd8036ef4036ULL; // SHA256("netgroup")[0:8]
 static const uint64_t RANDOMIZER_ID_LOCALHOSTNONCE = 0xd93e69e2bbfa5735ULL; // SHA256("localhostnonce")[0:8]
@@ -124,6 +126,43 @@ size_t CSerializedNetMsg::GetMemoryUsage() const noexcept
     return sizeof(*this) + memusage::DynamicUsage(data);
 }
 
+std::vector<unsigned char> SendBufferPool::Get(size_t size)
+{
+    if (size >= MIN_BUFFER_CAPACITY / 2 && size <= MAX_BUFFER_CAPACITY) {
+        LOCK(m_mutex);
+        auto best{m_buffers.end()};
+        for (auto it{m_buffers.begin()}; it != m_buffers.end(); ++it) {
+            if (it->capacity() < size || it->capacity() >= 2 * size) continue;
+            if (best == m_buffers.end() || it->capacity() < best->capacity()) best = it;
+        }
+        if (best != m_buffers.end()) {
+            std::vector<unsigned char> ret{std::move(*best)};
+            *best = std::move(m_buffers.back());
+            m_buffers.pop_back();
+            return ret;
+        }
+    }
+    std::vector<unsigned char> ret;
+    ret.reserve(size);
+    return ret;
+}
+
+void SendBufferPool::Put(std::vector<unsigned char>&& buf)
+{
+    std::vector<unsigned char> local{std::move(buf)};
+    buf.clear();
+    if (local.capacity() < MIN_BUFFER_CAPACITY || local.capacity() > MAX_BUFFER_CAPACITY) return;
+    local.clear();
+    LOCK(m_mutex);
+    if (m_buffers.size() < MAX_BUFFERS) m_buffers.push_back(std::move(local));
+}
+
+SendBufferPool& SendBufferPool::Instance()
+{
+    static SendBufferPool pool;
+    return pool;
+}
+
 void CConnman::AddAddrFetch(const std::string& strDest)
 {
     LOCK(m_addr_fetches_mutex);
@@ -667,6 +706,7 @@ bool CNode::ReceiveMsgBytes(Span<const uint8_t> msg_bytes, bool& complete)
                 // Message deserialization failed. Drop the message but don't disconnect the peer.
                 // store the size of the corrupt message
                 mapRecvBytesPerMsgType.at(NET_MESSAGE_TYPE_OTHER) += msg.m_raw_message_size;
+                g_msg_type_traffic.AddRecv(NET_MESSAGE_TYPE_OTHER, msg.m_raw_message_size);
                 continue;
             }
 
@@ -678,6 +718,7 @@ bool CNode::ReceiveMsgBytes(Span<const uint8_t> msg_bytes, bool& complete)
             }
             assert(i != mapRecvBytesPerMsgType.end());
             i->second += msg.m_raw_message_size;
+            g_msg_type_traffic.AddRecv(i->first, msg.m_raw_message_size);
 
             // push the message to the process queue,
             vRecvMsg.push_back(std::move(msg));
@@ -808,6 +849,13 @@ CNetMessage V1Transport::GetReceivedMessage(const std::chrono::microseconds time
     return msg;
 }
 
+std::pair<bool, const std::string&> Transport::GetBuffersToSend(bool have_next_message, std::vector<Span<const uint8_t>>& buffers) const noexcept
+{
+    const auto& [to_send, more, msg_type] = GetBytesToSend(have_next_message);
+    buffers.assign(1, to_send);
+    return {more, msg_type};
+}
+
 bool V1Transport::SetMessageToSend(CSerializedNetMsg& msg) noexcept
 {
     AssertLockNotHeld(m_send_mutex);
@@ -854,17 +902,36 @@ Transport::BytesToSend V1Transport::GetBytesToSend(bool have_next_message) const
     }
 }
 
+std::pair<bool, const std::string&> V1Transport::GetBuffersToSend(bool have_next_message, std::vector<Span<const uint8_t>>& buffers) const noexcept
+{
+    AssertLockNotHeld(m_send_mutex);
+    LOCK(m_send_mutex);
+    buffers.clear();
+    if (m_sending_header) {
+        // The payload directly follows the header, so both can go out together.
+        buffers.emplace_back(Span{m_header_to_send}.subspan(m_bytes_sent));
+        if (!m_message_to_send.data.empty()) buffers.emplace_back(m_message_to_send.data);
+    } else {
+        buffers.emplace_back(Span{m_message_to_send.data}.subspan(m_bytes_sent));
+    }
+    return {have_next_message, m_message_to_send.m_type};
+}
+
 void V1Transport::MarkBytesSent(size_t bytes_sent) noexcept
 {
     AssertLockNotHeld(m_send_mutex);
     LOCK(m_send_mutex);
     m_bytes_sent += bytes_sent;
-    if (m_sending_header && m_bytes_sent == m_header_to_send.size()) {
-        // We're done sending a message's header. Switch to sending its data bytes.
+    if (m_sending_header && m_bytes_sent >= m_header_to_send.size()) {
+        // We're done sending a message's header. Switch to sending its data bytes, some of
+        // which may already have been sent along with the header (see GetBuffersToSend).
         m_sending_header = false;
-        m_bytes_sent = 0;
-    } else if (!m_sending_header && m_bytes_sent == m_message_to_send.data.size()) {
-        // We're done sending a message's data. Wipe the data vector to reduce memory consumption.
+        m_bytes_sent -= m_header_to_send.size();
+    }
+    if (!m_sending_header && m_bytes_sent == m_message_to_send.data.size()) {
+        // We're done sending a message's data. Hand the data vector back to the pool, which
+        // either reuses its allocation or frees it.
+        SendBufferPool::Instance().Put(std::move(m_message_to_send.data));
         ClearShrink(m_message_to_send.data);
         m_bytes_sent = 0;
     }
@@ -1472,10 +1539,12 @@ bool V2Transport::SetMessageToSend(CSerializedNetMsg& msg) noexcept
         std::copy(msg.data.begin(), msg.data.end(), contents.begin() + 1 + CMessageHeader::COMMAND_SIZE);
     }
     // Construct ciphertext in send buffer.
+    m_send_buffer = SendBufferPool::Instance().Get(contents.size() + BIP324Cipher::EXPANSION);
     m_send_buffer.resize(contents.size() + BIP324Cipher::EXPANSION);
     m_cipher.Encrypt(MakeByteSpan(contents), {}, false, MakeWritableByteSpan(m_send_buffer));
     m_send_type = msg.m_type;
     // Release memory
+    SendBufferPool::Instance().Put(std::move(msg.data));
     ClearShrink(msg.data);
     return true;
 }
@@ -1497,6 +1566,16 @@ Transport::BytesToSend V2Transport::GetBytesToSend(bool have_next_message) const
     };
 }
 
+std::pair<bool, const std::string&> V2Transport::GetBuffersToSend(bool have_next_message, std::vector<Span<const uint8_t>>& buffers) const noexcept
+{
+    AssertLockNotHeld(m_send_mutex);
+    if (WITH_LOCK(m_send_mutex, return m_send_state == SendState::V1)) {
+        return m_v1_fallback.GetBuffersToSend(have_next_message, buffers);
+    }
+    // Each packet is encrypted into a single contiguous buffer.
+    return Transport::GetBuffersToSend(have_next_message, buffers);
+}
+
 void V2Transport::MarkBytesSent(size_t bytes_sent) noexcept
 {
     AssertLockNotHeld(m_send_mutex);
@@ -1515,6 +1594,7 @@ void V2Transport::MarkBytesSent(size_t bytes_sent) noexcept
     // Wipe the buffer when everything is sent.
     if (m_send_pos == m_send_buffer.size()) {
         m_send_pos = 0;
+        SendBufferPool::Instance().Put(std::move(m_send_buffer));
         ClearShrink(m_send_buffer);
     }
 }
@@ -1572,6 +1652,7 @@ std::pair<size_t, bool> CConnman::SocketSendData(CNode& node) const
     size_t nSentSize = 0;
     bool data_left{false}; //!< second return value (whether unsent data remains)
     std::optional<bool> expected_more;
+    std::vector<Span<const uint8_t>> buffers;
 
     while (true) {
         if (it != node.vSendMsg.end()) {
@@ -1585,15 +1666,19 @@ std::pair<size_t, bool> CConnman::SocketSendData(CNode& node) const
                 ++it;
             }
         }
-        const auto& [data, more, msg_type] = node.m_transport->GetBytesToSend(it != node.vSendMsg.end());
-        // We rely on the 'more' value returned by GetBytesToSend to correctly predict whether more
-        // bytes are still to be sent, to correctly set the MSG_MORE flag. As a sanity check,
+        // Gather everything the transport can hand out (for V1, a message's header and payload)
+        // so it is written with a single system call.
+        const auto& [more, msg_type] = node.m_transport->GetBuffersToSend(it != node.vSendMsg.end(), buffers);
+        size_t data_size{0};
+        for (const auto& buffer : buffers) data_size += buffer.size();
+        // We rely on the 'more' value returned by GetBuffersToSend to correctly predict whether
+        // more bytes are still to be sent, to correctly set the MSG_MORE flag. As a sanity check,
         // verify that the previously returned 'more' was correct.
-        if (expected_more.has_value()) Assume(!data.empty() == *expected_more);
+        if (expected_more.has_value()) Assume((data_size > 0) == *expected_more);
         expected_more = more;
-        data_left = !data.empty(); // will be overwritten on next loop if all of data gets sent
-        int nBytes = 0;
-        if (!data.empty()) {
+        data_left = data_size > 0; // will be overwritten on next loop if all of data gets sent
+        ssize_t nBytes = 0;
+        if (data_size > 0) {
             LOCK(node.m_sock_mutex);
             // There is no socket in case we've already disconnected, or in test cases without
             // real connections. In these cases, we bail out immediately and just leave things
@@ -1607,7 +1692,7 @@ std::pair<size_t, bool> CConnman::SocketSendData(CNode& node) const
                 flags |= MSG_MORE;
             }
 #endif
-            nBytes = node.m_sock->Send(reinterpret_cast<const char*>(data.data()), data.size(), flags);
+            nBytes = node.m_sock->SendMany(buffers, flags);
         }
         if (nBytes > 0) {
             node.m_last_send = GetTime<std::chrono::seconds>();
@@ -1619,7 +1704,7 @@ std::pair<size_t, bool> CConnman::SocketSendData(CNode& node) const
                 node.AccountForSentBytes(msg_type, nBytes);
             }
             nSentSize += nBytes;
-            if ((size_t)nBytes != data.size()) {
+            if ((size_t)nBytes != data_size) {
                 // could not send full message; stop sending more
                 break;
             }
@@ -1636,7 +1721,8 @@ std::pair<size_t, bool> CConnman::SocketSendData(CNode& node) const
         }
     }
 
-    node.fPauseSend = node.m_send_memusage + node.m_transport->GetSendMemoryUsage() > nSendBufferMaxSize;
+    node.RecordSendProgress(nSentSize, data_left, GetTime<std::chrono::microseconds>());
+    node.fPauseSend = node.m_send_memusage + node.m_transport->GetSendMemoryUsage() > node.GetSendBufferLimit(nSendBufferMaxSize);
 
     if (it == node.vSendMsg.end()) {
         assert(node.m_send_memusage == 0);
@@ -3769,6 +3855,47 @@ CNode::CNode(NodeId idIn,
     }
 }
 
+size_t MsgTypeTraffic::Index(const std::string& msg_type)
+{
+    static const std::unordered_map<std::string, size_t> indexes{[] {
+        std::unordered_map<std::string, size_t> ret;
+        for (size_t i = 0; i < ALL_NET_MESSAGE_TYPES.size(); ++i) ret.emplace(ALL_NET_MESSAGE_TYPES[i], i);
+        return ret;
+    }()};
+    const auto it{indexes.find(msg_type)};
+    return it == indexes.end() ? ALL_NET_MESSAGE_TYPES.size() : it->second;
+}
+
+void CNode::RecordSendProgress(size_t bytes_sent, bool backlogged, std::chrono::microseconds now)
+{
+    AssertLockHeld(cs_vSend);
+    if (m_send_backlogged_since) {
+        // Everything sent since the socket was last found full was limited by how fast the
+        // peer (and the path to it) accepts data.
+        m_send_window_bytes += bytes_sent;
+        m_send_window_time += std::max(now - *m_send_backlogged_since, 0us);
+        if (m_send_window_time >= SEND_RATE_WINDOW) {
+            const uint64_t sample = m_send_window_bytes * 1'000'000 / count_microseconds(m_send_window_time);
+            m_send_rate = m_send_rate ? (m_send_rate + sample) / 2 : sample;
+            m_send_window_bytes = 0;
+            m_send_window_time = 0us;
+        }
+    }
+    if (backlogged) {
+        m_send_backlogged_since = now;
+    } else {
+        m_send_backlogged_since.reset();
+    }
+}
+
+size_t CNode::GetSendBufferLimit(size_t base_limit) const
+{
+    AssertLockHeld(cs_vSend);
+    if (m_send_rate == 0) return base_limit;
+    const uint64_t target{m_send_rate * count_seconds(SEND_BUFFER_DRAIN_TARGET)};
+    return std::clamp<uint64_t>(target, base_limit / SEND_BUFFER_LIMIT_SCALE, uint64_t{base_limit} * SEND_BUFFER_LIMIT_SCALE);
+}
+
 void CNode::MarkReceivedMsgsForProcessing()
 {
     AssertLockNotHeld(m_msg_process_queue_mutex);
@@ -3822,6 +3949,8 @@ void CConnman::PushMessage(CNode* pnode, CSerializedNetMsg&& msg)
         msg.data.size(),
         msg.data.data()
     );
+    flightrecorder::Record(flightrecorder::Event::MESSAGE_SEND, nMessageSize, pnode->GetId(),
+                           flightrecorder::PackMessageType(msg.m_type));
 
     size_t nBytesSent = 0;
     {
@@ -3834,7 +3963,7 @@ void CConnman::PushMessage(CNode* pnode, CSerializedNetMsg&& msg)
 
         // Update memory usage of send buffer.
         pnode->m_send_memusage += msg.GetMemoryUsage();
-        if (pnode->m_send_memusage + pnode->m_transport->GetSendMemoryUsage() > nSendBufferMaxSize) pnode->fPauseSend = true;
+        if (pnode->m_send_memusage + pnode->m_transport->GetSendMemoryUsage() > pnode->GetSendBufferLimit(nSendBufferMaxSize)) pnode->fPauseSend = true;
         // Move message to vSendMsg queue.
         pnode->vSendMsg.push_back(std::move(msg));
 
@@ -32,6 +32,7 @@
 #include <util/sock.h>
 #include <util/threadinterrupt.h>
 
+#include <array>
 #include <atomic>
 #include <condition_variable>
 #include <cstdint>
@@ -91,6 +92,12 @@ static constexpr bool DEFAULT_DNSSEED{true};
 static constexpr bool DEFAULT_FIXEDSEEDS{true};
 static const size_t DEFAULT_MAXRECEIVEBUFFER = 5 * 1000;
 static const size_t DEFAULT_MAXSENDBUFFER    = 1 * 1000;
+/** Once a peer's send rate is known, its send buffer limit is set so that the buffer drains in this long... */
+static constexpr auto SEND_BUFFER_DRAIN_TARGET{2s};
+/** ...but kept between -maxsendbuffer divided by this factor and -maxsendbuffer multiplied by it. */
+static constexpr size_t SEND_BUFFER_LIMIT_SCALE{4};
+/** Amount of time spent waiting on a backlogged socket over which one send rate sample is taken. */
+static constexpr auto SEND_RATE_WINDOW{1s};
 
 static constexpr bool DEFAULT_V2_TRANSPORT{true};
 
@@ -134,6 +141,35 @@ struct CSerializedNetMsg {
     size_t GetMemoryUsage() const noexcept;
 };
 
+/**
+ * Recycles the byte vectors that serialized messages are built in once the transport has sent
+ * them, so that serializing the next message of a similar size reuses an allocation instead of
+ * growing a fresh vector.
+ */
+class SendBufferPool
+{
+    Mutex m_mutex;
+    std::vector<std::vector<unsigned char>> m_buffers GUARDED_BY(m_mutex);
+
+public:
+    /** Buffers with less capacity are not worth pooling. */
+    static constexpr size_t MIN_BUFFER_CAPACITY{4 * 1024};
+    /** Buffers with more capacity are freed rather than pooled. */
+    static constexpr size_t MAX_BUFFER_CAPACITY{512 * 1024};
+    static constexpr size_t MAX_BUFFERS{32};
+
+    /**
+     * Return an empty vector with capacity for at least size bytes. A pooled buffer is only
+     * handed out if its capacity is less than twice that, so that memory accounting based on
+     * capacity (e.g. for the send buffer limit) is not overly inflated.
+     */
+    std::vector<unsigned char> Get(size_t size) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    /** Return a buffer to the pool (or free it). buf is left empty. */
+    void Put(std::vector<unsigned char>&& buf) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    static SendBufferPool& Instance();
+};
+
 /**
  * Look up IP addresses from all interfaces on the machine and add them to the
  * list of local addresses to self-advertise.
@@ -181,6 +217,32 @@ extern std::map<CNetAddr, LocalServiceInfo> mapLocalHost GUARDED_BY(g_maplocalho
 extern const std::string NET_MESSAGE_TYPE_OTHER;
 using mapMsgTypeSize = std::map</* message type */ std::string, /* total bytes */ uint64_t>;
 
+/**
+ * Bytes sent and received per message type, summed over all connections.
+ * Unlike the per-connection maps this is lock-free, so it can be read
+ * without cs_vSend/cs_vRecv (e.g. by the /metrics endpoint).
+ */
+class MsgTypeTraffic
+{
+public:
+    //! One counter per entry of ALL_NET_MESSAGE_TYPES, followed by one for NET_MESSAGE_TYPE_OTHER.
+    static constexpr size_t COUNTERS{ALL_NET_MESSAGE_TYPES.size() + 1};
+
+    static size_t Index(const std::string& msg_type);
+    static const std::string& Type(size_t index) { return index < ALL_NET_MESSAGE_TYPES.size() ? ALL_NET_MESSAGE_TYPES[index] : NET_MESSAGE_TYPE_OTHER; }
+
+    void AddSent(const std::string& msg_type, uint64_t bytes) { m_sent[Index(msg_type)].fetch_add(bytes, std::memory_order_relaxed); }
+    void AddRecv(const std::string& msg_type, uint64_t bytes) { m_recv[Index(msg_type)].fetch_add(bytes, std::memory_order_relaxed); }
+    uint64_t Sent(size_t index) const { return m_sent[index].load(std::memory_order_relaxed); }
+    uint64_t Recv(size_t index) const { return m_recv[index].load(std::memory_order_relaxed); }
+
+private:
+    std::array<std::atomic<uint64_t>, COUNTERS> m_sent{};
+    std::array<std::atomic<uint64_t>, COUNTERS> m_recv{};
+};
+
+extern MsgTypeTraffic g_msg_type_traffic;
+
 class CNodeStats
 {
 public:
@@ -344,9 +406,20 @@ public:
      */
     virtual BytesToSend GetBytesToSend(bool have_next_message) const noexcept = 0;
 
+    /** Get every span of bytes that can be sent without another SetMessageToSend call.
+     *
+     * This is GetBytesToSend for callers that can write several buffers with one system call:
+     * buffers is overwritten with the to_send span, followed by whatever the transport already
+     * knows will come after it (for V1Transport, the payload after a message's header). The
+     * returned "more" and message type are as for GetBytesToSend, with "more" describing what
+     * follows after all of buffers. The default implementation returns just the to_send span.
+     */
+    virtual std::pair<bool, const std::string&> GetBuffersToSend(bool have_next_message, std::vector<Span<const uint8_t>>& buffers) const noexcept;
+
     /** Report how many bytes returned by the last GetBytesToSend() have been sent.
      *
-     * bytes_sent cannot exceed to_send.size() of the last GetBytesToSend() result.
+     * bytes_sent cannot exceed to_send.size() of the last GetBytesToSend() result, or the
+     * combined size of the buffers of the last GetBuffersToSend() result.
      *
      * If bytes_sent=0, this call has no effect.
      */
@@ -438,6 +511,7 @@ public:
 
     bool SetMessageToSend(CSerializedNetMsg& msg) noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
     BytesToSend GetBytesToSend(bool have_next_message) const noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
+    std::pair<bool, const std::string&> GetBuffersToSend(bool have_next_message, std::vector<Span<const uint8_t>>& buffers) const noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
     void MarkBytesSent(size_t bytes_sent) noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
     size_t GetSendMemoryUsage() const noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
     bool ShouldReconnectV1() const noexcept override { return false; }
@@ -648,6 +722,7 @@ public:
     // Send side functions.
     bool SetMessageToSend(CSerializedNetMsg& msg) noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
     BytesToSend GetBytesToSend(bool have_next_message) const noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
+    std::pair<bool, const std::string&> GetBuffersToSend(bool have_next_message, std::vector<Span<const uint8_t>>& buffers) const noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
     void MarkBytesSent(size_t bytes_sent) noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
     size_t GetSendMemoryUsage() const noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
 
@@ -687,6 +762,13 @@ public:
 
     /** Sum of GetMemoryUsage of all vSendMsg entries. */
     size_t m_send_memusage GUARDED_BY(cs_vSend){0};
+    /** Rate (in bytes per second) at which this peer drained a backlogged send buffer, or 0 if not yet measured. */
+    uint64_t m_send_rate GUARDED_BY(cs_vSend){0};
+    /** Time of the last send that left data behind because the socket was full. */
+    std::optional<std::chrono::microseconds> m_send_backlogged_since GUARDED_BY(cs_vSend);
+    /** Bytes sent and time spent backlogged towards the next m_send_rate sample. */
+    uint64_t m_send_window_bytes GUARDED_BY(cs_vSend){0};
+    std::chrono::microseconds m_send_window_time GUARDED_BY(cs_vSend){0};
     /** Total number of bytes sent on the wire to this peer. */
     uint64_t nSendBytes GUARDED_BY(cs_vSend){0};
     /** Messages still to be fed to m_transport->SetMessageToSend. */
@@ -735,6 +817,20 @@ public:
 
     const ConnectionType m_conn_type;
 
+    /**
+     * Account for a send attempt that wrote bytes_sent bytes, and left data unsent if
+     * backlogged. Time spent between a backlogged send and the next one is used to measure
+     * the rate at which the peer accepts data.
+     */
+    void RecordSendProgress(size_t bytes_sent, bool backlogged, std::chrono::microseconds now) EXCLUSIVE_LOCKS_REQUIRED(cs_vSend);
+
+    /**
+     * Send buffer memory usage above which fPauseSend is set. This is base_limit (from
+     * -maxsendbuffer) until the peer's send rate has been measured, and is then scaled to
+     * SEND_BUFFER_DRAIN_TARGET worth of data, within SEND_BUFFER_LIMIT_SCALE of base_limit.
+     */
+    size_t GetSendBufferLimit(size_t base_limit) const EXCLUSIVE_LOCKS_REQUIRED(cs_vSend);
+
     /** Move all messages from the received queue to the processing queue. */
     void MarkReceivedMsgsForProcessing()
         EXCLUSIVE_LOCKS_REQUIRED(!m_msg_process_queue_mutex);
@@ -752,6 +848,7 @@ public:
         EXCLUSIVE_LOCKS_REQUIRED(cs_vSend)
     {
         mapSendBytesPerMsgType[msg_type] += sent_bytes;
+        g_msg_type_traffic.AddSent(msg_type, sent_bytes);
     }
 
     bool IsOutboundOrBlockRelayConn() const {
@@ -40,6 +40,7 @@
 #include <txorphanage.h>
 #include <txrequest.h>
 #include <util/check.h>
+#include <util/flightrecorder.h>
 #include <util/strencodings.h>
 #include <util/time.h>
 #include <util/trace.h>
@@ -1015,6 +1016,9 @@ private:
     /** Have we requested this block from an outbound peer */
     bool IsBlockRequestedFromOutbound(const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+    /** An initialized compact block reconstruction of this block from a peer other than exclude, if any */
+    const PartiallyDownloadedBlock* GetCompactBlockSibling(const uint256& hash, NodeId exclude) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
     /** Remove this block from our tracked requested blocks. Called if:
      *  - the block has been received from a peer
      *  - the request for the block has timed out
@@ -1087,6 +1091,9 @@ private:
     /** Process a new block. Perform any post-processing housekeeping */
     void ProcessBlock(CNode& node, const std::shared_ptr<const CBlock>& block, bool force_processing, bool min_pow_checked);
 
+    /** Announce transactions found missing on the peer's side by a reconciliation round. */
+    void AnnounceReconciledTxs(CNode& node, Peer& peer, const std::vector<Wtxid>& wtxids);
+
     /** Process compact block txns  */
     void ProcessCompactBlockTxns(CNode& pfrom, Peer& peer, const BlockTransactions& block_transactions)
         EXCLUSIVE_LOCKS_REQUIRED(g_msgproc_mutex, !m_most_recent_block_mutex);
@@ -1307,6 +1314,17 @@ bool PeerManagerImpl::IsBlockRequestedFromOutbound(const uint256& hash)
     return false;
 }
 
+const PartiallyDownloadedBlock* PeerManagerImpl::GetCompactBlockSibling(const uint256& hash, NodeId exclude)
+{
+    for (auto range = mapBlocksInFlight.equal_range(hash); range.first != range.second; range.first++) {
+        auto [nodeid, block_it] = range.first->second;
+        if (nodeid != exclude && block_it->partialBlock && !block_it->partialBlock->header.IsNull()) {
+            return block_it->partialBlock.get();
+        }
+    }
+    return nullptr;
+}
+
 void PeerManagerImpl::RemoveBlockRequest(const uint256& hash, std::optional<NodeId> from_peer)
 {
     auto range = mapBlocksInFlight.equal_range(hash);
@@ -1926,6 +1944,27 @@ PeerManagerInfo PeerManagerImpl::GetInfo() const
     };
 }
 
+void PeerManagerImpl::AnnounceReconciledTxs(CNode& node, Peer& peer, const std::vector<Wtxid>& wtxids)
+{
+    auto tx_relay = peer.GetTxRelay();
+    if (!tx_relay || wtxids.empty()) return;
+
+    std::vector<CInv> invs;
+    LOCK(tx_relay->m_tx_inventory_mutex);
+    for (const Wtxid& wtxid : wtxids) {
+        // Gone from the mempool since it was added to the set? Don't bother announcing it.
+        if (!m_mempool.exists(GenTxid::Wtxid(wtxid))) continue;
+        if (tx_relay->m_tx_inventory_known_filter.contains(wtxid.ToUint256())) continue;
+        tx_relay->m_tx_inventory_known_filter.insert(wtxid.ToUint256());
+        invs.emplace_back(MSG_WTX, wtxid.ToUint256());
+        if (invs.size() == MAX_INV_SZ) {
+            MakeAndPushMessage(node, NetMsgType::INV, invs);
+            invs.clear();
+        }
+    }
+    if (!invs.empty()) MakeAndPushMessage(node, NetMsgType::INV, invs);
+}
+
 void PeerManagerImpl::AddToCompactExtraTransactions(const CTransactionRef& tx)
 {
     if (m_opts.max_extra_txs <= 0)
@@ -2091,8 +2130,8 @@ PeerManagerImpl::PeerManagerImpl(CConnman& connman, AddrMan& addrman,
       m_warnings{warnings},
       m_opts{opts}
 {
-    // While Erlay support is incomplete, it must be enabled explicitly via -txreconciliation.
-    // This argument can go away after Erlay support is complete.
+    // Erlay is still experimental (no sketch extension rounds yet), so it must be enabled
+    // explicitly via -txreconciliation.
     if (opts.reconcile_txs) {
         m_txreconciliation = std::make_unique<TxReconciliationTracker>(TXRECONCILIATION_VERSION);
     }
@@ -3691,6 +3730,16 @@ void PeerManagerImpl::ProcessCompactBlockTxns(CNode& pfrom, Peer& peer, const Bl
             // updated, etc.
             RemoveBlockRequest(block_transactions.blockhash, pfrom.GetId()); // it is now an empty pointer
             fBlockRead = true;
+            // The transactions we had to request were missing from our mempool.
+            // Keep them in the extra pool so a competing block (or another
+            // announcement of this one) including them reconstructs without a
+            // round trip. Large requests are skipped so they don't flush the
+            // orphan and conflict entries already kept there.
+            if (status == READ_STATUS_OK && block_transactions.txn.size() <= m_opts.max_extra_txs / 2) {
+                for (const CTransactionRef& tx : block_transactions.txn) {
+                    AddToCompactExtraTransactions(tx);
+                }
+            }
             // mapBlockSource is used for potentially punishing peers and
             // updating which peers send us compact blocks, so the race
             // between here and cs_main in ProcessNewBlock is fine.
@@ -4272,6 +4321,10 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
                 LogPrint(BCLog::NET, "got inv: %s  %s peer=%d\n", inv.ToString(), fAlreadyHave ? "have" : "new", pfrom.GetId());
 
                 AddKnownTx(*peer, inv.hash);
+                // No need to reconcile a transaction the peer already has.
+                if (m_txreconciliation && inv.IsMsgWtx()) {
+                    m_txreconciliation->TryRemovingFromSet(pfrom.GetId(), Wtxid::FromUint256(inv.hash));
+                }
                 if (!fAlreadyHave && !m_chainman.IsInitialBlockDownload()) {
                     AddTxAnnouncement(pfrom, gtxid, current_time);
                 }
@@ -4562,6 +4615,7 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
 
         const uint256& hash = peer->m_wtxid_relay ? wtxid : txid;
         AddKnownTx(*peer, hash);
+        if (m_txreconciliation) m_txreconciliation->TryRemovingFromSet(pfrom.GetId(), ptx->GetWitnessHash());
 
         LOCK2(cs_main, m_tx_download_mutex);
 
@@ -4853,7 +4907,8 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
                 }
 
                 PartiallyDownloadedBlock& partialBlock = *(*queuedBlockIt)->partialBlock;
-                ReadStatus status = partialBlock.InitData(cmpctblock, vExtraTxnForCompact);
+                ReadStatus status = partialBlock.InitData(cmpctblock, vExtraTxnForCompact,
+                                                          GetCompactBlockSibling(pindex->GetBlockHash(), pfrom.GetId()));
                 if (status == READ_STATUS_INVALID) {
                     RemoveBlockRequest(pindex->GetBlockHash(), pfrom.GetId()); // Reset in-flight state in case Misbehaving does not result in a disconnect
                     Misbehaving(*peer, "invalid compact block");
@@ -4904,7 +4959,8 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
                 // Optimistically try to reconstruct anyway since we might be
                 // able to without any round trips.
                 PartiallyDownloadedBlock tempBlock(&m_mempool);
-                ReadStatus status = tempBlock.InitData(cmpctblock, vExtraTxnForCompact);
+                ReadStatus status = tempBlock.InitData(cmpctblock, vExtraTxnForCompact,
+                                                       GetCompactBlockSibling(pindex->GetBlockHash(), pfrom.GetId()));
                 if (status != READ_STATUS_OK) {
                     // TODO: don't ignore failures
                     return;
@@ -5289,6 +5345,56 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
         return;
     }
 
+    if (msg_type == NetMsgType::REQRECON) {
+        if (!m_txreconciliation || !m_txreconciliation->IsPeerRegistered(pfrom.GetId())) {
+            LogPrint(BCLog::NET, "reqrecon received from peer=%d not registered for txreconciliation; ignoring\n", pfrom.GetId());
+            return;
+        }
+        uint16_t peer_set_size, peer_q;
+        vRecv >> peer_set_size >> peer_q;
+        if (!m_txreconciliation->HandleReconciliationRequest(pfrom.GetId(), peer_set_size, peer_q)) {
+            LogPrintLevel(BCLog::NET, BCLog::Level::Debug, "txreconciliation protocol violation from peer=%d (unexpected reqrecon); disconnecting\n", pfrom.GetId());
+            pfrom.fDisconnect = true;
+        }
+        return;
+    }
+
+    if (msg_type == NetMsgType::SKETCH) {
+        if (!m_txreconciliation || !m_txreconciliation->IsPeerRegistered(pfrom.GetId())) {
+            LogPrint(BCLog::NET, "sketch received from peer=%d not registered for txreconciliation; ignoring\n", pfrom.GetId());
+            return;
+        }
+        std::vector<uint8_t> skdata;
+        vRecv >> skdata;
+        const auto result{m_txreconciliation->HandleSketch(pfrom.GetId(), skdata)};
+        if (!result) {
+            LogPrintLevel(BCLog::NET, BCLog::Level::Debug, "txreconciliation protocol violation from peer=%d (unexpected or oversized sketch); disconnecting\n", pfrom.GetId());
+            pfrom.fDisconnect = true;
+            return;
+        }
+        MakeAndPushMessage(pfrom, NetMsgType::RECONCILDIFF, uint8_t{result->success}, result->txs_to_request);
+        AnnounceReconciledTxs(pfrom, *peer, result->txs_to_announce);
+        return;
+    }
+
+    if (msg_type == NetMsgType::RECONCILDIFF) {
+        if (!m_txreconciliation || !m_txreconciliation->IsPeerRegistered(pfrom.GetId())) {
+            LogPrint(BCLog::NET, "reconcildiff received from peer=%d not registered for txreconciliation; ignoring\n", pfrom.GetId());
+            return;
+        }
+        uint8_t success;
+        std::vector<uint32_t> ask_shortids;
+        vRecv >> success >> ask_shortids;
+        const auto to_announce{m_txreconciliation->HandleReconciliationDifference(pfrom.GetId(), success != 0, ask_shortids)};
+        if (!to_announce) {
+            LogPrintLevel(BCLog::NET, BCLog::Level::Debug, "txreconciliation protocol violation from peer=%d (unexpected reconcildiff); disconnecting\n", pfrom.GetId());
+            pfrom.fDisconnect = true;
+            return;
+        }
+        AnnounceReconciledTxs(pfrom, *peer, *to_announce);
+        return;
+    }
+
     if (msg_type == NetMsgType::FEEFILTER) {
         CAmount newFeeFilter = 0;
         vRecv >> newFeeFilter;
@@ -5429,6 +5535,8 @@ bool PeerManagerImpl::ProcessMessages(CNode* pfrom, std::atomic<bool>& interrupt
         msg.m_recv.size(),
         msg.m_recv.data()
     );
+    flightrecorder::Record(flightrecorder::Event::MESSAGE_RECV, msg.m_recv.size(), pfrom->GetId(),
+                           flightrecorder::PackMessageType(msg.m_type));
 
     if (m_opts.capture_messages) {
         CaptureMessage(pfrom->addr, msg.m_type, MakeUCharSpan(msg.m_recv), /*is_incoming=*/true);
@@ -6214,6 +6322,12 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
                             continue;
                         }
                         if (tx_relay->m_bloom_filter && !tx_relay->m_bloom_filter->IsRelevantAndUpdate(*txinfo.tx)) continue;
+                        // Inbound peers we reconcile with learn about it in the next reconciliation
+                        // round, unless their set is full.
+                        if (m_txreconciliation && inv.IsMsgWtx() &&
+                            m_txreconciliation->AddToSet(pto->GetId(), Wtxid::FromUint256(hash))) {
+                            continue;
+                        }
                         // Send
                         vInv.push_back(inv);
                         nRelayedTransactions++;
@@ -6224,7 +6338,16 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
                         tx_relay->m_tx_inventory_known_filter.insert(hash);
                     }
 
+                    // Answer a pending reconciliation request along with our other announcements,
+                    // so the sketch timing reveals no more than an inv would.
+                    if (m_txreconciliation) {
+                        if (auto skdata{m_txreconciliation->RespondToReconciliationRequest(pto->GetId(), current_time)}) {
+                            MakeAndPushMessage(*pto, NetMsgType::SKETCH, *skdata);
+                        }
+                    }
+
                     // Ensure we'll respond to GETDATA requests for anything we've just announced
+                    // (or added to a reconciliation set)
                     LOCK(m_mempool.cs);
                     tx_relay->m_last_inv_sequence = m_mempool.GetSequence();
                 }
@@ -6232,6 +6355,20 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
         if (!vInv.empty())
             MakeAndPushMessage(*pto, NetMsgType::INV, vInv);
 
+        //
+        // Message: reqrecon
+        //
+        if (m_txreconciliation) {
+            if (m_txreconciliation->HasRoundTimedOut(pto->GetId(), current_time)) {
+                LogPrint(BCLog::NET, "Peer=%d did not answer in a transaction reconciliation round, disconnecting\n", pto->GetId());
+                pto->fDisconnect = true;
+                return true;
+            }
+            if (const auto request{m_txreconciliation->InitiateReconciliationRequest(pto->GetId(), current_time)}) {
+                MakeAndPushMessage(*pto, NetMsgType::REQRECON, request->first, request->second);
+            }
+        }
+
         // Detect whether we're stalling
         auto stalling_timeout = m_block_stalling_timeout.load();
         if (state.m_stalling_since.count() && state.m_stalling_since < current_time - stalling_timeout) {
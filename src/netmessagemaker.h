@@ -7,14 +7,32 @@
 #define BITCOIN_NETMESSAGEMAKER_H
 
 #include <net.h>
+#include <protocol.h>
 #include <serialize.h>
 
+#include <string_view>
+
 namespace NetMsg {
+    /**
+     * Whether to size a payload before serializing it, to take a buffer from SendBufferPool.
+     * Sizing walks the whole payload, which is not worth it for blocks and transactions:
+     * they are rarely within the pool's size range.
+     */
+    inline bool SizeBeforeSerializing(std::string_view msg_type)
+    {
+        return msg_type != NetMsgType::BLOCK && msg_type != NetMsgType::BLOCKTXN && msg_type != NetMsgType::TX;
+    }
+
     template <typename... Args>
     CSerializedNetMsg Make(std::string msg_type, Args&&... args)
     {
         CSerializedNetMsg msg;
         msg.m_type = std::move(msg_type);
+        if (SizeBeforeSerializing(msg.m_type)) {
+            // Size the buffer up front (reusing a pooled one if possible) instead of growing it
+            // while serializing.
+            msg.data = SendBufferPool::Instance().Get((GetSerializeSize(args) + ... + 0));
+        }
         VectorWriter{msg.data, 0, std::forward<Args>(args)...};
         return msg;
     }
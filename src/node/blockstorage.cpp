@@ -8,6 +8,8 @@
 #include <chain.h>
 #include <consensus/params.h>
 #include <consensus/validation.h>
+#include <crypto/common.h>
+#include <crypto/sha256.h>
 #include <dbwrapper.h>
 #include <flatfile.h>
 #include <hash.h>
@@ -31,26 +33,129 @@
 #include <util/batchpriority.h>
 #include <util/check.h>
 #include <util/fs.h>
+#include <util/fs_helpers.h>
 #include <util/signalinterrupt.h>
 #include <util/strencodings.h>
+#include <util/syserror.h>
 #include <util/translation.h>
 #include <validation.h>
 
+#include <cerrno>
+#include <cstring>
 #include <map>
 #include <ranges>
 #include <unordered_map>
 
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace kernel {
 static constexpr uint8_t DB_BLOCK_FILES{'f'};
 static constexpr uint8_t DB_BLOCK_INDEX{'b'};
 static constexpr uint8_t DB_FLAG{'F'};
 static constexpr uint8_t DB_REINDEX_FLAG{'R'};
 static constexpr uint8_t DB_LAST_BLOCK{'l'};
+static constexpr uint8_t DB_BLOCK_INDEX_SNAPSHOT{'S'};
 // Keys used in previous version that might still be found in the DB:
 // BlockTreeDB::DB_TXINDEX_BLOCK{'T'};
 // BlockTreeDB::DB_TXINDEX{'t'}
 // BlockTreeDB::ReadFlag("txindex")
 
+namespace {
+/*
+ * Block index snapshot file format, all integers little-endian:
+ * - 8 bytes magic, 4 bytes format version, 4 bytes record size
+ * - 8 bytes snapshot id, matching the DB_BLOCK_INDEX_SNAPSHOT entry of the database
+ * - 8 bytes record count, 32 bytes SHA256 of the records
+ * - the records: block hash, previous block hash and merkle root, followed by
+ *   nHeight, nFile, nDataPos, nUndoPos, nVersion, nTime, nBits, nNonce, nStatus
+ *   and nTx as 32-bit integers
+ */
+constexpr char SNAPSHOT_MAGIC[8]{'K', 'R', 'B', 'I', 'D', 'X', 'S', 'N'};
+constexpr uint32_t SNAPSHOT_VERSION{1};
+constexpr size_t SNAPSHOT_HEADER_SIZE{64};
+constexpr size_t SNAPSHOT_RECORD_SIZE{3 * 32 + 10 * 4};
+
+fs::path BlockIndexSnapshotPath(const fs::path& db_path)
+{
+    return fs::path{db_path} += ".snapshot";
+}
+
+void WriteSnapshotRecord(const CBlockIndex& index, unsigned char* out)
+{
+    const uint256 hash_prev{index.pprev ? index.pprev->GetBlockHash() : uint256{}};
+    std::memcpy(out, index.GetBlockHash().data(), 32);
+    std::memcpy(out + 32, hash_prev.data(), 32);
+    std::memcpy(out + 64, index.hashMerkleRoot.data(), 32);
+    // Only what CDiskBlockIndex stores, so that both sources load the same index
+    const bool have_data{(index.nStatus & BLOCK_HAVE_DATA) != 0};
+    const bool have_undo{(index.nStatus & BLOCK_HAVE_UNDO) != 0};
+    WriteLE32(out + 96, index.nHeight);
+    WriteLE32(out + 100, have_data || have_undo ? index.nFile : 0);
+    WriteLE32(out + 104, have_data ? index.nDataPos : 0);
+    WriteLE32(out + 108, have_undo ? index.nUndoPos : 0);
+    WriteLE32(out + 112, index.nVersion);
+    WriteLE32(out + 116, index.nTime);
+    WriteLE32(out + 120, index.nBits);
+    WriteLE32(out + 124, index.nNonce);
+    WriteLE32(out + 128, index.nStatus);
+    WriteLE32(out + 132, index.nTx);
+}
+
+/** A file mapped read-only into memory, or read into it where mapping is not supported. */
+class MappedFile
+{
+    Span<const unsigned char> m_data;
+#ifdef WIN32
+    std::vector<unsigned char> m_memory;
+#endif
+
+public:
+    explicit MappedFile(const fs::path& path)
+    {
+#ifdef WIN32
+        AutoFile file{fsbridge::fopen(path, "rb")};
+        if (file.IsNull()) return;
+        try {
+            m_memory.resize(fs::file_size(path));
+            file.read(MakeWritableByteSpan(m_memory));
+            m_data = m_memory;
+        } catch (const std::exception&) {
+            m_memory.clear();
+        }
+#else
+        const int fd{open(fs::PathToString(path).c_str(), O_RDONLY)};
+        if (fd == -1) return;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* base{mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)};
+            if (base != MAP_FAILED) {
+                posix_madvise(base, st.st_size, POSIX_MADV_SEQUENTIAL);
+                m_data = {static_cast<const unsigned char*>(base), static_cast<size_t>(st.st_size)};
+            }
+        }
+        close(fd);
+#endif
+    }
+
+    ~MappedFile()
+    {
+#ifndef WIN32
+        if (!m_data.empty()) munmap(const_cast<unsigned char*>(m_data.data()), m_data.size());
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    Span<const unsigned char> Data() const { return m_data; }
+};
+} // namespace
+
 bool BlockTreeDB::ReadBlockFileInfo(int nFile, CBlockFileInfo& info)
 {
     return Read(std::make_pair(DB_BLOCK_FILES, nFile), info);
@@ -85,9 +190,61 @@ bool BlockTreeDB::WriteBatchSync(const std::vector<std::pair<int, const CBlockFi
     for (const CBlockIndex* bi : blockinfo) {
         batch.Write(std::make_pair(DB_BLOCK_INDEX, bi->GetBlockHash()), CDiskBlockIndex{bi});
     }
+    // The block index snapshot, if any, no longer matches the database.
+    batch.Erase(DB_BLOCK_INDEX_SNAPSHOT);
     return WriteBatch(batch, true);
 }
 
+bool BlockTreeDB::WriteBlockIndexSnapshot(const std::vector<const CBlockIndex*>& blockinfo)
+{
+    const auto db_path{StoragePath()};
+    if (!db_path) return false;
+    // Nothing was written since the last snapshot.
+    if (Exists(DB_BLOCK_INDEX_SNAPSHOT)) return true;
+
+    const fs::path path{BlockIndexSnapshotPath(*db_path)};
+    const fs::path tmp_path{fs::path{path} += ".new"};
+    const uint64_t id{FastRandomContext{}.rand64()};
+    try {
+        AutoFile file{fsbridge::fopen(tmp_path, "wb")};
+        if (file.IsNull()) {
+            LogError("%s: unable to create %s\n", __func__, fs::PathToString(tmp_path));
+            return false;
+        }
+        std::array<unsigned char, SNAPSHOT_HEADER_SIZE> header{};
+        file.write(MakeByteSpan(header));
+        CSHA256 hasher;
+        std::array<unsigned char, SNAPSHOT_RECORD_SIZE> record;
+        for (const CBlockIndex* bi : blockinfo) {
+            WriteSnapshotRecord(*bi, record.data());
+            hasher.Write(record.data(), record.size());
+            file.write(MakeByteSpan(record));
+        }
+
+        std::memcpy(header.data(), SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+        WriteLE32(header.data() + 8, SNAPSHOT_VERSION);
+        WriteLE32(header.data() + 12, SNAPSHOT_RECORD_SIZE);
+        WriteLE64(header.data() + 16, id);
+        WriteLE64(header.data() + 24, blockinfo.size());
+        hasher.Finalize(header.data() + 32);
+        file.seek(0, SEEK_SET);
+        file.write(MakeByteSpan(header));
+        if (!file.Commit() || file.fclose() != 0) {
+            LogError("%s: unable to write %s\n", __func__, fs::PathToString(tmp_path));
+            return false;
+        }
+    } catch (const std::exception& e) {
+        LogError("%s: unable to write %s: %s\n", __func__, fs::PathToString(tmp_path), e.what());
+        return false;
+    }
+    if (!RenameOver(tmp_path, path)) {
+        LogError("%s: unable to rename %s\n", __func__, fs::PathToString(tmp_path));
+        return false;
+    }
+    DirectoryCommit(path.parent_path());
+    return Write(DB_BLOCK_INDEX_SNAPSHOT, id, /*fSync=*/true);
+}
+
 bool BlockTreeDB::WriteFlag(const std::string& name, bool fValue)
 {
     return Write(std::make_pair(DB_FLAG, name), fValue ? uint8_t{'1'} : uint8_t{'0'});
@@ -106,6 +263,8 @@ bool BlockTreeDB::ReadFlag(const std::string& name, bool& fValue)
 bool BlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex, const util::SignalInterrupt& interrupt)
 {
     AssertLockHeld(::cs_main);
+    if (const auto loaded{LoadBlockIndexSnapshot(consensusParams, insertBlockIndex, interrupt)}) return *loaded;
+
     std::unique_ptr<CDBIterator> pcursor(NewIterator());
     pcursor->Seek(std::make_pair(DB_BLOCK_INDEX, uint256()));
 
@@ -148,6 +307,60 @@ bool BlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams, s
 
     return true;
 }
+
+std::optional<bool> BlockTreeDB::LoadBlockIndexSnapshot(const Consensus::Params& consensusParams, const std::function<CBlockIndex*(const uint256&)>& insertBlockIndex, const util::SignalInterrupt& interrupt)
+{
+    AssertLockHeld(::cs_main);
+    const auto db_path{StoragePath()};
+    uint64_t id;
+    if (!db_path || !Read(DB_BLOCK_INDEX_SNAPSHOT, id)) return std::nullopt;
+
+    const fs::path path{BlockIndexSnapshotPath(*db_path)};
+    const MappedFile file{path};
+    const Span<const unsigned char> data{file.Data()};
+    // Check the whole file before inserting anything, so that a bad one falls back to the database.
+    const bool valid{[&] {
+        if (data.size() < SNAPSHOT_HEADER_SIZE || std::memcmp(data.data(), SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) return false;
+        if (ReadLE32(data.data() + 8) != SNAPSHOT_VERSION || ReadLE32(data.data() + 12) != SNAPSHOT_RECORD_SIZE) return false;
+        if (ReadLE64(data.data() + 16) != id) return false;
+        const uint64_t count{ReadLE64(data.data() + 24)};
+        if (count != (data.size() - SNAPSHOT_HEADER_SIZE) / SNAPSHOT_RECORD_SIZE || (data.size() - SNAPSHOT_HEADER_SIZE) % SNAPSHOT_RECORD_SIZE != 0) return false;
+        uint256 checksum;
+        CSHA256().Write(data.data() + SNAPSHOT_HEADER_SIZE, data.size() - SNAPSHOT_HEADER_SIZE).Finalize(checksum.begin());
+        return std::memcmp(checksum.data(), data.data() + 32, 32) == 0;
+    }()};
+    if (!valid) {
+        LogPrintf("Block index snapshot %s is missing or does not match the database, loading from the database\n", fs::PathToString(path));
+        // Write a fresh one at the next shutdown.
+        Erase(DB_BLOCK_INDEX_SNAPSHOT);
+        return std::nullopt;
+    }
+
+    for (const unsigned char* record{data.data() + SNAPSHOT_HEADER_SIZE}; record < data.data() + data.size(); record += SNAPSHOT_RECORD_SIZE) {
+        if (interrupt) return false;
+        // Construct block index object
+        CBlockIndex* pindexNew = insertBlockIndex(uint256{Span{record, 32}});
+        pindexNew->pprev          = insertBlockIndex(uint256{Span{record + 32, 32}});
+        pindexNew->hashMerkleRoot = uint256{Span{record + 64, 32}};
+        pindexNew->nHeight        = ReadLE32(record + 96);
+        pindexNew->nFile          = ReadLE32(record + 100);
+        pindexNew->nDataPos       = ReadLE32(record + 104);
+        pindexNew->nUndoPos       = ReadLE32(record + 108);
+        pindexNew->nVersion       = ReadLE32(record + 112);
+        pindexNew->nTime          = ReadLE32(record + 116);
+        pindexNew->nBits          = ReadLE32(record + 120);
+        pindexNew->nNonce         = ReadLE32(record + 124);
+        pindexNew->nStatus        = ReadLE32(record + 128);
+        pindexNew->nTx            = ReadLE32(record + 132);
+
+        if (!CheckProofOfWork(pindexNew->GetBlockHash(), pindexNew->nBits, consensusParams)) {
+            LogError("%s: CheckProofOfWork failed: %s\n", __func__, pindexNew->ToString());
+            return false;
+        }
+    }
+    LogPrintf("Loaded %u block index entries from snapshot %s\n", (data.size() - SNAPSHOT_HEADER_SIZE) / SNAPSHOT_RECORD_SIZE, fs::PathToString(path));
+    return true;
+}
 } // namespace kernel
 
 namespace node {
@@ -495,6 +708,17 @@ bool BlockManager::WriteBlockIndexDB()
     return true;
 }
 
+bool BlockManager::WriteBlockIndexSnapshot()
+{
+    AssertLockHeld(::cs_main);
+    // The snapshot must hold exactly what the database does.
+    if (!m_block_index_loaded || !m_dirty_blockindex.empty() || !m_dirty_fileinfo.empty()) return false;
+    std::vector<const CBlockIndex*> blockinfo;
+    blockinfo.reserve(m_block_index.size());
+    for (const auto& [_, index] : m_block_index) blockinfo.push_back(&index);
+    return m_block_tree_db->WriteBlockIndexSnapshot(blockinfo);
+}
+
 bool BlockManager::LoadBlockIndexDB(const std::optional<uint256>& snapshot_blockhash)
 {
     if (!LoadBlockIndex(snapshot_blockhash)) {
@@ -554,6 +778,7 @@ bool BlockManager::LoadBlockIndexDB(const std::optional<uint256>& snapshot_block
     m_block_tree_db->ReadReindexing(fReindexing);
     if (fReindexing) m_blockfiles_indexed = false;
 
+    m_block_index_loaded = true;
     return true;
 }
 
@@ -60,6 +60,17 @@ public:
     bool ReadFlag(const std::string& name, bool& fValue);
     bool LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex, const util::SignalInterrupt& interrupt)
         EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+    /**
+     * Write blockinfo, which must be every block index entry in the database, to a
+     * binary snapshot file next to it. LoadBlockIndexGuts maps the snapshot instead of
+     * iterating the database until the next WriteBatchSync.
+     */
+    bool WriteBlockIndexSnapshot(const std::vector<const CBlockIndex*>& blockinfo);
+
+private:
+    //! Load the block index from the snapshot, or return std::nullopt if there is no usable one.
+    std::optional<bool> LoadBlockIndexSnapshot(const Consensus::Params& consensusParams, const std::function<CBlockIndex*(const uint256&)>& insertBlockIndex, const util::SignalInterrupt& interrupt)
+        EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 };
 } // namespace kernel
 
@@ -248,6 +259,9 @@ private:
     /** Dirty block file entries. */
     std::set<int> m_dirty_fileinfo;
 
+    /** Whether m_block_index holds the whole block index database, so that it may be snapshotted. */
+    bool m_block_index_loaded GUARDED_BY(::cs_main){false};
+
     /**
      * Map from external index name to oldest block that must not be pruned.
      *
@@ -306,6 +320,8 @@ public:
     std::unique_ptr<BlockTreeDB> m_block_tree_db GUARDED_BY(::cs_main);
 
     bool WriteBlockIndexDB() EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+    /** Snapshot the block index for a fast load at the next startup. Requires it to be flushed. */
+    bool WriteBlockIndexSnapshot() EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
     bool LoadBlockIndexDB(const std::optional<uint256>& snapshot_blockhash)
         EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 
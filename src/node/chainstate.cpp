@@ -46,6 +46,8 @@ static ChainstateLoadResult CompleteChainstateInitialization(
         .cache_bytes = static_cast<size_t>(cache_sizes.block_tree_db),
         .memory_only = options.block_tree_db_in_memory,
         .wipe_data = options.wipe_block_tree_db,
+        // Read in full at startup, and otherwise mostly written to.
+        .tuning = {.bloom_filter = false, .block_size = 16 << 10},
         .options = chainman.m_options.block_tree_db});
 
     if (options.wipe_block_tree_db) {
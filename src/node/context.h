@@ -40,6 +40,7 @@ class SignalInterrupt;
 
 namespace node {
 class KernelNotifications;
+class MempoolProjectionCache;
 class Warnings;
 
 //! NodeContext struct containing references to chain state and connection
@@ -63,6 +64,7 @@ struct NodeContext {
     std::unique_ptr<AddrMan> addrman;
     std::unique_ptr<CConnman> connman;
     std::unique_ptr<CTxMemPool> mempool;
+    std::unique_ptr<MempoolProjectionCache> mempool_projection;
     std::unique_ptr<const NetGroupManager> netgroupman;
     std::unique_ptr<CBlockPolicyEstimator> fee_estimator;
     std::unique_ptr<PeerManager> peerman;
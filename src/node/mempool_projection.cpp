@@ -0,0 +1,210 @@
+// Copyright (c) 2024 The Krepto core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/mempool_projection.h>
+
+#include <consensus/consensus.h>
+#include <node/miner.h>
+#include <node/types.h>
+#include <policy/policy.h>
+#include <sync.h>
+#include <txmempool.h>
+#include <util/check.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace node {
+namespace {
+
+/** Virtual size available to mempool transactions in one projected block. */
+constexpr int64_t PROJECTED_BLOCK_VSIZE{
+    static_cast<int64_t>(DEFAULT_BLOCK_MAX_WEIGHT - BlockCreateOptions{}.coinbase_max_additional_weight) / WITNESS_SCALE_FACTOR};
+
+/** Package feerate and vsize of one projected transaction, and the block it was put in. */
+struct ProjectedTx {
+    CFeeRate rate;
+    int64_t vsize;
+    size_t block;
+};
+
+void AddTx(ProjectedBlock& block, std::vector<ProjectedTx>& txs, const CTxMemPoolEntry& entry, const CFeeRate& package_rate, size_t block_index)
+{
+    const int64_t vsize{entry.GetTxSize()};
+    block.vsize += vsize;
+    block.weight += entry.GetTxWeight();
+    block.fees += entry.GetModifiedFee();
+    ++block.tx_count;
+    txs.push_back({package_rate, vsize, block_index});
+
+    const int64_t sat_per_vb{package_rate.GetFeePerK() / 1000};
+    const auto bucket{std::upper_bound(PROJECTION_FEERATE_BUCKETS.begin(), PROJECTION_FEERATE_BUCKETS.end(), sat_per_vb)};
+    block.feerate_histogram[std::max<ptrdiff_t>(0, bucket - PROJECTION_FEERATE_BUCKETS.begin() - 1)] += vsize;
+}
+
+/** Merge the totals of from into into. Feerates are left to SetFeerates. */
+void MergeInto(ProjectedBlock& into, const ProjectedBlock& from)
+{
+    into.vsize += from.vsize;
+    into.weight += from.weight;
+    into.fees += from.fees;
+    into.tx_count += from.tx_count;
+    for (size_t i{0}; i < into.feerate_histogram.size(); ++i) {
+        into.feerate_histogram[i] += from.feerate_histogram[i];
+    }
+}
+
+/** Set the min, median and max feerate of block from the transactions in
+ *  sorted_txs (ascending by feerate) whose block index is in [first, last]. */
+void SetFeerates(ProjectedBlock& block, const std::vector<ProjectedTx>& sorted_txs, size_t first, size_t last)
+{
+    int64_t seen{0};
+    bool have_median{false};
+    for (const ProjectedTx& tx : sorted_txs) {
+        if (tx.block < first || tx.block > last) continue;
+        if (seen == 0) block.min_feerate = tx.rate;
+        block.max_feerate = tx.rate;
+        seen += tx.vsize;
+        if (!have_median && 2 * seen >= block.vsize) {
+            block.median_feerate = tx.rate;
+            have_median = true;
+        }
+    }
+}
+
+} // namespace
+
+MempoolProjection ProjectBlocks(const CTxMemPool& mempool, size_t max_blocks)
+{
+    MempoolProjection ret;
+    ret.computed_at = SteadyClock::now();
+    if (max_blocks == 0) return ret;
+
+    LOCK(mempool.cs);
+    ret.mempool_sequence = mempool.GetSequence();
+    ret.fee_delta_version = mempool.GetFeeDeltaVersion();
+
+    // Same selection loop as BlockAssembler::addPackageTxs, except that
+    // packages which do not fit in the current block close it and start the
+    // next one. Once the last block is reached the order no longer matters,
+    // so selection stops and everything that is left goes into it.
+    indexed_modified_transaction_set modified;
+    CTxMemPool::setEntries included;
+    std::vector<ProjectedTx> txs;
+    txs.reserve(mempool.size());
+    ProjectedBlock block;
+
+    const auto& by_score{mempool.mapTx.get<ancestor_score>()};
+    auto mi{by_score.begin()};
+    while (ret.blocks.size() + 1 < max_blocks && (mi != by_score.end() || !modified.empty())) {
+        if (mi != by_score.end()) {
+            auto it{mempool.mapTx.project<0>(mi)};
+            if (modified.count(it) || included.count(it)) {
+                ++mi;
+                continue;
+            }
+        }
+
+        CTxMemPool::txiter iter;
+        bool using_modified{false};
+        modtxscoreiter modit{modified.get<ancestor_score>().begin()};
+        if (mi == by_score.end()) {
+            iter = modit->iter;
+            using_modified = true;
+        } else {
+            iter = mempool.mapTx.project<0>(mi);
+            if (modit != modified.get<ancestor_score>().end() &&
+                CompareTxMemPoolEntryByAncestorFee()(*modit, CTxMemPoolModifiedEntry(iter))) {
+                iter = modit->iter;
+                using_modified = true;
+            } else {
+                ++mi;
+            }
+        }
+
+        const int64_t package_size = using_modified ? modit->nSizeWithAncestors : iter->GetSizeWithAncestors();
+        const CAmount package_fees = using_modified ? modit->nModFeesWithAncestors : iter->GetModFeesWithAncestors();
+        const CFeeRate package_rate{package_fees, static_cast<uint32_t>(package_size)};
+
+        if (block.vsize + package_size > PROJECTED_BLOCK_VSIZE && block.tx_count > 0) {
+            ret.blocks.push_back(std::exchange(block, {}));
+            // iter is not included yet and is picked up below.
+            if (ret.blocks.size() + 1 == max_blocks) break;
+        }
+
+        auto package{mempool.AssumeCalculateMemPoolAncestors(__func__, *iter, CTxMemPool::Limits::NoLimits(), /*fSearchForParents=*/false)};
+        for (auto a{package.begin()}; a != package.end();) {
+            a = included.count(*a) ? package.erase(a) : std::next(a);
+        }
+        package.insert(iter);
+
+        for (CTxMemPool::txiter tx : package) {
+            AddTx(block, txs, *tx, package_rate, ret.blocks.size());
+            included.insert(tx);
+            modified.erase(tx);
+        }
+
+        for (CTxMemPool::txiter tx : package) {
+            CTxMemPool::setEntries descendants;
+            mempool.CalculateDescendants(tx, descendants);
+            for (CTxMemPool::txiter desc : descendants) {
+                if (included.count(desc)) continue;
+                modtxiter mit{modified.find(desc)};
+                if (mit == modified.end()) {
+                    mit = modified.insert(CTxMemPoolModifiedEntry(desc)).first;
+                }
+                modified.modify(mit, update_for_parent_inclusion(tx));
+            }
+        }
+    }
+
+    // The last block: every transaction not selected above, at its ancestor
+    // feerate net of ancestors that are already in earlier blocks.
+    for (auto it{mempool.mapTx.begin()}; it != mempool.mapTx.end(); ++it) {
+        if (included.count(it)) continue;
+        const auto mit{modified.find(it)};
+        const CFeeRate rate{mit != modified.end() ?
+                                CFeeRate{mit->nModFeesWithAncestors, static_cast<uint32_t>(mit->nSizeWithAncestors)} :
+                                CFeeRate{it->GetModFeesWithAncestors(), static_cast<uint32_t>(it->GetSizeWithAncestors())}};
+        AddTx(block, txs, *it, rate, ret.blocks.size());
+    }
+    if (block.tx_count > 0) ret.blocks.push_back(std::move(block));
+    if (ret.blocks.empty()) return ret;
+
+    // remainders[i] is blocks[i..] merged, so that a caller asking for i + 1
+    // blocks gets exact feerate statistics for its last one.
+    std::sort(txs.begin(), txs.end(), [](const ProjectedTx& a, const ProjectedTx& b) { return a.rate < b.rate; });
+    const size_t last{ret.blocks.size() - 1};
+    ret.remainders.resize(ret.blocks.size());
+    for (size_t i{last + 1}; i-- > 0;) {
+        SetFeerates(ret.blocks[i], txs, i, i);
+        ret.remainders[i] = ret.blocks[i];
+        if (i < last) {
+            MergeInto(ret.remainders[i], ret.remainders[i + 1]);
+            SetFeerates(ret.remainders[i], txs, i, last);
+        }
+    }
+    return ret;
+}
+
+std::shared_ptr<const MempoolProjection> MempoolProjectionCache::Get()
+{
+    // m_mutex and mempool.cs are never held together, so this may be called
+    // with or without mempool.cs held. Concurrent callers that find the cache
+    // stale may each compute a projection; the last one to finish is kept.
+    const auto [sequence, fee_delta_version]{WITH_LOCK(m_mempool.cs, return std::make_pair(m_mempool.GetSequence(), m_mempool.GetFeeDeltaVersion()))};
+    {
+        LOCK(m_mutex);
+        if (m_projection && m_projection->fee_delta_version == fee_delta_version &&
+            (m_projection->mempool_sequence == sequence || SteadyClock::now() - m_projection->computed_at < PROJECTION_MAX_AGE)) {
+            return m_projection;
+        }
+    }
+    auto projection{std::make_shared<const MempoolProjection>(ProjectBlocks(m_mempool, MAX_PROJECTED_BLOCKS))};
+    LOCK(m_mutex);
+    m_projection = projection;
+    return projection;
+}
+
+} // namespace node
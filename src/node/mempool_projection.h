@@ -0,0 +1,90 @@
+// Copyright (c) 2024 The Krepto core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_MEMPOOL_PROJECTION_H
+#define BITCOIN_NODE_MEMPOOL_PROJECTION_H
+
+#include <consensus/amount.h>
+#include <policy/feerate.h>
+#include <sync.h>
+#include <util/time.h>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class CTxMemPool;
+
+namespace node {
+
+/** Maximum number of projected blocks computed (and cached) per projection. */
+static constexpr size_t MAX_PROJECTED_BLOCKS{8};
+
+/** A cached projection is served as-is while it is younger than this, even if the mempool changed. */
+static constexpr std::chrono::seconds PROJECTION_MAX_AGE{2};
+
+/** Lower bounds (in sat/vB) of the feerate histogram buckets of a projected block. */
+static constexpr std::array<int64_t, 22> PROJECTION_FEERATE_BUCKETS{
+    0, 1, 2, 3, 4, 5, 6, 8, 10, 12, 15, 20, 30, 40, 50, 70, 100, 150, 200, 300, 500, 1000};
+
+/** Summary of one block worth of mempool transactions, as a miner would select them. */
+struct ProjectedBlock {
+    int64_t vsize{0};
+    int64_t weight{0};
+    CAmount fees{0};
+    size_t tx_count{0};
+    CFeeRate min_feerate;
+    /** Virtual-size weighted median of the package feerates in this block. */
+    CFeeRate median_feerate;
+    CFeeRate max_feerate;
+    /** Total vsize of transactions per PROJECTION_FEERATE_BUCKETS bucket. */
+    std::array<int64_t, PROJECTION_FEERATE_BUCKETS.size()> feerate_histogram{};
+};
+
+struct MempoolProjection {
+    /** Mempool sequence number the projection was computed at. */
+    uint64_t mempool_sequence{0};
+    /** Mempool fee delta version the projection was computed at. */
+    uint64_t fee_delta_version{0};
+    SteadyClock::time_point computed_at;
+    /** Projected blocks in mining order. The last one holds whatever does not fit in the others. */
+    std::vector<ProjectedBlock> blocks;
+    /** remainders[i] merges blocks[i] and all the blocks after it, i.e. it is the
+     * last block of a projection of i + 1 blocks. */
+    std::vector<ProjectedBlock> remainders;
+};
+
+/**
+ * Split the mempool into up to max_blocks consecutive blocks using the same
+ * ancestor-feerate package selection as BlockAssembler. Selection stops once
+ * the last block is reached; that block takes all remaining transactions at
+ * their ancestor feerates. Sigop limits and transaction finality are ignored.
+ * Takes mempool.cs.
+ */
+MempoolProjection ProjectBlocks(const CTxMemPool& mempool, size_t max_blocks);
+
+/** Keeps the latest projection of MAX_PROJECTED_BLOCKS blocks of a mempool. */
+class MempoolProjectionCache
+{
+    const CTxMemPool& m_mempool;
+    Mutex m_mutex;
+    std::shared_ptr<const MempoolProjection> m_projection GUARDED_BY(m_mutex);
+
+public:
+    explicit MempoolProjectionCache(const CTxMemPool& mempool) : m_mempool{mempool} {}
+
+    /**
+     * Return the projection, recomputing it if fee deltas changed, or if the
+     * mempool sequence moved on and the cached one is older than
+     * PROJECTION_MAX_AGE. May be called with or without mempool.cs held.
+     */
+    std::shared_ptr<const MempoolProjection> Get() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+};
+
+} // namespace node
+
+#endif // BITCOIN_NODE_MEMPOOL_PROJECTION_H
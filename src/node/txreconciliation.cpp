@@ -5,11 +5,18 @@
 #include <node/txreconciliation.h>
 
 #include <common/system.h>
+#include <crypto/siphash.h>
 #include <logging.h>
+#include <node/minisketchwrapper.h>
 #include <util/check.h>
+#include <util/hasher.h>
 
+#include <algorithm>
+#include <cmath>
 #include <unordered_map>
+#include <unordered_set>
 #include <variant>
+#include <vector>
 
 
 namespace {
@@ -29,6 +36,19 @@ uint256 ComputeSalt(uint64_t salt1, uint64_t salt2)
     return (HashWriter(RECON_SALT_HASHER) << std::min(salt1, salt2) << std::max(salt1, salt2)).GetSHA256();
 }
 
+/** Where a peer is in the current reconciliation round. */
+enum class ReconciliationPhase {
+    NONE,
+    /** Initiator: REQRECON sent, waiting for the peer's SKETCH. */
+    INIT_REQUESTED,
+    /** Responder: REQRECON received, SKETCH to be sent at the next announcement time. */
+    REQUEST_RECEIVED,
+    /** Responder: SKETCH sent, waiting for the peer's RECONCILDIFF. */
+    SKETCH_SENT,
+};
+
+using WtxidSet = std::unordered_set<Wtxid, SaltedTxidHasher>;
+
 /**
  * Keeps track of txreconciliation-related per-peer state.
  */
@@ -36,9 +56,6 @@ class TxReconciliationState
 {
 public:
     /**
-     * TODO: This field is public to ignore -Wunused-private-field. Make private once used in
-     * the following commits.
-     *
      * Reconciliation protocol assumes using one role consistently: either a reconciliation
      * initiator (requesting sketches), or responder (sending sketches). This defines our role,
      * based on the direction of the p2p connection.
@@ -47,14 +64,59 @@ public:
     bool m_we_initiate;
 
     /**
-     * TODO: These fields are public to ignore -Wunused-private-field. Make private once used in
-     * the following commits.
-     *
      * These values are used to salt short IDs, which is necessary for transaction reconciliations.
      */
     uint64_t m_k0, m_k1;
 
+    /** Transactions to be reconciled with the peer at the next round. */
+    WtxidSet m_local_set;
+
+    /** Responder: the set a sketch was sent for, kept until the peer's RECONCILDIFF arrives. */
+    std::vector<Wtxid> m_local_set_snapshot;
+
+    ReconciliationPhase m_phase{ReconciliationPhase::NONE};
+
+    /** Responder: set size and q from the pending REQRECON. */
+    uint16_t m_remote_set_size{0};
+    uint16_t m_remote_q{0};
+
+    /** Initiator: when the next REQRECON may be sent. */
+    std::chrono::microseconds m_next_request{0};
+
+    /** When the peer must have answered our REQRECON (initiator) or SKETCH (responder) by. */
+    std::chrono::microseconds m_response_deadline{0};
+
     TxReconciliationState(bool we_initiate, uint64_t k0, uint64_t k1) : m_we_initiate(we_initiate), m_k0(k0), m_k1(k1) {}
+
+    /** Short ID of a transaction as defined by BIP-330: 1 + (SipHash-2-4(wtxid) mod (2^32 - 1)). */
+    uint32_t ComputeShortID(const Wtxid& wtxid) const
+    {
+        const uint64_t s{SipHashUint256(m_k0, m_k1, wtxid)};
+        return 1 + static_cast<uint32_t>(s % 0xFFFFFFFF);
+    }
+
+    /** Map the short IDs of the given transactions back to them. */
+    template <typename C>
+    std::unordered_map<uint32_t, Wtxid> ShortIDs(const C& set) const
+    {
+        std::unordered_map<uint32_t, Wtxid> ret;
+        ret.reserve(set.size());
+        for (const Wtxid& wtxid : set) ret.emplace(ComputeShortID(wtxid), wtxid);
+        return ret;
+    }
+
+    /**
+     * Responder: sketch capacity for the pending request. The expected set difference is
+     * |local - remote| + q * min(local, remote), plus one to tolerate a small error (BIP-330).
+     */
+    size_t EstimateSketchCapacity(size_t local_set_size) const
+    {
+        const size_t remote_set_size{m_remote_set_size};
+        const double q{double(m_remote_q) / Q_PRECISION};
+        const size_t set_size_diff{std::max(local_set_size, remote_set_size) - std::min(local_set_size, remote_set_size)};
+        const size_t estimate{set_size_diff + size_t(std::ceil(q * std::min(local_set_size, remote_set_size))) + 1};
+        return std::min(estimate, MAX_SKETCH_CAPACITY);
+    }
 };
 
 } // namespace
@@ -76,6 +138,13 @@ private:
      */
     std::unordered_map<NodeId, std::variant<uint64_t, TxReconciliationState>> m_states GUARDED_BY(m_txreconciliation_mutex);
 
+    TxReconciliationState* GetRegisteredState(NodeId peer_id) EXCLUSIVE_LOCKS_REQUIRED(m_txreconciliation_mutex)
+    {
+        auto recon_state = m_states.find(peer_id);
+        if (recon_state == m_states.end()) return nullptr;
+        return std::get_if<TxReconciliationState>(&recon_state->second);
+    }
+
 public:
     explicit Impl(uint32_t recon_version) : m_recon_version(recon_version) {}
 
@@ -121,7 +190,7 @@ public:
                       peer_id, is_peer_inbound);
 
         const uint256 full_salt{ComputeSalt(local_salt, remote_salt)};
-        recon_state->second = TxReconciliationState(!is_peer_inbound, full_salt.GetUint64(0), full_salt.GetUint64(1));
+        recon_state->second.emplace<TxReconciliationState>(!is_peer_inbound, full_salt.GetUint64(0), full_salt.GetUint64(1));
         return ReconciliationRegisterResult::SUCCESS;
     }
 
@@ -142,6 +211,170 @@ public:
         return (recon_state != m_states.end() &&
                 std::holds_alternative<TxReconciliationState>(recon_state->second));
     }
+
+    bool AddToSet(NodeId peer_id, const Wtxid& wtxid) EXCLUSIVE_LOCKS_REQUIRED(!m_txreconciliation_mutex)
+    {
+        AssertLockNotHeld(m_txreconciliation_mutex);
+        LOCK(m_txreconciliation_mutex);
+        auto peer_state{GetRegisteredState(peer_id)};
+        if (!peer_state) return false;
+        if (peer_state->m_we_initiate) return false;
+        if (peer_state->m_local_set.size() >= MAX_RECONSET_SIZE) return false;
+        peer_state->m_local_set.insert(wtxid);
+        return true;
+    }
+
+    bool TryRemovingFromSet(NodeId peer_id, const Wtxid& wtxid) EXCLUSIVE_LOCKS_REQUIRED(!m_txreconciliation_mutex)
+    {
+        AssertLockNotHeld(m_txreconciliation_mutex);
+        LOCK(m_txreconciliation_mutex);
+        auto peer_state{GetRegisteredState(peer_id)};
+        return peer_state && peer_state->m_local_set.erase(wtxid) > 0;
+    }
+
+    std::optional<std::pair<uint16_t, uint16_t>> InitiateReconciliationRequest(NodeId peer_id, std::chrono::microseconds now)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_txreconciliation_mutex)
+    {
+        AssertLockNotHeld(m_txreconciliation_mutex);
+        LOCK(m_txreconciliation_mutex);
+        auto peer_state{GetRegisteredState(peer_id)};
+        if (!peer_state || !peer_state->m_we_initiate) return std::nullopt;
+        // Only one round may be in flight (BIP330): the peer treats a second
+        // REQRECON before it got our RECONCILDIFF as a protocol violation.
+        if (peer_state->m_phase == ReconciliationPhase::INIT_REQUESTED) return std::nullopt;
+        if (now < peer_state->m_next_request) return std::nullopt;
+
+        peer_state->m_phase = ReconciliationPhase::INIT_REQUESTED;
+        peer_state->m_next_request = now + RECON_REQUEST_INTERVAL;
+        peer_state->m_response_deadline = now + RECON_RESPONSE_TIMEOUT;
+        const uint16_t set_size{static_cast<uint16_t>(peer_state->m_local_set.size())};
+        LogPrintLevel(BCLog::TXRECONCILIATION, BCLog::Level::Debug, "Initiate reconciliation with peer=%d (local set size=%u)\n",
+                      peer_id, set_size);
+        return std::make_pair(set_size, static_cast<uint16_t>(RECON_Q * Q_PRECISION));
+    }
+
+    bool HandleReconciliationRequest(NodeId peer_id, uint16_t peer_set_size, uint16_t peer_q) EXCLUSIVE_LOCKS_REQUIRED(!m_txreconciliation_mutex)
+    {
+        AssertLockNotHeld(m_txreconciliation_mutex);
+        LOCK(m_txreconciliation_mutex);
+        auto peer_state{GetRegisteredState(peer_id)};
+        if (!peer_state || peer_state->m_we_initiate) return false;
+        // The previous round must be finished with a RECONCILDIFF first.
+        if (peer_state->m_phase != ReconciliationPhase::NONE) return false;
+
+        peer_state->m_remote_set_size = peer_set_size;
+        peer_state->m_remote_q = peer_q;
+        peer_state->m_phase = ReconciliationPhase::REQUEST_RECEIVED;
+        return true;
+    }
+
+    std::optional<std::vector<uint8_t>> RespondToReconciliationRequest(NodeId peer_id, std::chrono::microseconds now)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_txreconciliation_mutex)
+    {
+        AssertLockNotHeld(m_txreconciliation_mutex);
+        LOCK(m_txreconciliation_mutex);
+        auto peer_state{GetRegisteredState(peer_id)};
+        if (!peer_state || peer_state->m_phase != ReconciliationPhase::REQUEST_RECEIVED) return std::nullopt;
+
+        const size_t capacity{peer_state->EstimateSketchCapacity(peer_state->m_local_set.size())};
+        Minisketch sketch{node::MakeMinisketch32(capacity)};
+        for (const Wtxid& wtxid : peer_state->m_local_set) {
+            sketch.Add(peer_state->ComputeShortID(wtxid));
+        }
+
+        // Transactions arriving from now on belong to the next round.
+        peer_state->m_local_set_snapshot.assign(peer_state->m_local_set.begin(), peer_state->m_local_set.end());
+        peer_state->m_local_set.clear();
+        peer_state->m_phase = ReconciliationPhase::SKETCH_SENT;
+        peer_state->m_response_deadline = now + RECON_RESPONSE_TIMEOUT;
+
+        LogPrintLevel(BCLog::TXRECONCILIATION, BCLog::Level::Debug, "Send sketch to peer=%d (capacity=%u, set size=%u)\n",
+                      peer_id, capacity, peer_state->m_local_set_snapshot.size());
+        return sketch.Serialize();
+    }
+
+    std::optional<ReconciliationResult> HandleSketch(NodeId peer_id, Span<const uint8_t> skdata) EXCLUSIVE_LOCKS_REQUIRED(!m_txreconciliation_mutex)
+    {
+        AssertLockNotHeld(m_txreconciliation_mutex);
+        LOCK(m_txreconciliation_mutex);
+        auto peer_state{GetRegisteredState(peer_id)};
+        if (!peer_state || peer_state->m_phase != ReconciliationPhase::INIT_REQUESTED) return std::nullopt;
+
+        // 32-bit short IDs take four bytes per unit of capacity.
+        if (skdata.size() % 4 != 0) return std::nullopt;
+        const size_t capacity{skdata.size() / 4};
+        if (capacity > MAX_SKETCH_CAPACITY) return std::nullopt;
+
+        ReconciliationResult result;
+        const auto local_short_ids{peer_state->ShortIDs(peer_state->m_local_set)};
+        if (capacity > 0) {
+            Minisketch remote_sketch{node::MakeMinisketch32(capacity)};
+            remote_sketch.Deserialize(skdata);
+            Minisketch local_sketch{node::MakeMinisketch32(capacity)};
+            for (const auto& [short_id, _] : local_short_ids) local_sketch.Add(short_id);
+            local_sketch.Merge(remote_sketch);
+
+            if (const auto differences{local_sketch.Decode(capacity)}) {
+                result.success = true;
+                for (const uint64_t short_id : *differences) {
+                    const auto it{local_short_ids.find(static_cast<uint32_t>(short_id))};
+                    if (it != local_short_ids.end()) {
+                        result.txs_to_announce.push_back(it->second);
+                    } else {
+                        result.txs_to_request.push_back(static_cast<uint32_t>(short_id));
+                    }
+                }
+            }
+        }
+        if (!result.success) {
+            // The difference was larger than estimated; fall back to announcing our whole set.
+            result.txs_to_announce.assign(peer_state->m_local_set.begin(), peer_state->m_local_set.end());
+        }
+
+        LogPrintLevel(BCLog::TXRECONCILIATION, BCLog::Level::Debug,
+                      "Reconciliation with peer=%d %s (capacity=%u, to request=%u, to announce=%u)\n",
+                      peer_id, result.success ? "succeeded" : "failed", capacity,
+                      result.txs_to_request.size(), result.txs_to_announce.size());
+        peer_state->m_local_set.clear();
+        peer_state->m_phase = ReconciliationPhase::NONE;
+        return result;
+    }
+
+    std::optional<std::vector<Wtxid>> HandleReconciliationDifference(NodeId peer_id, bool success, const std::vector<uint32_t>& ask_shortids)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_txreconciliation_mutex)
+    {
+        AssertLockNotHeld(m_txreconciliation_mutex);
+        LOCK(m_txreconciliation_mutex);
+        auto peer_state{GetRegisteredState(peer_id)};
+        if (!peer_state || peer_state->m_phase != ReconciliationPhase::SKETCH_SENT) return std::nullopt;
+
+        std::vector<Wtxid> to_announce;
+        if (success) {
+            const auto snapshot_short_ids{peer_state->ShortIDs(peer_state->m_local_set_snapshot)};
+            for (const uint32_t short_id : ask_shortids) {
+                const auto it{snapshot_short_ids.find(short_id)};
+                if (it != snapshot_short_ids.end()) to_announce.push_back(it->second);
+            }
+        } else {
+            to_announce = peer_state->m_local_set_snapshot;
+        }
+        peer_state->m_local_set_snapshot.clear();
+        peer_state->m_phase = ReconciliationPhase::NONE;
+        return to_announce;
+    }
+
+    bool HasRoundTimedOut(NodeId peer_id, std::chrono::microseconds now) const EXCLUSIVE_LOCKS_REQUIRED(!m_txreconciliation_mutex)
+    {
+        AssertLockNotHeld(m_txreconciliation_mutex);
+        LOCK(m_txreconciliation_mutex);
+        const auto recon_state{m_states.find(peer_id)};
+        if (recon_state == m_states.end()) return false;
+        const auto peer_state{std::get_if<TxReconciliationState>(&recon_state->second)};
+        if (!peer_state) return false;
+        if (peer_state->m_phase != ReconciliationPhase::INIT_REQUESTED &&
+            peer_state->m_phase != ReconciliationPhase::SKETCH_SENT) return false;
+        return now > peer_state->m_response_deadline;
+    }
 };
 
 TxReconciliationTracker::TxReconciliationTracker(uint32_t recon_version) : m_impl{std::make_unique<TxReconciliationTracker::Impl>(recon_version)} {}
@@ -168,3 +401,44 @@ bool TxReconciliationTracker::IsPeerRegistered(NodeId peer_id) const
 {
     return m_impl->IsPeerRegistered(peer_id);
 }
+
+bool TxReconciliationTracker::AddToSet(NodeId peer_id, const Wtxid& wtxid)
+{
+    return m_impl->AddToSet(peer_id, wtxid);
+}
+
+bool TxReconciliationTracker::TryRemovingFromSet(NodeId peer_id, const Wtxid& wtxid)
+{
+    return m_impl->TryRemovingFromSet(peer_id, wtxid);
+}
+
+std::optional<std::pair<uint16_t, uint16_t>> TxReconciliationTracker::InitiateReconciliationRequest(NodeId peer_id, std::chrono::microseconds now)
+{
+    return m_impl->InitiateReconciliationRequest(peer_id, now);
+}
+
+bool TxReconciliationTracker::HandleReconciliationRequest(NodeId peer_id, uint16_t peer_set_size, uint16_t peer_q)
+{
+    return m_impl->HandleReconciliationRequest(peer_id, peer_set_size, peer_q);
+}
+
+std::optional<std::vector<uint8_t>> TxReconciliationTracker::RespondToReconciliationRequest(NodeId peer_id, std::chrono::microseconds now)
+{
+    return m_impl->RespondToReconciliationRequest(peer_id, now);
+}
+
+std::optional<ReconciliationResult> TxReconciliationTracker::HandleSketch(NodeId peer_id, Span<const uint8_t> skdata)
+{
+    return m_impl->HandleSketch(peer_id, skdata);
+}
+
+std::optional<std::vector<Wtxid>> TxReconciliationTracker::HandleReconciliationDifference(NodeId peer_id, bool success,
+                                                                                           const std::vector<uint32_t>& ask_shortids)
+{
+    return m_impl->HandleReconciliationDifference(peer_id, success, ask_shortids);
+}
+
+bool TxReconciliationTracker::HasRoundTimedOut(NodeId peer_id, std::chrono::microseconds now) const
+{
+    return m_impl->HasRoundTimedOut(peer_id, now);
+}
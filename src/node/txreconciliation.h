@@ -6,14 +6,55 @@
 #define BITCOIN_NODE_TXRECONCILIATION_H
 
 #include <net.h>
+#include <primitives/transaction.h>
+#include <span.h>
 #include <sync.h>
 
+#include <chrono>
 #include <memory>
+#include <optional>
 #include <tuple>
+#include <vector>
 
 /** Supported transaction reconciliation protocol version */
 static constexpr uint32_t TXRECONCILIATION_VERSION{1};
 
+/** How often we request a sketch from each peer we initiate reconciliations with. */
+static constexpr std::chrono::seconds RECON_REQUEST_INTERVAL{8};
+
+/**
+ * How long we wait for the peer's SKETCH (as initiator) or RECONCILDIFF (as responder) before
+ * disconnecting it. BIP-330 has no message to abandon a round, so a peer that stops answering
+ * would otherwise keep our set (and its own) from ever being announced.
+ */
+static constexpr std::chrono::seconds RECON_RESPONSE_TIMEOUT{60};
+
+/**
+ * Maximum number of transactions waiting to be reconciled with a single peer. Transactions that
+ * do not fit are announced with a regular inv instead.
+ */
+static constexpr size_t MAX_RECONSET_SIZE{3000};
+
+/** Upper bound on the sketch capacity we are willing to build or decode. */
+static constexpr size_t MAX_SKETCH_CAPACITY{2 << 12};
+
+/**
+ * Coefficient used to estimate the set difference from the set sizes (see BIP-330), sent in
+ * REQRECON as a fixed-point number scaled by Q_PRECISION.
+ */
+static constexpr double RECON_Q{0.25};
+static constexpr uint16_t Q_PRECISION{(2 << 14) - 1};
+
+/** Outcome of processing a sketch received from a peer. */
+struct ReconciliationResult {
+    /** Whether the set difference could be decoded. */
+    bool success{false};
+    /** Short IDs of the transactions the peer has and we are missing, to be requested with RECONCILDIFF. */
+    std::vector<uint32_t> txs_to_request;
+    /** Transactions we have and the peer is missing, to be announced with inv. On failure, our whole set. */
+    std::vector<Wtxid> txs_to_announce;
+};
+
 enum class ReconciliationRegisterResult {
     NOT_FOUND,
     SUCCESS,
@@ -27,6 +68,9 @@ enum class ReconciliationRegisterResult {
  * The high-level protocol is:
  * 0.  Txreconciliation protocol handshake.
  * 1.  Once we receive a new transaction, add it to the set instead of announcing immediately.
+ *     Transactions are still flooded to the peers we initiate reconciliations with (our outbound
+ *     peers), as in BIP-330's low-fanout flooding, so only announcements to inbound peers wait
+ *     for a reconciliation round.
  * 2.  At regular intervals, a txreconciliation initiator requests a sketch from a peer, where a
  *     sketch is a compressed representation of short form IDs of the transactions in their set.
  * 3.  Once the initiator received a sketch from the peer, the initiator computes a local sketch,
@@ -84,6 +128,60 @@ public:
      * Check if a peer is registered to reconcile transactions with us.
      */
     bool IsPeerRegistered(NodeId peer_id) const;
+
+    /**
+     * Step 1. Add a transaction to the set we will reconcile with the peer, instead of announcing
+     * it right away. Returns false if the peer is not registered, we initiate reconciliations with
+     * it (transactions are flooded to those peers) or the set is full, in which case the caller
+     * should announce the transaction with a regular inv.
+     */
+    bool AddToSet(NodeId peer_id, const Wtxid& wtxid);
+
+    /**
+     * Remove a transaction from the set we will reconcile with the peer, e.g. because the peer
+     * announced it to us. Returns whether it was there.
+     */
+    bool TryRemovingFromSet(NodeId peer_id, const Wtxid& wtxid);
+
+    /**
+     * Step 2. If we initiate reconciliations with this peer, none is in progress and the request
+     * interval elapsed, start one. Returns the (local set size, q) to send in REQRECON.
+     */
+    std::optional<std::pair<uint16_t, uint16_t>> InitiateReconciliationRequest(NodeId peer_id, std::chrono::microseconds now);
+
+    /**
+     * Step 2. Record a REQRECON from a peer that initiates reconciliations with us. Returns false
+     * if the request violates the protocol: we are the initiator, or the previous round (request
+     * received or sketch sent) has not been finished by a RECONCILDIFF yet.
+     */
+    bool HandleReconciliationRequest(NodeId peer_id, uint16_t peer_set_size, uint16_t peer_q);
+
+    /**
+     * Step 2. If a REQRECON from this peer is pending, snapshot our set for the peer and return a
+     * sketch of it, sized from the estimated set difference, to be sent in SKETCH.
+     */
+    std::optional<std::vector<uint8_t>> RespondToReconciliationRequest(NodeId peer_id, std::chrono::microseconds now);
+
+    /**
+     * Step 3. Combine the peer's sketch with one of our own set to find the set difference.
+     * Returns std::nullopt if we did not request the sketch or it is malformed. Our set for the
+     * peer is cleared either way; the result says what to request and what to announce.
+     */
+    std::optional<ReconciliationResult> HandleSketch(NodeId peer_id, Span<const uint8_t> skdata);
+
+    /**
+     * Step 4. Process the initiator's RECONCILDIFF for the snapshot we sent a sketch of. Returns
+     * the transactions to announce to the peer (those it asked for, or the whole snapshot on
+     * failure), or std::nullopt if no sketch was outstanding.
+     */
+    std::optional<std::vector<Wtxid>> HandleReconciliationDifference(NodeId peer_id, bool success,
+                                                                     const std::vector<uint32_t>& ask_shortids);
+
+    /**
+     * Whether we have been waiting for the peer's SKETCH or RECONCILDIFF for longer than
+     * RECON_RESPONSE_TIMEOUT, in which case the peer should be disconnected.
+     */
+    bool HasRoundTimedOut(NodeId peer_id, std::chrono::microseconds now) const;
 };
 
 #endif // BITCOIN_NODE_TXRECONCILIATION_H
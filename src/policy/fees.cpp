@@ -100,6 +100,11 @@ private:
 
     double decay;
 
+    // The moving averages above are stored divided by this factor, which is
+    // the product of all decays applied since the last renormalization. This
+    // makes decaying O(1) per block instead of touching every cell.
+    double m_decay_multiplier{1.0};
+
     // Resolution (# of blocks) with which confirmations are tracked
     unsigned int scale;
 
@@ -112,6 +117,9 @@ private:
 
     void resizeInMemoryCounters(size_t newbuckets);
 
+    /** Fold m_decay_multiplier into the stored averages and reset it to 1. */
+    void Renormalize();
+
 public:
     /**
      * Create new TxConfirmStats. This is called by BlockPolicyEstimator's
@@ -217,24 +225,33 @@ void TxConfirmStats::Record(int blocksToConfirm, double feerate)
         return;
     int periodsToConfirm = (blocksToConfirm + scale - 1) / scale;
     unsigned int bucketindex = bucketMap.lower_bound(feerate)->second;
+    const double weight{1.0 / m_decay_multiplier};
     for (size_t i = periodsToConfirm; i <= confAvg.size(); i++) {
-        confAvg[i - 1][bucketindex]++;
+        confAvg[i - 1][bucketindex] += weight;
     }
-    txCtAvg[bucketindex]++;
-    m_feerate_avg[bucketindex] += feerate;
+    txCtAvg[bucketindex] += weight;
+    m_feerate_avg[bucketindex] += feerate * weight;
 }
 
-void TxConfirmStats::UpdateMovingAverages()
+void TxConfirmStats::Renormalize()
 {
     assert(confAvg.size() == failAvg.size());
-    for (unsigned int j = 0; j < buckets.size(); j++) {
+    for (unsigned int j = 0; j < txCtAvg.size(); j++) {
         for (unsigned int i = 0; i < confAvg.size(); i++) {
-            confAvg[i][j] *= decay;
-            failAvg[i][j] *= decay;
+            confAvg[i][j] *= m_decay_multiplier;
+            failAvg[i][j] *= m_decay_multiplier;
         }
-        m_feerate_avg[j] *= decay;
-        txCtAvg[j] *= decay;
+        m_feerate_avg[j] *= m_decay_multiplier;
+        txCtAvg[j] *= m_decay_multiplier;
     }
+    m_decay_multiplier = 1.0;
+}
+
+void TxConfirmStats::UpdateMovingAverages()
+{
+    m_decay_multiplier *= decay;
+    // Keep the stored values well within double range.
+    if (m_decay_multiplier < 1e-64) Renormalize();
 }
 
 // returns -1 on error conditions
@@ -279,10 +296,10 @@ double TxConfirmStats::EstimateMedianVal(int confTarget, double sufficientTxVal,
             newBucketRange = false;
         }
         curFarBucket = bucket;
-        nConf += confAvg[periodTarget - 1][bucket];
-        partialNum += txCtAvg[bucket];
-        totalNum += txCtAvg[bucket];
-        failNum += failAvg[periodTarget - 1][bucket];
+        nConf += confAvg[periodTarget - 1][bucket] * m_decay_multiplier;
+        partialNum += txCtAvg[bucket] * m_decay_multiplier;
+        totalNum += txCtAvg[bucket] * m_decay_multiplier;
+        failNum += failAvg[periodTarget - 1][bucket] * m_decay_multiplier;
         for (unsigned int confct = confTarget; confct < GetMaxConfirms(); confct++)
             extraNum += unconfTxs[(nBlockHeight - confct) % bins][bucket];
         extraNum += oldUnconfTxs[bucket];
@@ -406,12 +423,15 @@ double TxConfirmStats::EstimateMedianVal(int confTarget, double sufficientTxVal,
 
 void TxConfirmStats::Write(AutoFile& fileout) const
 {
+    // The file stores the actual averages, so apply the pending decay to a copy.
+    TxConfirmStats normalized{*this};
+    normalized.Renormalize();
     fileout << Using<EncodedDoubleFormatter>(decay);
     fileout << scale;
-    fileout << Using<VectorFormatter<EncodedDoubleFormatter>>(m_feerate_avg);
-    fileout << Using<VectorFormatter<EncodedDoubleFormatter>>(txCtAvg);
-    fileout << Using<VectorFormatter<VectorFormatter<EncodedDoubleFormatter>>>(confAvg);
-    fileout << Using<VectorFormatter<VectorFormatter<EncodedDoubleFormatter>>>(failAvg);
+    fileout << Using<VectorFormatter<EncodedDoubleFormatter>>(normalized.m_feerate_avg);
+    fileout << Using<VectorFormatter<EncodedDoubleFormatter>>(normalized.txCtAvg);
+    fileout << Using<VectorFormatter<VectorFormatter<EncodedDoubleFormatter>>>(normalized.confAvg);
+    fileout << Using<VectorFormatter<VectorFormatter<EncodedDoubleFormatter>>>(normalized.failAvg);
 }
 
 void TxConfirmStats::Read(AutoFile& filein, int nFileVersion, size_t numBuckets)
@@ -431,6 +451,7 @@ void TxConfirmStats::Read(AutoFile& filein, int nFileVersion, size_t numBuckets)
         throw std::runtime_error("Corrupt estimates file. Scale must be non-zero");
     }
 
+    m_decay_multiplier = 1.0;
     filein >> Using<VectorFormatter<EncodedDoubleFormatter>>(m_feerate_avg);
     if (m_feerate_avg.size() != numBuckets) {
         throw std::runtime_error("Corrupt estimates file. Mismatch in feerate average bucket count");
@@ -510,7 +531,7 @@ void TxConfirmStats::removeTx(unsigned int entryHeight, unsigned int nBestSeenHe
         assert(scale != 0);
         unsigned int periodsAgo = blocksAgo / scale;
         for (size_t i = 0; i < periodsAgo && i < failAvg.size(); i++) {
-            failAvg[i][bucketindex]++;
+            failAvg[i][bucketindex] += 1.0 / m_decay_multiplier;
         }
     }
 }
@@ -679,6 +700,7 @@ void CBlockPolicyEstimator::processBlock(const std::vector<RemovedMempoolTransac
     // calls to removeTx (via processBlockTx) correctly calculate age
     // of unconfirmed txs to remove from tracking.
     nBestSeenHeight = nBlockHeight;
+    m_smart_fee_cache.clear();
 
     // Update unconfirmed circular buffer
     feeStats->ClearCurrent(nBlockHeight);
@@ -868,6 +890,21 @@ CFeeRate CBlockPolicyEstimator::estimateSmartFee(int confTarget, FeeCalculation
 {
     LOCK(m_cs_fee_estimator);
 
+    const auto key{std::make_pair(confTarget, conservative)};
+    auto it{m_smart_fee_cache.find(key)};
+    if (it == m_smart_fee_cache.end()) {
+        FeeCalculation calc;
+        const CFeeRate feerate{_estimateSmartFee(confTarget, &calc, conservative)};
+        it = m_smart_fee_cache.emplace(key, std::make_pair(feerate, calc)).first;
+    }
+    if (feeCalc) *feeCalc = it->second.second;
+    return it->second.first;
+}
+
+CFeeRate CBlockPolicyEstimator::_estimateSmartFee(int confTarget, FeeCalculation *feeCalc, bool conservative) const
+{
+    AssertLockHeld(m_cs_fee_estimator);
+
     if (feeCalc) {
         feeCalc->desiredTarget = confTarget;
         feeCalc->returnedTarget = confTarget;
@@ -1035,6 +1072,7 @@ bool CBlockPolicyEstimator::Read(AutoFile& filein)
             nBestSeenHeight = nFileBestSeenHeight;
             historicalFirst = nFileHistoricalFirst;
             historicalBest = nFileHistoricalBest;
+            m_smart_fee_cache.clear();
         }
     }
     catch (const std::exception& e) {
@@ -20,6 +20,7 @@
 #include <memory>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 
@@ -297,6 +298,11 @@ private:
     unsigned int trackedTxs GUARDED_BY(m_cs_fee_estimator){0};
     unsigned int untrackedTxs GUARDED_BY(m_cs_fee_estimator){0};
 
+    /** Results of estimateSmartFee by (confTarget, conservative). Cleared on every
+     * block and when estimates are read from disk; transactions entering or leaving
+     * the mempool in between are only taken into account from the next block on. */
+    mutable std::map<std::pair<int, bool>, std::pair<CFeeRate, FeeCalculation>> m_smart_fee_cache GUARDED_BY(m_cs_fee_estimator);
+
     std::vector<double> buckets GUARDED_BY(m_cs_fee_estimator); // The upper-bound of the range for the bucket (inclusive)
     std::map<double, unsigned int> bucketMap GUARDED_BY(m_cs_fee_estimator); // Map of bucket upper-bound to index into all vectors by bucket
 
@@ -313,6 +319,8 @@ private:
     unsigned int HistoricalBlockSpan() const EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
     /** Calculation of highest target that reasonable estimate can be provided for */
     unsigned int MaxUsableEstimate() const EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
+    /** Uncached implementation of estimateSmartFee */
+    CFeeRate _estimateSmartFee(int confTarget, FeeCalculation *feeCalc, bool conservative) const EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
 
     /** A non-thread-safe helper for the removeTx function */
     bool _removeTx(const uint256& hash, bool inBlock)
@@ -264,6 +264,20 @@ inline constexpr const char* WTXIDRELAY{"wtxidrelay"};
  * txreconciliation, as described by BIP 330.
  */
 inline constexpr const char* SENDTXRCNCL{"sendtxrcncl"};
+/**
+ * Requests a sketch of the sender's reconciliation set from the receiver. Contains the
+ * sender's set size and the q coefficient used to estimate the set difference (BIP 330).
+ */
+inline constexpr const char* REQRECON{"reqrecon"};
+/**
+ * Contains a sketch of the sender's reconciliation set, in response to reqrecon (BIP 330).
+ */
+inline constexpr const char* SKETCH{"sketch"};
+/**
+ * Concludes a reconciliation round: whether the set difference could be decoded and the
+ * short IDs of the transactions the sender wants announced (BIP 330).
+ */
+inline constexpr const char* RECONCILDIFF{"reconcildiff"};
 }; // namespace NetMsgType
 
 /** All known message types (see above). Keep this in the same order as the list of messages above. */
@@ -303,6 +317,9 @@ inline const std::array ALL_NET_MESSAGE_TYPES{std::to_array<std::string>({
     NetMsgType::CFCHECKPT,
     NetMsgType::WTXIDRELAY,
     NetMsgType::SENDTXRCNCL,
+    NetMsgType::REQRECON,
+    NetMsgType::SKETCH,
+    NetMsgType::RECONCILDIFF,
 })};
 
 /** nServices flags */
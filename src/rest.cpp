@@ -12,11 +12,13 @@
 #include <chainparams.h>
 #include <core_io.h>
 #include <flatfile.h>
+#include <httprpc.h>
 #include <httpserver.h>
 #include <index/blockfilterindex.h>
 #include <index/txindex.h>
 #include <node/blockstorage.h>
 #include <node/context.h>
+#include <node/mempool_projection.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
 #include <rpc/blockchain.h>
@@ -40,6 +42,7 @@
 using node::GetTransaction;
 using node::NodeContext;
 using util::SplitString;
+using util::ToString;
 
 static const size_t MAX_GETUTXOS_OUTPOINTS = 15; //allow a max of 15 outpoints to be queried at once
 static constexpr unsigned int MAX_REST_HEADERS_RESULTS = 2000;
@@ -270,9 +273,7 @@ static bool rest_headers(const std::any& context,
         for (const CBlockIndex *pindex : headers) {
             jsonHeaders.push_back(blockheaderToJSON(*tip, *pindex));
         }
-        std::string strJSON = jsonHeaders.write() + "\n";
-        req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strJSON);
+        WriteJSONReply(req, HTTP_OK, jsonHeaders);
         return true;
     }
     default: {
@@ -339,9 +340,7 @@ static bool rest_block(const std::any& context,
         DataStream block_stream{block_data};
         block_stream >> TX_WITH_WITNESS(block);
         UniValue objBlock = blockToJSON(chainman.m_blockman, block, *tip, *pblockindex, tx_verbosity);
-        std::string strJSON = objBlock.write() + "\n";
-        req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strJSON);
+        WriteJSONReply(req, HTTP_OK, objBlock);
         return true;
     }
 
@@ -472,9 +471,7 @@ static bool rest_filter_header(const std::any& context, HTTPRequest* req, const
             jsonHeaders.push_back(header.GetHex());
         }
 
-        std::string strJSON = jsonHeaders.write() + "\n";
-        req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strJSON);
+        WriteJSONReply(req, HTTP_OK, jsonHeaders);
         return true;
     }
     default: {
@@ -650,8 +647,8 @@ static bool rest_mempool(const std::any& context, HTTPRequest* req, const std::s
 
     std::string param;
     const RESTResponseFormat rf = ParseDataFormat(param, str_uri_part);
-    if (param != "contents" && param != "info") {
-        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid URI format. Expected /rest/mempool/<info|contents>.json");
+    if (param != "contents" && param != "info" && param != "projection") {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid URI format. Expected /rest/mempool/<info|contents|projection>.json");
     }
 
     const CTxMemPool* mempool = GetMemPool(context, req);
@@ -659,7 +656,7 @@ static bool rest_mempool(const std::any& context, HTTPRequest* req, const std::s
 
     switch (rf) {
     case RESTResponseFormat::JSON: {
-        std::string str_json;
+        UniValue result;
         if (param == "contents") {
             std::string raw_verbose;
             try {
@@ -684,13 +681,26 @@ static bool rest_mempool(const std::any& context, HTTPRequest* req, const std::s
             if (verbose && mempool_sequence) {
                 return RESTERR(req, HTTP_BAD_REQUEST, "Verbose results cannot contain mempool sequence values. (hint: set \"verbose=false\")");
             }
-            str_json = MempoolToJSON(*mempool, verbose, mempool_sequence).write() + "\n";
+            result = MempoolToJSON(*mempool, verbose, mempool_sequence);
+        } else if (param == "projection") {
+            std::string raw_blocks;
+            try {
+                raw_blocks = req->GetQueryParameter("blocks").value_or(ToString(node::MAX_PROJECTED_BLOCKS));
+            } catch (const std::runtime_error& e) {
+                return RESTERR(req, HTTP_BAD_REQUEST, e.what());
+            }
+            const auto blocks{ToIntegral<size_t>(raw_blocks)};
+            if (!blocks || *blocks < 1 || *blocks > node::MAX_PROJECTED_BLOCKS) {
+                return RESTERR(req, HTTP_BAD_REQUEST, strprintf("The \"blocks\" query parameter must be between 1 and %u.", node::MAX_PROJECTED_BLOCKS));
+            }
+            // The projection cache is created along with the mempool.
+            const NodeContext* node{Assert(util::AnyPtr<NodeContext>(context))};
+            result = ProjectedBlocksToJSON(*Assert(node->mempool_projection), *blocks);
         } else {
-            str_json = MempoolInfoToJSON(*mempool).write() + "\n";
+            result = MempoolInfoToJSON(*mempool);
         }
 
-        req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, str_json);
+        WriteJSONReply(req, HTTP_OK, result);
         return true;
     }
     default: {
@@ -746,9 +756,7 @@ static bool rest_tx(const std::any& context, HTTPRequest* req, const std::string
     case RESTResponseFormat::JSON: {
         UniValue objTx(UniValue::VOBJ);
         TxToUniv(*tx, /*block_hash=*/hashBlock, /*entry=*/ objTx);
-        std::string strJSON = objTx.write() + "\n";
-        req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strJSON);
+        WriteJSONReply(req, HTTP_OK, objTx);
         return true;
     }
 
@@ -942,9 +950,7 @@ static bool rest_getutxos(const std::any& context, HTTPRequest* req, const std::
         objGetUTXOResponse.pushKV("utxos", std::move(utxos));
 
         // return json string
-        std::string strJSON = objGetUTXOResponse.write() + "\n";
-        req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strJSON);
+        WriteJSONReply(req, HTTP_OK, objGetUTXOResponse);
         return true;
     }
     default: {
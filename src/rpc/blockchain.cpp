@@ -45,6 +45,7 @@
 #include <univalue.h>
 #include <util/check.h>
 #include <util/fs.h>
+#include <util/latencyhistogram.h>
 #include <util/strencodings.h>
 #include <util/translation.h>
 #include <validation.h>
@@ -2955,6 +2956,74 @@ return RPCHelpMan{
 }
 
 
+static RPCHelpMan getvalidationtimings()
+{
+    return RPCHelpMan{"getvalidationtimings",
+        "\nReturns the distribution of the time spent in each part of block validation since startup (or the last reset).\n"
+        + strprintf("Percentiles are accurate to within %g%%.\n", 100.0 / LatencyHistogram::SUB_BUCKETS),
+        {
+            {"percentiles", RPCArg::Type::ARR, RPCArg::DefaultHint{"[50, 90, 99, 99.9]"}, "The percentiles to report, each between 0 and 100",
+                {
+                    {"percentile", RPCArg::Type::NUM, RPCArg::Optional::OMITTED, ""},
+                }},
+            {"reset", RPCArg::Type::BOOL, RPCArg::Default{false}, "Clear all distributions after reporting them"},
+        },
+        RPCResult{
+            RPCResult::Type::OBJ_DYN, "", "keyed by validation phase",
+            {
+                {RPCResult::Type::OBJ, "phase", "",
+                {
+                    {RPCResult::Type::NUM, "count", "Number of times the phase was timed"},
+                    {RPCResult::Type::NUM, "total_us", "Total time spent in the phase, in microseconds"},
+                    {RPCResult::Type::NUM, "max_us", "Longest time spent in the phase, in microseconds"},
+                    {RPCResult::Type::OBJ_DYN, "percentiles_us", "Time in microseconds, keyed by percentile (e.g. \"p99.9\")",
+                    {
+                        {RPCResult::Type::NUM, "percentile", ""},
+                    }},
+                }},
+            }},
+        RPCExamples{
+            HelpExampleCli("getvalidationtimings", "")
+            + HelpExampleCli("getvalidationtimings", "\"[99]\" true")
+            + HelpExampleRpc("getvalidationtimings", "[50, 99], false")
+        },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    std::vector<double> percentiles{50, 90, 99, 99.9};
+    if (!request.params[0].isNull()) {
+        percentiles.clear();
+        for (const UniValue& percentile : request.params[0].get_array().getValues()) {
+            const double value{percentile.get_real()};
+            if (!(value >= 0 && value <= 100)) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "Percentiles must be between 0 and 100");
+            }
+            percentiles.push_back(value);
+        }
+    }
+
+    // The histograms are lock-free, so cs_main is not needed.
+    ChainstateManager& chainman = EnsureAnyChainman(request.context);
+    UniValue ret(UniValue::VOBJ);
+    for (size_t i = 0; i < VALIDATION_PHASE_COUNT; ++i) {
+        const ValidationPhase phase{static_cast<ValidationPhase>(i)};
+        const LatencyHistogram::Snapshot snapshot{chainman.GetValidationTimingSinceReset(phase).GetSnapshot()};
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("count", snapshot.count);
+        obj.pushKV("total_us", snapshot.sum);
+        obj.pushKV("max_us", snapshot.max);
+        UniValue obj_percentiles(UniValue::VOBJ);
+        for (const double percentile : percentiles) {
+            obj_percentiles.pushKV(strprintf("p%g", percentile), snapshot.Percentile(percentile));
+        }
+        obj.pushKV("percentiles_us", std::move(obj_percentiles));
+        ret.pushKV(std::string{ValidationPhaseName(phase)}, std::move(obj));
+    }
+    if (self.Arg<bool>("reset")) chainman.ResetValidationTimings();
+    return ret;
+},
+    };
+}
+
 void RegisterBlockchainRPCCommands(CRPCTable& t)
 {
     static const CRPCCommand commands[]{
@@ -2981,6 +3050,7 @@ void RegisterBlockchainRPCCommands(CRPCTable& t)
         {"blockchain", &dumptxoutset},
         {"blockchain", &loadtxoutset},
         {"blockchain", &getchainstates},
+        {"blockchain", &getvalidationtimings},
         {"hidden", &invalidateblock},
         {"hidden", &reconsiderblock},
         {"hidden", &waitfornewblock},
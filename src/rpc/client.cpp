@@ -111,6 +111,8 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "getblock", 1, "verbose" },
     { "getblockheader", 1, "verbose" },
     { "getchaintxstats", 0, "nblocks" },
+    { "getvalidationtimings", 0, "percentiles" },
+    { "getvalidationtimings", 1, "reset" },
     { "gettransaction", 1, "include_watchonly" },
     { "gettransaction", 2, "verbose" },
     { "getrawtransaction", 1, "verbosity" },
@@ -263,6 +265,7 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "setwalletflag", 1, "value" },
     { "getmempoolancestors", 1, "verbose" },
     { "getmempooldescendants", 1, "verbose" },
+    { "getprojectedblocks", 0, "nblocks" },
     { "gettxspendingprevout", 0, "outputs" },
     { "bumpfee", 1, "options" },
     { "bumpfee", 1, "conf_target"},
@@ -8,10 +8,13 @@
 #include <node/mempool_persist.h>
 
 #include <chainparams.h>
+#include <consensus/consensus.h>
 #include <core_io.h>
 #include <kernel/mempool_entry.h>
 #include <node/mempool_persist_args.h>
+#include <node/mempool_projection.h>
 #include <node/types.h>
+#include <policy/feerate.h>
 #include <policy/rbf.h>
 #include <policy/settings.h>
 #include <primitives/transaction.h>
@@ -25,7 +28,11 @@
 #include <util/strencodings.h>
 #include <util/time.h>
 
+#include <algorithm>
+#include <chrono>
+#include <optional>
 #include <utility>
+#include <vector>
 
 using node::DumpMempool;
 
@@ -279,61 +286,147 @@ static std::vector<RPCResult> MempoolEntryDescription()
     };
 }
 
-static void entryToJSON(const CTxMemPool& pool, UniValue& info, const CTxMemPoolEntry& e) EXCLUSIVE_LOCKS_REQUIRED(pool.cs)
+/**
+ * Copy of the mempool entry fields reported by entryToJSON. Taken while
+ * holding pool.cs, so the (comparatively expensive) hex encoding and UniValue
+ * construction can happen after the lock is released and does not hold up
+ * transaction acceptance.
+ */
+struct MempoolEntrySnapshot {
+    Txid txid;
+    Wtxid wtxid;
+    int32_t vsize;
+    int32_t weight;
+    std::chrono::seconds time;
+    unsigned int height;
+    uint64_t descendant_count;
+    int64_t descendant_size;
+    uint64_t ancestor_count;
+    int64_t ancestor_size;
+    CAmount fee;
+    CAmount modified_fee;
+    CAmount ancestor_fees;
+    CAmount descendant_fees;
+    std::vector<Txid> depends;
+    std::vector<Txid> spent_by;
+    bool bip125_replaceable;
+    bool unbroadcast;
+};
+
+static MempoolEntrySnapshot SnapshotEntry(const CTxMemPool& pool, const CTxMemPoolEntry& e) EXCLUSIVE_LOCKS_REQUIRED(pool.cs)
 {
     AssertLockHeld(pool.cs);
 
-    info.pushKV("vsize", (int)e.GetTxSize());
-    info.pushKV("weight", (int)e.GetTxWeight());
-    info.pushKV("time", count_seconds(e.GetTime()));
-    info.pushKV("height", (int)e.GetHeight());
-    info.pushKV("descendantcount", e.GetCountWithDescendants());
-    info.pushKV("descendantsize", e.GetSizeWithDescendants());
-    info.pushKV("ancestorcount", e.GetCountWithAncestors());
-    info.pushKV("ancestorsize", e.GetSizeWithAncestors());
-    info.pushKV("wtxid", e.GetTx().GetWitnessHash().ToString());
+    const CTransaction& tx = e.GetTx();
+    MempoolEntrySnapshot snap{
+        .txid = tx.GetHash(),
+        .wtxid = tx.GetWitnessHash(),
+        .vsize = e.GetTxSize(),
+        .weight = e.GetTxWeight(),
+        .time = e.GetTime(),
+        .height = e.GetHeight(),
+        .descendant_count = e.GetCountWithDescendants(),
+        .descendant_size = e.GetSizeWithDescendants(),
+        .ancestor_count = e.GetCountWithAncestors(),
+        .ancestor_size = e.GetSizeWithAncestors(),
+        .fee = e.GetFee(),
+        .modified_fee = e.GetModifiedFee(),
+        .ancestor_fees = e.GetModFeesWithAncestors(),
+        .descendant_fees = e.GetModFeesWithDescendants(),
+        .depends = {},
+        .spent_by = {},
+        .bip125_replaceable = false,
+        .unbroadcast = pool.IsUnbroadcastTx(tx.GetHash()),
+    };
+
+    for (const CTxIn& txin : tx.vin) {
+        if (pool.exists(GenTxid::Txid(txin.prevout.hash))) {
+            snap.depends.push_back(txin.prevout.hash);
+        }
+    }
+    std::sort(snap.depends.begin(), snap.depends.end());
+    snap.depends.erase(std::unique(snap.depends.begin(), snap.depends.end()), snap.depends.end());
+
+    snap.spent_by.reserve(e.GetMemPoolChildrenConst().size());
+    for (const CTxMemPoolEntry& child : e.GetMemPoolChildrenConst()) {
+        snap.spent_by.push_back(child.GetTx().GetHash());
+    }
+
+    // Add opt-in RBF status
+    RBFTransactionState rbfState = IsRBFOptIn(tx, pool);
+    if (rbfState == RBFTransactionState::UNKNOWN) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Transaction is not in mempool");
+    } else if (rbfState == RBFTransactionState::REPLACEABLE_BIP125) {
+        snap.bip125_replaceable = true;
+    }
+    return snap;
+}
+
+static UniValue entryToJSON(const MempoolEntrySnapshot& e)
+{
+    UniValue info(UniValue::VOBJ);
+    info.pushKV("vsize", e.vsize);
+    info.pushKV("weight", e.weight);
+    info.pushKV("time", count_seconds(e.time));
+    info.pushKV("height", (int)e.height);
+    info.pushKV("descendantcount", e.descendant_count);
+    info.pushKV("descendantsize", e.descendant_size);
+    info.pushKV("ancestorcount", e.ancestor_count);
+    info.pushKV("ancestorsize", e.ancestor_size);
+    info.pushKV("wtxid", e.wtxid.ToString());
 
     UniValue fees(UniValue::VOBJ);
-    fees.pushKV("base", ValueFromAmount(e.GetFee()));
-    fees.pushKV("modified", ValueFromAmount(e.GetModifiedFee()));
-    fees.pushKV("ancestor", ValueFromAmount(e.GetModFeesWithAncestors()));
-    fees.pushKV("descendant", ValueFromAmount(e.GetModFeesWithDescendants()));
+    fees.pushKV("base", ValueFromAmount(e.fee));
+    fees.pushKV("modified", ValueFromAmount(e.modified_fee));
+    fees.pushKV("ancestor", ValueFromAmount(e.ancestor_fees));
+    fees.pushKV("descendant", ValueFromAmount(e.descendant_fees));
     info.pushKV("fees", std::move(fees));
 
-    const CTransaction& tx = e.GetTx();
-    std::set<std::string> setDepends;
-    for (const CTxIn& txin : tx.vin)
-    {
-        if (pool.exists(GenTxid::Txid(txin.prevout.hash)))
-            setDepends.insert(txin.prevout.hash.ToString());
+    // Sorted by hex string, as before the snapshot was introduced.
+    std::vector<std::string> depends_hex;
+    depends_hex.reserve(e.depends.size());
+    for (const Txid& dep : e.depends) {
+        depends_hex.push_back(dep.ToString());
     }
-
+    std::sort(depends_hex.begin(), depends_hex.end());
     UniValue depends(UniValue::VARR);
-    for (const std::string& dep : setDepends)
-    {
-        depends.push_back(dep);
+    for (std::string& dep : depends_hex) {
+        depends.push_back(std::move(dep));
     }
-
     info.pushKV("depends", std::move(depends));
 
     UniValue spent(UniValue::VARR);
-    for (const CTxMemPoolEntry& child : e.GetMemPoolChildrenConst()) {
-        spent.push_back(child.GetTx().GetHash().ToString());
+    for (const Txid& child : e.spent_by) {
+        spent.push_back(child.ToString());
     }
-
     info.pushKV("spentby", std::move(spent));
 
-    // Add opt-in RBF status
-    bool rbfStatus = false;
-    RBFTransactionState rbfState = IsRBFOptIn(tx, pool);
-    if (rbfState == RBFTransactionState::UNKNOWN) {
-        throw JSONRPCError(RPC_MISC_ERROR, "Transaction is not in mempool");
-    } else if (rbfState == RBFTransactionState::REPLACEABLE_BIP125) {
-        rbfStatus = true;
+    info.pushKV("bip125-replaceable", e.bip125_replaceable);
+    info.pushKV("unbroadcast", e.unbroadcast);
+    return info;
+}
+
+/** Build a txid-keyed JSON object from entry snapshots. */
+static UniValue EntriesToJSON(const std::vector<MempoolEntrySnapshot>& snapshots)
+{
+    UniValue o(UniValue::VOBJ);
+    for (const MempoolEntrySnapshot& e : snapshots) {
+        // Mempool has unique entries so there is no advantage in using
+        // UniValue::pushKV, which checks if the key already exists in O(N).
+        // UniValue::pushKVEnd is used instead which currently is O(1).
+        o.pushKVEnd(e.txid.ToString(), entryToJSON(e));
     }
+    return o;
+}
 
-    info.pushKV("bip125-replaceable", rbfStatus);
-    info.pushKV("unbroadcast", pool.IsUnbroadcastTx(tx.GetHash()));
+/** Build a JSON array of txids; the hex encoding happens after pool.cs is released. */
+static UniValue TxidsToJSON(const std::vector<Txid>& txids)
+{
+    UniValue a(UniValue::VARR);
+    for (const Txid& txid : txids) {
+        a.push_back(txid.ToString());
+    }
+    return a;
 }
 
 UniValue MempoolToJSON(const CTxMemPool& pool, bool verbose, bool include_mempool_sequence)
@@ -342,27 +435,29 @@ UniValue MempoolToJSON(const CTxMemPool& pool, bool verbose, bool include_mempoo
         if (include_mempool_sequence) {
             throw JSONRPCError(RPC_INVALID_PARAMETER, "Verbose results cannot contain mempool sequence values.");
         }
-        LOCK(pool.cs);
-        UniValue o(UniValue::VOBJ);
-        for (const CTxMemPoolEntry& e : pool.entryAll()) {
-            UniValue info(UniValue::VOBJ);
-            entryToJSON(pool, info, e);
-            // Mempool has unique entries so there is no advantage in using
-            // UniValue::pushKV, which checks if the key already exists in O(N).
-            // UniValue::pushKVEnd is used instead which currently is O(1).
-            o.pushKVEnd(e.GetTx().GetHash().ToString(), std::move(info));
+        std::vector<MempoolEntrySnapshot> snapshots;
+        {
+            LOCK(pool.cs);
+            const auto entries{pool.entryAll()};
+            snapshots.reserve(entries.size());
+            for (const CTxMemPoolEntry& e : entries) {
+                snapshots.push_back(SnapshotEntry(pool, e));
+            }
         }
-        return o;
+        return EntriesToJSON(snapshots);
     } else {
-        UniValue a(UniValue::VARR);
+        std::vector<Txid> txids;
         uint64_t mempool_sequence;
         {
             LOCK(pool.cs);
-            for (const CTxMemPoolEntry& e : pool.entryAll()) {
-                a.push_back(e.GetTx().GetHash().ToString());
+            const auto entries{pool.entryAll()};
+            txids.reserve(entries.size());
+            for (const CTxMemPoolEntry& e : entries) {
+                txids.push_back(e.GetTx().GetHash());
             }
             mempool_sequence = pool.GetSequence();
         }
+        UniValue a{TxidsToJSON(txids)};
         if (!include_mempool_sequence) {
             return a;
         } else {
@@ -455,32 +550,27 @@ static RPCHelpMan getmempoolancestors()
     uint256 hash = ParseHashV(request.params[0], "parameter 1");
 
     const CTxMemPool& mempool = EnsureAnyMemPool(request.context);
-    LOCK(mempool.cs);
-
-    const auto entry{mempool.GetEntry(Txid::FromUint256(hash))};
-    if (entry == nullptr) {
-        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Transaction not in mempool");
-    }
-
-    auto ancestors{mempool.AssumeCalculateMemPoolAncestors(self.m_name, *entry, CTxMemPool::Limits::NoLimits(), /*fSearchForParents=*/false)};
+    std::vector<Txid> txids;
+    std::vector<MempoolEntrySnapshot> snapshots;
+    {
+        LOCK(mempool.cs);
 
-    if (!fVerbose) {
-        UniValue o(UniValue::VARR);
-        for (CTxMemPool::txiter ancestorIt : ancestors) {
-            o.push_back(ancestorIt->GetTx().GetHash().ToString());
+        const auto entry{mempool.GetEntry(Txid::FromUint256(hash))};
+        if (entry == nullptr) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Transaction not in mempool");
         }
-        return o;
-    } else {
-        UniValue o(UniValue::VOBJ);
+
+        auto ancestors{mempool.AssumeCalculateMemPoolAncestors(self.m_name, *entry, CTxMemPool::Limits::NoLimits(), /*fSearchForParents=*/false)};
         for (CTxMemPool::txiter ancestorIt : ancestors) {
-            const CTxMemPoolEntry &e = *ancestorIt;
-            const uint256& _hash = e.GetTx().GetHash();
-            UniValue info(UniValue::VOBJ);
-            entryToJSON(mempool, info, e);
-            o.pushKV(_hash.ToString(), std::move(info));
+            if (fVerbose) {
+                snapshots.push_back(SnapshotEntry(mempool, *ancestorIt));
+            } else {
+                txids.push_back(ancestorIt->GetTx().GetHash());
+            }
         }
-        return o;
     }
+
+    return fVerbose ? EntriesToJSON(snapshots) : TxidsToJSON(txids);
 },
     };
 }
@@ -516,36 +606,31 @@ static RPCHelpMan getmempooldescendants()
     uint256 hash = ParseHashV(request.params[0], "parameter 1");
 
     const CTxMemPool& mempool = EnsureAnyMemPool(request.context);
-    LOCK(mempool.cs);
-
-    const auto it{mempool.GetIter(hash)};
-    if (!it) {
-        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Transaction not in mempool");
-    }
-
-    CTxMemPool::setEntries setDescendants;
-    mempool.CalculateDescendants(*it, setDescendants);
-    // CTxMemPool::CalculateDescendants will include the given tx
-    setDescendants.erase(*it);
+    std::vector<Txid> txids;
+    std::vector<MempoolEntrySnapshot> snapshots;
+    {
+        LOCK(mempool.cs);
 
-    if (!fVerbose) {
-        UniValue o(UniValue::VARR);
-        for (CTxMemPool::txiter descendantIt : setDescendants) {
-            o.push_back(descendantIt->GetTx().GetHash().ToString());
+        const auto it{mempool.GetIter(hash)};
+        if (!it) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Transaction not in mempool");
         }
 
-        return o;
-    } else {
-        UniValue o(UniValue::VOBJ);
+        CTxMemPool::setEntries setDescendants;
+        mempool.CalculateDescendants(*it, setDescendants);
+        // CTxMemPool::CalculateDescendants will include the given tx
+        setDescendants.erase(*it);
+
         for (CTxMemPool::txiter descendantIt : setDescendants) {
-            const CTxMemPoolEntry &e = *descendantIt;
-            const uint256& _hash = e.GetTx().GetHash();
-            UniValue info(UniValue::VOBJ);
-            entryToJSON(mempool, info, e);
-            o.pushKV(_hash.ToString(), std::move(info));
+            if (fVerbose) {
+                snapshots.push_back(SnapshotEntry(mempool, *descendantIt));
+            } else {
+                txids.push_back(descendantIt->GetTx().GetHash());
+            }
         }
-        return o;
     }
+
+    return fVerbose ? EntriesToJSON(snapshots) : TxidsToJSON(txids);
 },
     };
 }
@@ -568,16 +653,16 @@ static RPCHelpMan getmempoolentry()
     uint256 hash = ParseHashV(request.params[0], "parameter 1");
 
     const CTxMemPool& mempool = EnsureAnyMemPool(request.context);
-    LOCK(mempool.cs);
-
-    const auto entry{mempool.GetEntry(Txid::FromUint256(hash))};
-    if (entry == nullptr) {
-        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Transaction not in mempool");
-    }
+    const MempoolEntrySnapshot snapshot{[&] {
+        LOCK(mempool.cs);
+        const auto entry{mempool.GetEntry(Txid::FromUint256(hash))};
+        if (entry == nullptr) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Transaction not in mempool");
+        }
+        return SnapshotEntry(mempool, *entry);
+    }()};
 
-    UniValue info(UniValue::VOBJ);
-    entryToJSON(mempool, info, *entry);
-    return info;
+    return entryToJSON(snapshot);
 },
     };
 }
@@ -642,18 +727,26 @@ static RPCHelpMan gettxspendingprevout()
             }
 
             const CTxMemPool& mempool = EnsureAnyMemPool(request.context);
-            LOCK(mempool.cs);
+            std::vector<std::optional<Txid>> spenders;
+            spenders.reserve(prevouts.size());
+            {
+                LOCK(mempool.cs);
+                for (const COutPoint& prevout : prevouts) {
+                    const CTransaction* spendingTx = mempool.GetConflictTx(prevout);
+                    spenders.push_back(spendingTx ? std::optional{spendingTx->GetHash()} : std::nullopt);
+                }
+            }
 
             UniValue result{UniValue::VARR};
 
-            for (const COutPoint& prevout : prevouts) {
+            for (size_t i = 0; i < prevouts.size(); ++i) {
+                const COutPoint& prevout = prevouts[i];
                 UniValue o(UniValue::VOBJ);
                 o.pushKV("txid", prevout.hash.ToString());
                 o.pushKV("vout", (uint64_t)prevout.n);
 
-                const CTransaction* spendingTx = mempool.GetConflictTx(prevout);
-                if (spendingTx != nullptr) {
-                    o.pushKV("spendingtxid", spendingTx->GetHash().ToString());
+                if (spenders[i]) {
+                    o.pushKV("spendingtxid", spenders[i]->ToString());
                 }
 
                 result.push_back(std::move(o));
@@ -683,6 +776,42 @@ UniValue MempoolInfoToJSON(const CTxMemPool& pool)
     return ret;
 }
 
+UniValue ProjectedBlocksToJSON(node::MempoolProjectionCache& cache, size_t nblocks)
+{
+    const auto projection{cache.Get()};
+    const size_t count{std::min(nblocks, projection->blocks.size())};
+
+    UniValue blocks(UniValue::VARR);
+    for (size_t i = 0; i < count; ++i) {
+        // When fewer blocks are requested than were projected, the last
+        // returned block holds all the remaining ones.
+        const node::ProjectedBlock& block{i + 1 == count ? projection->remainders[i] : projection->blocks[i]};
+        UniValue histogram(UniValue::VARR);
+        for (size_t b = 0; b < block.feerate_histogram.size(); ++b) {
+            if (block.feerate_histogram[b] == 0) continue;
+            UniValue bucket(UniValue::VARR);
+            bucket.push_back(node::PROJECTION_FEERATE_BUCKETS[b]);
+            bucket.push_back(block.feerate_histogram[b]);
+            histogram.push_back(std::move(bucket));
+        }
+        UniValue o(UniValue::VOBJ);
+        o.pushKV("vsize", block.vsize);
+        o.pushKV("weight", block.weight);
+        o.pushKV("tx_count", block.tx_count);
+        o.pushKV("fees", ValueFromAmount(block.fees));
+        o.pushKV("min_feerate", ValueFromAmount(block.min_feerate.GetFeePerK()));
+        o.pushKV("median_feerate", ValueFromAmount(block.median_feerate.GetFeePerK()));
+        o.pushKV("max_feerate", ValueFromAmount(block.max_feerate.GetFeePerK()));
+        o.pushKV("feerate_histogram", std::move(histogram));
+        blocks.push_back(std::move(o));
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("mempool_sequence", projection->mempool_sequence);
+    ret.pushKV("blocks", std::move(blocks));
+    return ret;
+}
+
 static RPCHelpMan getmempoolinfo()
 {
     return RPCHelpMan{"getmempoolinfo",
@@ -714,6 +843,57 @@ static RPCHelpMan getmempoolinfo()
     };
 }
 
+static RPCHelpMan getprojectedblocks()
+{
+    return RPCHelpMan{"getprojectedblocks",
+        "Returns a projection of the next blocks a miner would build from the current mempool, with a feerate histogram for each.\n"
+        "Transactions are selected by ancestor feerate like the block template code, ignoring sigop limits and finality.\n"
+        "The result is cached and may lag the mempool by up to " + ToString(Ticks<std::chrono::seconds>(node::PROJECTION_MAX_AGE)) + " seconds.",
+        {
+            {"nblocks", RPCArg::Type::NUM, RPCArg::Default{static_cast<int>(node::MAX_PROJECTED_BLOCKS)}, "Number of blocks to return (1-" + ToString(node::MAX_PROJECTED_BLOCKS) + "). The last block contains all remaining transactions."},
+        },
+        RPCResult{
+            RPCResult::Type::OBJ, "", "",
+            {
+                {RPCResult::Type::NUM, "mempool_sequence", "The mempool sequence value the projection was computed at"},
+                {RPCResult::Type::ARR, "blocks", "Projected blocks in mining order",
+                {
+                    {RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::NUM, "vsize", "Sum of the virtual sizes of the transactions"},
+                        {RPCResult::Type::NUM, "weight", "Sum of the weights of the transactions"},
+                        {RPCResult::Type::NUM, "tx_count", "Number of transactions"},
+                        {RPCResult::Type::STR_AMOUNT, "fees", "Total modified fees in " + CURRENCY_UNIT},
+                        {RPCResult::Type::STR_AMOUNT, "min_feerate", "Lowest package feerate in " + CURRENCY_UNIT + "/kvB"},
+                        {RPCResult::Type::STR_AMOUNT, "median_feerate", "Virtual-size weighted median package feerate in " + CURRENCY_UNIT + "/kvB"},
+                        {RPCResult::Type::STR_AMOUNT, "max_feerate", "Highest package feerate in " + CURRENCY_UNIT + "/kvB"},
+                        {RPCResult::Type::ARR, "feerate_histogram", "Non-empty feerate buckets",
+                        {
+                            {RPCResult::Type::ARR_FIXED, "", "",
+                            {
+                                {RPCResult::Type::NUM, "", "Bucket lower bound in " + CURRENCY_ATOM + "/vB"},
+                                {RPCResult::Type::NUM, "", "Virtual size of transactions in the bucket"},
+                            }},
+                        }},
+                    }},
+                }},
+            }},
+        RPCExamples{
+            HelpExampleCli("getprojectedblocks", "")
+            + HelpExampleCli("getprojectedblocks", "2")
+            + HelpExampleRpc("getprojectedblocks", "2")
+        },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const int nblocks{self.Arg<int>("nblocks")};
+    if (nblocks < 1 || static_cast<size_t>(nblocks) > node::MAX_PROJECTED_BLOCKS) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("nblocks must be between 1 and %u", node::MAX_PROJECTED_BLOCKS));
+    }
+    return ProjectedBlocksToJSON(EnsureMempoolProjection(EnsureAnyNodeContext(request.context)), nblocks);
+},
+    };
+}
+
 static RPCHelpMan importmempool()
 {
     return RPCHelpMan{
@@ -1024,6 +1204,7 @@ void RegisterMempoolRPCCommands(CRPCTable& t)
         {"blockchain", &getmempoolentry},
         {"blockchain", &gettxspendingprevout},
         {"blockchain", &getmempoolinfo},
+        {"blockchain", &getprojectedblocks},
         {"blockchain", &getrawmempool},
         {"blockchain", &importmempool},
         {"blockchain", &savemempool},
@@ -5,12 +5,20 @@
 #ifndef BITCOIN_RPC_MEMPOOL_H
 #define BITCOIN_RPC_MEMPOOL_H
 
+#include <cstddef>
+
 class CTxMemPool;
 class UniValue;
+namespace node {
+class MempoolProjectionCache;
+} // namespace node
 
 /** Mempool information to JSON */
 UniValue MempoolInfoToJSON(const CTxMemPool& pool);
 
+/** Projected next blocks (see node::MempoolProjectionCache) to JSON */
+UniValue ProjectedBlocksToJSON(node::MempoolProjectionCache& cache, size_t nblocks);
+
 /** Mempool to JSON */
 UniValue MempoolToJSON(const CTxMemPool& pool, bool verbose = false, bool include_mempool_sequence = false);
 
@@ -278,6 +278,8 @@ void CRPCTable::appendCommand(const std::string& name, const CRPCCommand* pcmd)
     CHECK_NONFATAL(!IsRPCRunning()); // Only add commands before rpc is running
 
     mapCommands[name].push_back(pcmd);
+    m_method_latency.try_emplace(name);
+    m_method_recent_latency.try_emplace(name, -1);
 }
 
 bool CRPCTable::removeCommand(const std::string& name, const CRPCCommand* pcmd)
@@ -498,6 +500,30 @@ static bool ExecuteCommands(const std::vector<const CRPCCommand*>& commands, con
     return false;
 }
 
+void CRPCTable::RecordMethodLatency(const std::string& name, SteadyClock::duration duration) const
+{
+    auto it{m_method_latency.find(name)};
+    if (it != m_method_latency.end()) it->second.Record(Ticks<std::chrono::microseconds>(duration));
+
+    auto recent{m_method_recent_latency.find(name)};
+    if (recent == m_method_recent_latency.end()) return;
+    const int64_t sample{Ticks<std::chrono::microseconds>(duration)};
+    int64_t average{recent->second.load(std::memory_order_relaxed)};
+    int64_t updated;
+    do {
+        updated = average < 0 ? sample : average + (sample - average) / RPC_LATENCY_AVERAGE_CALLS;
+    } while (!recent->second.compare_exchange_weak(average, updated, std::memory_order_relaxed));
+}
+
+std::optional<std::chrono::microseconds> CRPCTable::GetRecentMethodLatency(const std::string& name) const
+{
+    const auto it{m_method_recent_latency.find(name)};
+    if (it == m_method_recent_latency.end()) return std::nullopt;
+    const int64_t average{it->second.load(std::memory_order_relaxed)};
+    if (average < 0) return std::nullopt;
+    return std::chrono::microseconds{average};
+}
+
 UniValue CRPCTable::execute(const JSONRPCRequest &request) const
 {
     // Return immediately if in warmup
@@ -511,7 +537,16 @@ UniValue CRPCTable::execute(const JSONRPCRequest &request) const
     auto it = mapCommands.find(request.strMethod);
     if (it != mapCommands.end()) {
         UniValue result;
-        if (ExecuteCommands(it->second, request, result)) {
+        const auto time_start{SteadyClock::now()};
+        bool handled;
+        try {
+            handled = ExecuteCommands(it->second, request, result);
+        } catch (...) {
+            RecordMethodLatency(it->first, SteadyClock::now() - time_start);
+            throw;
+        }
+        RecordMethodLatency(it->first, SteadyClock::now() - time_start);
+        if (handled) {
             return result;
         }
     }
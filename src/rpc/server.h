@@ -8,14 +8,22 @@
 
 #include <rpc/request.h>
 #include <rpc/util.h>
+#include <util/latencyhistogram.h>
+#include <util/time.h>
 
+#include <atomic>
+#include <chrono>
 #include <functional>
 #include <map>
+#include <optional>
 #include <stdint.h>
 #include <string>
 
 #include <univalue.h>
 
+/** Number of calls over which CRPCTable::GetRecentMethodLatency() averages, roughly */
+static constexpr int64_t RPC_LATENCY_AVERAGE_CALLS{8};
+
 class CRPCCommand;
 
 namespace RPCServer
@@ -133,6 +141,14 @@ class CRPCTable
 {
 private:
     std::map<std::string, std::vector<const CRPCCommand*>> mapCommands;
+    //! Execution time of each method in microseconds. Entries are only added
+    //! along with commands, so the map itself does not change while RPC is running.
+    mutable std::map<std::string, LatencyHistogram> m_method_latency;
+    //! Moving average of the execution time of each method in microseconds,
+    //! -1 before the first call. Same keys as m_method_latency.
+    mutable std::map<std::string, std::atomic<int64_t>> m_method_recent_latency;
+
+    void RecordMethodLatency(const std::string& name, SteadyClock::duration duration) const;
 public:
     CRPCTable();
     std::string help(const std::string& name, const JSONRPCRequest& helpreq) const;
@@ -170,6 +186,20 @@ public:
      */
     void appendCommand(const std::string& name, const CRPCCommand* pcmd);
     bool removeCommand(const std::string& name, const CRPCCommand* pcmd);
+
+    /**
+     * Execution time of each registered method, in microseconds, including
+     * calls that failed. Safe to read concurrently with execute().
+     */
+    const std::map<std::string, LatencyHistogram>& GetMethodLatency() const { return m_method_latency; }
+
+    /**
+     * Exponentially weighted moving average of the execution time of a
+     * method, in which each call weighs 1/RPC_LATENCY_AVERAGE_CALLS. Unlike
+     * the histogram it follows a method that became slower or faster within a
+     * few calls. std::nullopt if the method is unknown or was never called.
+     */
+    std::optional<std::chrono::microseconds> GetRecentMethodLatency(const std::string& name) const;
 };
 
 bool IsDeprecatedRPCEnabled(const std::string& method);
@@ -7,15 +7,18 @@
 #include <common/args.h>
 #include <net_processing.h>
 #include <node/context.h>
+#include <node/mempool_projection.h>
 #include <policy/fees.h>
 #include <rpc/protocol.h>
 #include <rpc/request.h>
 #include <txmempool.h>
 #include <util/any.h>
+#include <util/check.h>
 #include <validation.h>
 
 #include <any>
 
+using node::MempoolProjectionCache;
 using node::NodeContext;
 
 NodeContext& EnsureAnyNodeContext(const std::any& context)
@@ -40,6 +43,12 @@ CTxMemPool& EnsureAnyMemPool(const std::any& context)
     return EnsureMemPool(EnsureAnyNodeContext(context));
 }
 
+MempoolProjectionCache& EnsureMempoolProjection(const NodeContext& node)
+{
+    EnsureMemPool(node);
+    return *CHECK_NONFATAL(node.mempool_projection);
+}
+
 
 BanMan& EnsureBanman(const NodeContext& node)
 {
@@ -16,6 +16,7 @@ class ChainstateManager;
 class PeerManager;
 class BanMan;
 namespace node {
+class MempoolProjectionCache;
 struct NodeContext;
 } // namespace node
 namespace interfaces {
@@ -25,6 +26,7 @@ class Mining;
 node::NodeContext& EnsureAnyNodeContext(const std::any& context);
 CTxMemPool& EnsureMemPool(const node::NodeContext& node);
 CTxMemPool& EnsureAnyMemPool(const std::any& context);
+node::MempoolProjectionCache& EnsureMempoolProjection(const node::NodeContext& node);
 BanMan& EnsureBanman(const node::NodeContext& node);
 BanMan& EnsureAnyBanman(const std::any& context);
 ArgsManager& EnsureArgsman(const node::NodeContext& node);
@@ -354,6 +354,46 @@ BOOST_AUTO_TEST_CASE(ReceiveWithExtraTransactions) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(ReceiveWithSiblingReconstruction) {
+    CTxMemPool& pool = *Assert(m_node.mempool);
+    TestMemPoolEntryHelper entry;
+    auto rand_ctx(FastRandomContext(uint256{42}));
+
+    CBlock block(BuildBlockTestCase(rand_ctx));
+    CBlock other_block(BuildBlockTestCase(rand_ctx));
+    const std::vector<CTransactionRef> extra_txn{block.vtx[1]};
+
+    LOCK2(cs_main, pool.cs);
+    pool.addUnchecked(entry.FromTx(block.vtx[2]));
+
+    // First peer's announcement resolves everything from mempool and extra_txn.
+    const CBlockHeaderAndShortTxIDs first_cmpctblock{block, rand_ctx.rand64()};
+    PartiallyDownloadedBlock first(&pool);
+    BOOST_CHECK(first.InitData(first_cmpctblock, extra_txn) == READ_STATUS_OK);
+    for (size_t i = 0; i < block.vtx.size(); ++i) BOOST_CHECK(first.IsTxAvailable(i));
+
+    pool.removeRecursive(*block.vtx[2], MemPoolRemovalReason::REPLACED);
+
+    // A second peer announces the same block with a different nonce. With the
+    // mempool and extra pool of no help, everything comes from the sibling.
+    const CBlockHeaderAndShortTxIDs second_cmpctblock{block, rand_ctx.rand64()};
+    PartiallyDownloadedBlock second(&pool);
+    BOOST_CHECK(second.InitData(second_cmpctblock, empty_extra_txn, &first) == READ_STATUS_OK);
+    for (size_t i = 0; i < block.vtx.size(); ++i) BOOST_CHECK(second.IsTxAvailable(i));
+
+    CBlock reconstructed;
+    BOOST_CHECK(second.FillBlock(reconstructed, {}) == READ_STATUS_OK);
+    BOOST_CHECK_EQUAL(reconstructed.GetHash(), block.GetHash());
+
+    // A reconstruction of a different block is ignored.
+    const CBlockHeaderAndShortTxIDs other_cmpctblock{other_block, rand_ctx.rand64()};
+    PartiallyDownloadedBlock other(&pool);
+    BOOST_CHECK(other.InitData(other_cmpctblock, empty_extra_txn, &first) == READ_STATUS_OK);
+    BOOST_CHECK(other.IsTxAvailable(0));
+    BOOST_CHECK(!other.IsTxAvailable(1));
+    BOOST_CHECK(!other.IsTxAvailable(2));
+}
+
 BOOST_AUTO_TEST_CASE(TransactionsRequestSerializationTest) {
     BlockTransactionsRequest req1;
     req1.blockhash = InsecureRand256();
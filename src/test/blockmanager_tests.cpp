@@ -2,12 +2,14 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <arith_uint256.h>
 #include <chain.h>
 #include <chainparams.h>
 #include <clientversion.h>
 #include <node/blockstorage.h>
 #include <node/context.h>
 #include <node/kernel_notifications.h>
+#include <pow.h>
 #include <script/solver.h>
 #include <primitives/block.h>
 #include <util/chaintype.h>
@@ -17,6 +19,9 @@
 #include <test/util/logging.h>
 #include <test/util/setup_common.h>
 
+#include <deque>
+
+using kernel::BlockTreeDB;
 using node::BLOCK_SERIALIZATION_HEADER_SIZE;
 using node::BlockManager;
 using node::KernelNotifications;
@@ -198,4 +203,92 @@ BOOST_AUTO_TEST_CASE(blockmanager_flush_block_file)
     BOOST_CHECK_EQUAL(read_block.nVersion, 2);
 }
 
+BOOST_AUTO_TEST_CASE(blockmanager_block_index_snapshot)
+{
+    constexpr int NUM_HEADERS{2'000};
+    const auto params{CreateChainParams(ArgsManager{}, ChainType::REGTEST)};
+    const fs::path db_path{m_path_root / "blocks_index"};
+    BlockTreeDB db{DBParams{.path = db_path, .cache_bytes = 1 << 20}};
+
+    std::vector<uint256> hashes;
+    hashes.reserve(NUM_HEADERS);
+    std::deque<CBlockIndex> written;
+    CBlockHeader header;
+    header.nTime = params->GenesisBlock().nTime;
+    header.nBits = params->GenesisBlock().nBits;
+    for (int height = 0; height < NUM_HEADERS; ++height) {
+        header.hashPrevBlock = height > 0 ? hashes.back() : uint256{};
+        header.hashMerkleRoot = ArithToUint256(height);
+        while (!CheckProofOfWork(header.GetHash(), header.nBits, params->GetConsensus())) ++header.nNonce;
+        hashes.push_back(header.GetHash());
+        CBlockIndex& index{written.emplace_back(header)};
+        index.phashBlock = &hashes.back();
+        index.pprev = height > 0 ? &written[height - 1] : nullptr;
+        index.nHeight = height;
+        index.nTx = height + 1;
+        index.nFile = 1;
+        // Only some entries store a position, which the snapshot must not keep for the others.
+        if (height % 2) {
+            index.nStatus = BLOCK_HAVE_DATA;
+            index.nDataPos = height;
+        }
+    }
+    std::vector<const CBlockIndex*> blockinfo;
+    for (const CBlockIndex& index : written) blockinfo.push_back(&index);
+    BOOST_REQUIRE(db.WriteBatchSync({}, 0, blockinfo));
+
+    node::BlockMap loaded;
+    const auto insert_block_index{[&](const uint256& hash) -> CBlockIndex* {
+        if (hash.IsNull()) return nullptr;
+        const auto [it, inserted]{loaded.try_emplace(hash)};
+        if (inserted) it->second.phashBlock = &it->first;
+        return &it->second;
+    }};
+    LOCK(cs_main);
+    const auto load{[&] {
+        loaded.clear();
+        BOOST_REQUIRE(db.LoadBlockIndexGuts(params->GetConsensus(), insert_block_index, *Assert(m_node.shutdown)));
+    }};
+    const auto check_loaded{[&] {
+        BOOST_REQUIRE_EQUAL(loaded.size(), size_t{NUM_HEADERS});
+        for (int height = 0; height < NUM_HEADERS; ++height) {
+            const CBlockIndex& index{loaded.at(hashes[height])};
+            BOOST_CHECK_EQUAL(index.nHeight, height);
+            BOOST_CHECK(index.pprev == (height > 0 ? &loaded.at(hashes[height - 1]) : nullptr));
+            BOOST_CHECK_EQUAL(index.nTx, unsigned(height + 1));
+            BOOST_CHECK_EQUAL(index.nStatus, height % 2 ? uint32_t{BLOCK_HAVE_DATA} : 0U);
+            BOOST_CHECK_EQUAL(index.nFile, height % 2 ? 1 : 0);
+            BOOST_CHECK_EQUAL(index.nDataPos, height % 2 ? unsigned(height) : 0U);
+            BOOST_CHECK_EQUAL(index.GetBlockHeader().GetHash(), hashes[height]);
+        }
+    }};
+
+    // From the database
+    load();
+    check_loaded();
+
+    // From the snapshot, which loads the same index even though an entry was
+    // erased from the database behind its back.
+    BOOST_REQUIRE(db.WriteBlockIndexSnapshot(blockinfo));
+    BOOST_CHECK(fs::exists(fs::path{db_path} += ".snapshot"));
+    BOOST_REQUIRE(db.Erase(std::make_pair(uint8_t{'b'}, hashes.back())));
+    load();
+    check_loaded();
+
+    // Any write to the block index makes the snapshot stale.
+    BOOST_REQUIRE(db.WriteBatchSync({}, 0, {}));
+    load();
+    BOOST_CHECK_EQUAL(loaded.size(), size_t{NUM_HEADERS - 1});
+
+    // A corrupted snapshot is ignored.
+    BOOST_REQUIRE(db.WriteBlockIndexSnapshot(blockinfo));
+    {
+        AutoFile file{fsbridge::fopen(fs::path{db_path} += ".snapshot", "r+b")};
+        file.seek(-1, SEEK_END);
+        file << uint8_t{0xff};
+    }
+    load();
+    BOOST_CHECK_EQUAL(loaded.size(), size_t{NUM_HEADERS - 1});
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -1089,6 +1089,35 @@ BOOST_AUTO_TEST_CASE(ccoins_flush_behavior)
     }
 }
 
+BOOST_AUTO_TEST_CASE(ccoins_flush_partial_batches)
+{
+    // A tiny batch size makes the flush go through many pipelined partial
+    // batches.
+    CCoinsViewDB base{{.path = "test", .cache_bytes = 1 << 23, .memory_only = true}, {.batch_write_bytes = 1 << 10}};
+    CCoinsViewCache cache{&base};
+    std::vector<COutPoint> outpoints;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        outpoints.emplace_back(Txid::FromUint256(InsecureRand256()), i);
+        Coin coin{CTxOut{InsecureRandMoneyAmount(), CScript() << ToByteVector(InsecureRand256())}, /*nHeightIn=*/1, /*fCoinBaseIn=*/false};
+        cache.AddCoin(outpoints.back(), std::move(coin), /*possible_overwrite=*/false);
+    }
+    const uint256 first_block{InsecureRand256()};
+    cache.SetBestBlock(first_block);
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK_EQUAL(base.GetBestBlock(), first_block);
+    BOOST_CHECK(base.GetHeadBlocks().empty());
+    for (const auto& outpoint : outpoints) BOOST_CHECK(base.HaveCoin(outpoint));
+
+    // Spend every other coin and flush again.
+    for (size_t i = 0; i < outpoints.size(); i += 2) BOOST_CHECK(cache.SpendCoin(outpoints[i]));
+    const uint256 second_block{InsecureRand256()};
+    cache.SetBestBlock(second_block);
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK_EQUAL(base.GetBestBlock(), second_block);
+    BOOST_CHECK(base.GetHeadBlocks().empty());
+    for (size_t i = 0; i < outpoints.size(); ++i) BOOST_CHECK_EQUAL(base.HaveCoin(outpoints[i]), i % 2 == 1);
+}
+
 BOOST_AUTO_TEST_CASE(coins_resource_is_used)
 {
     CCoinsMapMemoryResource resource;
@@ -838,6 +838,38 @@ BOOST_AUTO_TEST_CASE(chacha20_midblock)
     BOOST_CHECK(Span{block}.last(52) == Span{b3});
 }
 
+BOOST_AUTO_TEST_CASE(chacha20_multiblock)
+{
+    // Processing many blocks in one call (which uses the multi-block code
+    // path where available) must match processing them one at a time,
+    // including across a wrap of the 32-bit block counter.
+    const auto key = ParseHex<std::byte>("000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f");
+    for (uint32_t start : {0U, 0xfffffff0U, 0xfffffffdU}) {
+        for (size_t blocks : {3, 4, 7, 8, 9, 17, 37}) {
+            std::vector<std::byte> in(blocks * ChaCha20Aligned::BLOCKLEN);
+            for (size_t i = 0; i < in.size(); ++i) in[i] = std::byte(i * 13);
+            std::vector<std::byte> bulk(in.size()), blockwise(in.size());
+
+            ChaCha20Aligned bulk_ctx{key}, blockwise_ctx{key};
+            bulk_ctx.Seek({5, 0x1234}, start);
+            blockwise_ctx.Seek({5, 0x1234}, start);
+            bulk_ctx.Crypt(in, bulk);
+            for (size_t i = 0; i < blocks; ++i) {
+                blockwise_ctx.Crypt(Span{in}.subspan(i * ChaCha20Aligned::BLOCKLEN, ChaCha20Aligned::BLOCKLEN),
+                                    Span{blockwise}.subspan(i * ChaCha20Aligned::BLOCKLEN, ChaCha20Aligned::BLOCKLEN));
+            }
+            BOOST_CHECK(bulk == blockwise);
+
+            // Both contexts must have advanced their counter identically.
+            bulk_ctx.Keystream(bulk);
+            for (size_t i = 0; i < blocks; ++i) {
+                blockwise_ctx.Keystream(Span{blockwise}.subspan(i * ChaCha20Aligned::BLOCKLEN, ChaCha20Aligned::BLOCKLEN));
+            }
+            BOOST_CHECK(bulk == blockwise);
+        }
+    }
+}
+
 BOOST_AUTO_TEST_CASE(poly1305_testvector)
 {
     // RFC 7539, section 2.5.2.
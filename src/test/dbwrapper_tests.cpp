@@ -280,6 +280,34 @@ BOOST_AUTO_TEST_CASE(existing_data_reindex)
     BOOST_CHECK_EQUAL(res3.ToString(), in2.ToString());
 }
 
+// Ensure that data stays readable when the tuning of a database changes.
+BOOST_AUTO_TEST_CASE(existing_data_retuned)
+{
+    fs::path ph = m_args.GetDataDirBase() / "existing_data_retuned";
+    fs::create_directories(ph);
+    std::vector<uint256> values(5000);
+    for (auto& value : values) value = InsecureRand256();
+
+    const DBTuning tunings[]{
+        {.bloom_filter = true},
+        {.bloom_filter = false, .block_size = 16 << 10},
+        {.bloom_filter = true, .block_size = 1 << 10, .max_file_size = 32 << 20},
+    };
+    for (size_t t = 0; t < std::size(tunings); ++t) {
+        // Compacting rewrites the existing table files with the new settings.
+        CDBWrapper dbw({.path = ph, .cache_bytes = 1 << 20, .tuning = tunings[t], .options = {.force_compact = t > 0}});
+        if (t == 0) {
+            for (uint32_t i = 0; i < values.size(); ++i) BOOST_CHECK(dbw.Write(i, values[i]));
+        }
+        for (uint32_t i = 0; i < values.size(); ++i) {
+            uint256 res;
+            BOOST_REQUIRE(dbw.Read(i, res));
+            BOOST_CHECK_EQUAL(res, values[i]);
+        }
+        BOOST_CHECK(!dbw.Exists(uint32_t(values.size())));
+    }
+}
+
 BOOST_AUTO_TEST_CASE(iterator_ordering)
 {
     fs::path ph = m_args.GetDataDirBase() / "iterator_ordering";
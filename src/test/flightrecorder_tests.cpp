@@ -0,0 +1,124 @@
+// Copyright (c) 2024 The Krepto core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <crypto/common.h>
+#include <test/util/setup_common.h>
+#include <util/flightrecorder.h>
+#include <util/fs.h>
+#include <util/readwritefile.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstring>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace flightrecorder;
+
+namespace {
+struct DecodedRecord {
+    uint16_t event;
+    uint32_t aux;
+    uint64_t a;
+    uint64_t b;
+};
+
+/** Read back the records of every used slot, oldest first. */
+std::vector<std::vector<DecodedRecord>> ReadRecords(const fs::path& path)
+{
+    const auto [ok, contents]{ReadBinaryFile(path)};
+    BOOST_REQUIRE(ok);
+    const auto* data{reinterpret_cast<const unsigned char*>(contents.data())};
+    BOOST_REQUIRE(contents.size() >= FILE_HEADER_SIZE);
+    BOOST_REQUIRE_EQUAL(std::memcmp(data, "KRFLTREC", 8), 0);
+    BOOST_REQUIRE_EQUAL(ReadLE32(data + 8), FORMAT_VERSION);
+    BOOST_REQUIRE_EQUAL(ReadLE32(data + 12), RECORD_SIZE);
+    const uint32_t threads{ReadLE32(data + 16)};
+    const uint32_t per_thread{ReadLE32(data + 20)};
+    BOOST_REQUIRE_EQUAL(contents.size(), FILE_HEADER_SIZE + threads * (SLOT_HEADER_SIZE + per_thread * RECORD_SIZE));
+
+    std::vector<std::vector<DecodedRecord>> ret;
+    for (uint32_t slot = 0; slot < threads; ++slot) {
+        const uint64_t count{ReadLE64(data + FILE_HEADER_SIZE + slot * SLOT_HEADER_SIZE)};
+        if (count == 0) continue;
+        const unsigned char* ring{data + FILE_HEADER_SIZE + threads * SLOT_HEADER_SIZE + slot * per_thread * RECORD_SIZE};
+        auto& records{ret.emplace_back()};
+        for (uint64_t i = count > per_thread ? count - per_thread : 0; i < count; ++i) {
+            const unsigned char* record{ring + (i % per_thread) * RECORD_SIZE};
+            records.push_back({ReadLE16(record + 8), ReadLE32(record + 12), ReadLE64(record + 16), ReadLE64(record + 24)});
+        }
+    }
+    return ret;
+}
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(flightrecorder_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(flightrecorder_disabled)
+{
+    BOOST_CHECK(!IsEnabled());
+    // Recording while stopped is a no-op.
+    Record(Event::MESSAGE_SEND, 1, 2, 3);
+}
+
+BOOST_AUTO_TEST_CASE(flightrecorder_roundtrip)
+{
+    const fs::path path{m_args.GetDataDirBase() / "flightrecorder.dat"};
+    constexpr size_t PER_THREAD{16};
+    BOOST_REQUIRE(Start(path, PER_THREAD));
+    BOOST_CHECK(IsEnabled());
+
+    // One thread wraps around its ring, the others do not.
+    for (uint64_t i = 0; i < PER_THREAD + 5; ++i) {
+        Record(Event::CONNECT_PHASE, static_cast<uint32_t>(ConnectPhase::CONNECT_BLOCK), i, 2 * i);
+    }
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < 3; ++t) {
+        threads.emplace_back([t] {
+            for (uint64_t i = 0; i < 4; ++i) Record(Event::MESSAGE_RECV, t, i, PackMessageType("headers"));
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    Stop();
+    BOOST_CHECK(!IsEnabled());
+    Record(Event::MESSAGE_SEND, 0, 0, 0);
+
+    const auto slots{ReadRecords(path)};
+    BOOST_REQUIRE_EQUAL(slots.size(), 4U);
+    std::map<uint32_t, size_t> per_sender;
+    for (const auto& records : slots) {
+        if (records.front().event == uint16_t(Event::CONNECT_PHASE)) {
+            BOOST_REQUIRE_EQUAL(records.size(), PER_THREAD);
+            for (size_t i = 0; i < records.size(); ++i) {
+                BOOST_CHECK_EQUAL(records[i].a, i + 5);
+                BOOST_CHECK_EQUAL(records[i].b, 2 * (i + 5));
+            }
+            continue;
+        }
+        for (const auto& record : records) {
+            BOOST_CHECK_EQUAL(record.event, uint16_t(Event::MESSAGE_RECV));
+            BOOST_CHECK_EQUAL(record.b, PackMessageType("headers"));
+            ++per_sender[record.aux];
+        }
+    }
+    BOOST_CHECK((per_sender == std::map<uint32_t, size_t>{{0, 4}, {1, 4}, {2, 4}}));
+
+    // Restarting keeps the previous recording.
+    BOOST_REQUIRE(Start(path, PER_THREAD));
+    Stop();
+    BOOST_CHECK_EQUAL(ReadRecords(fs::path{path} += ".old").size(), 4U);
+    BOOST_CHECK(ReadRecords(path).empty());
+}
+
+BOOST_AUTO_TEST_CASE(flightrecorder_pack_message_type)
+{
+    unsigned char expected[8]{'t', 'x', 0, 0, 0, 0, 0, 0};
+    BOOST_CHECK_EQUAL(PackMessageType("tx"), ReadLE64(expected));
+    std::memcpy(expected, "sendcmpc", 8);
+    BOOST_CHECK_EQUAL(PackMessageType("sendcmpct"), ReadLE64(expected));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
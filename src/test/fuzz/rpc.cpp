@@ -145,6 +145,7 @@ const std::vector<std::string> RPC_COMMANDS_SAFE_FOR_FUZZING{
     "getnodeaddresses",
     "getpeerinfo",
     "getprioritisedtransactions",
+    "getprojectedblocks",
     "getrawaddrman",
     "getrawmempool",
     "getrawtransaction",
@@ -152,6 +153,7 @@ const std::vector<std::string> RPC_COMMANDS_SAFE_FOR_FUZZING{
     "gettxout",
     "gettxoutsetinfo",
     "gettxspendingprevout",
+    "getvalidationtimings",
     "help",
     "invalidateblock",
     "joinpsbts",
@@ -0,0 +1,89 @@
+// Copyright (c) 2024 The Krepto core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <test/util/setup_common.h>
+#include <util/latencyhistogram.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <limits>
+#include <thread>
+#include <vector>
+
+BOOST_FIXTURE_TEST_SUITE(latencyhistogram_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(histogram_buckets)
+{
+    // Buckets are contiguous and ordered: every value lies in the bucket after
+    // the one containing its predecessor, or in the same one.
+    for (uint64_t value = 1; value < 1 << 16; ++value) {
+        const size_t index{LatencyHistogram::BucketIndex(value)};
+        BOOST_REQUIRE(value <= LatencyHistogram::BucketUpperBound(index));
+        BOOST_REQUIRE(value > LatencyHistogram::BucketUpperBound(index - 1));
+    }
+    // Small values are exact.
+    for (uint64_t value = 0; value < LatencyHistogram::SUB_BUCKETS; ++value) {
+        BOOST_CHECK_EQUAL(LatencyHistogram::BucketUpperBound(LatencyHistogram::BucketIndex(value)), value);
+    }
+    // Bucket width is bounded relative to the value.
+    for (uint64_t value : {uint64_t{1000}, uint64_t{123456789}, uint64_t{1} << 40, std::numeric_limits<uint64_t>::max() / 3}) {
+        const uint64_t upper{LatencyHistogram::BucketUpperBound(LatencyHistogram::BucketIndex(value))};
+        BOOST_CHECK(upper - value <= value / LatencyHistogram::SUB_BUCKETS);
+    }
+    const uint64_t max{std::numeric_limits<uint64_t>::max()};
+    BOOST_CHECK_EQUAL(LatencyHistogram::BucketIndex(max), LatencyHistogram::BUCKETS - 1);
+    BOOST_CHECK_EQUAL(LatencyHistogram::BucketUpperBound(LatencyHistogram::BUCKETS - 1), max);
+}
+
+BOOST_AUTO_TEST_CASE(histogram_percentiles)
+{
+    LatencyHistogram histogram;
+    BOOST_CHECK_EQUAL(histogram.GetSnapshot().Percentile(50), 0U);
+
+    for (uint64_t value = 1; value <= 1000; ++value) histogram.Record(value);
+    auto snapshot{histogram.GetSnapshot()};
+    BOOST_CHECK_EQUAL(snapshot.count, 1000U);
+    BOOST_CHECK_EQUAL(snapshot.sum, 500500U);
+    BOOST_CHECK_EQUAL(snapshot.max, 1000U);
+    BOOST_CHECK_EQUAL(snapshot.Percentile(0), 1U);
+    BOOST_CHECK_EQUAL(snapshot.Percentile(100), 1000U);
+    for (double percentile : {50.0, 90.0, 99.0, 99.9}) {
+        const uint64_t exact{static_cast<uint64_t>(percentile * 10)};
+        const uint64_t reported{snapshot.Percentile(percentile)};
+        BOOST_CHECK(reported >= exact);
+        BOOST_CHECK(reported <= exact + exact / LatencyHistogram::SUB_BUCKETS);
+    }
+
+    // A single outlier shows up at the top percentiles only.
+    histogram.Reset();
+    for (int i = 0; i < 999; ++i) histogram.Record(10);
+    histogram.Record(1'000'000);
+    snapshot = histogram.GetSnapshot();
+    BOOST_CHECK_EQUAL(snapshot.Percentile(99), 10U);
+    BOOST_CHECK_EQUAL(snapshot.Percentile(100), 1'000'000U);
+
+    histogram.Reset();
+    snapshot = histogram.GetSnapshot();
+    BOOST_CHECK_EQUAL(snapshot.count, 0U);
+    BOOST_CHECK_EQUAL(snapshot.max, 0U);
+    BOOST_CHECK_EQUAL(snapshot.Percentile(99), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(histogram_concurrent)
+{
+    LatencyHistogram histogram;
+    std::vector<std::thread> threads;
+    for (uint64_t t = 0; t < 4; ++t) {
+        threads.emplace_back([&histogram, t] {
+            for (uint64_t i = 0; i < 10000; ++i) histogram.Record(t * 10000 + i);
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    const auto snapshot{histogram.GetSnapshot()};
+    BOOST_CHECK_EQUAL(snapshot.count, 40000U);
+    BOOST_CHECK_EQUAL(snapshot.sum, 40000U * 39999 / 2);
+    BOOST_CHECK_EQUAL(snapshot.max, 39999U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
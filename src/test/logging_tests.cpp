@@ -9,8 +9,10 @@
 #include <util/string.h>
 
 #include <chrono>
+#include <cstdio>
 #include <fstream>
 #include <iostream>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -280,4 +282,82 @@ BOOST_FIXTURE_TEST_CASE(logging_Conf, LogSetup)
     }
 }
 
+BOOST_FIXTURE_TEST_CASE(logging_async, LogSetup)
+{
+    // Several threads log concurrently through the asynchronous writer.
+    constexpr int THREADS{4};
+    constexpr int LINES{500};
+    LogInstance().StartAsyncWriter();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([t] {
+            for (int i = 0; i < LINES; ++i) LogInfo("async %d %d\n", t, i);
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    // Flood the queue of this thread so that some records may be dropped.
+    constexpr int FLOOD{int(BCLog::ASYNC_LOG_QUEUE_RECORDS) * 4};
+    for (int i = 0; i < FLOOD; ++i) LogInfo("flood %d\n", i);
+    LogInstance().StopAsyncWriter();
+
+    std::ifstream file{tmp_log_path};
+    std::vector<int> next(THREADS, 0);
+    int flood_written{0}, flood_prev{-1};
+    uint64_t dropped{0};
+    for (std::string line; std::getline(file, line);) {
+        int a, b;
+        if (std::sscanf(line.c_str(), "async %d %d", &a, &b) == 2) {
+            // Each thread's records are written completely and in order.
+            BOOST_REQUIRE(a >= 0 && a < THREADS);
+            BOOST_CHECK_EQUAL(b, next[a]++);
+        } else if (std::sscanf(line.c_str(), "flood %d", &a) == 1) {
+            BOOST_CHECK_GT(a, flood_prev);
+            flood_prev = a;
+            ++flood_written;
+        } else if (line.find("log messages dropped") != std::string::npos) {
+            dropped += std::stoull(line.substr(line.find(']') + 2));
+        }
+    }
+    for (int t = 0; t < THREADS; ++t) BOOST_CHECK_EQUAL(next[t], LINES);
+    // Every flood record was either written or counted as dropped.
+    BOOST_CHECK_EQUAL(flood_written + dropped, uint64_t(FLOOD));
+
+    // Once stopped, logging is synchronous again.
+    LogInfo("sync\n");
+    std::ifstream file2{tmp_log_path};
+    std::string last;
+    for (std::string line; std::getline(file2, line);) last = line;
+    BOOST_CHECK_EQUAL(last, "sync");
+}
+
+BOOST_FIXTURE_TEST_CASE(logging_async_order, LogSetup)
+{
+    // Records logged one after the other from different threads are written
+    // in that order, even when they are drained in different writer passes.
+    constexpr int THREADS{4};
+    constexpr int LINES{1000};
+    LogInstance().StartAsyncWriter();
+    StdMutex mutex;
+    int counter{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < LINES; ++i) {
+                StdLockGuard lock(mutex);
+                LogInfo("ordered %d\n", counter++);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    LogInstance().StopAsyncWriter();
+
+    std::ifstream file{tmp_log_path};
+    int next{0};
+    for (std::string line; std::getline(file, line);) {
+        int n;
+        if (std::sscanf(line.c_str(), "ordered %d", &n) == 1) BOOST_CHECK_EQUAL(n, next++);
+    }
+    BOOST_CHECK_EQUAL(next, THREADS * LINES);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
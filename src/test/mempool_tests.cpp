@@ -3,6 +3,8 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <common/system.h>
+#include <consensus/validation.h>
+#include <node/mempool_projection.h>
 #include <policy/policy.h>
 #include <test/util/txmempool.h>
 #include <txmempool.h>
@@ -84,6 +86,11 @@ BOOST_AUTO_TEST_CASE(MempoolRemoveTest)
         testPool.addUnchecked(entry.FromTx(txChild[i]));
         testPool.addUnchecked(entry.FromTx(txGrandChild[i]));
     }
+    // The statistics readable without the lock follow every change:
+    auto published{testPool.GetPublishedStats()};
+    BOOST_CHECK_EQUAL(published.count, testPool.size());
+    BOOST_CHECK_EQUAL(published.tx_size, testPool.GetTotalTxSize());
+    BOOST_CHECK_EQUAL(published.usage, testPool.DynamicMemoryUsage());
     // Remove Child[0], GrandChild[0] should be removed:
     poolSize = testPool.size();
     testPool.removeRecursive(CTransaction(txChild[0]), REMOVAL_REASON_DUMMY);
@@ -113,6 +120,10 @@ BOOST_AUTO_TEST_CASE(MempoolRemoveTest)
     testPool.removeRecursive(CTransaction(txParent), REMOVAL_REASON_DUMMY);
     BOOST_CHECK_EQUAL(testPool.size(), poolSize - 6);
     BOOST_CHECK_EQUAL(testPool.size(), 0U);
+    published = testPool.GetPublishedStats();
+    BOOST_CHECK_EQUAL(published.count, 0U);
+    BOOST_CHECK_EQUAL(published.tx_size, 0U);
+    BOOST_CHECK_EQUAL(published.usage, testPool.DynamicMemoryUsage());
 }
 
 template <typename name>
@@ -537,21 +548,21 @@ BOOST_AUTO_TEST_CASE(MempoolSizeLimitTest)
     pool.addUnchecked(entry.Fee(1100LL).FromTx(tx6));
     pool.addUnchecked(entry.Fee(9000LL).FromTx(tx7));
 
-    // we only require this to remove, at max, 2 txn, because it's not clear what we're really optimizing for aside from that
+    // tx7 pays for both tx5 and tx6, so the three of them form the lowest
+    // feerate chunk of the cluster and are evicted together
     pool.TrimToSize(pool.DynamicMemoryUsage() - 1);
     BOOST_CHECK(pool.exists(GenTxid::Txid(tx4.GetHash())));
-    BOOST_CHECK(pool.exists(GenTxid::Txid(tx6.GetHash())));
+    BOOST_CHECK(!pool.exists(GenTxid::Txid(tx5.GetHash())));
+    BOOST_CHECK(!pool.exists(GenTxid::Txid(tx6.GetHash())));
     BOOST_CHECK(!pool.exists(GenTxid::Txid(tx7.GetHash())));
 
-    if (!pool.exists(GenTxid::Txid(tx5.GetHash())))
-        pool.addUnchecked(entry.Fee(1000LL).FromTx(tx5));
-    pool.addUnchecked(entry.Fee(9000LL).FromTx(tx7));
+    pool.addUnchecked(entry.Fee(1000LL).FromTx(tx5));
+    pool.addUnchecked(entry.Fee(1100LL).FromTx(tx6));
 
-    pool.TrimToSize(pool.DynamicMemoryUsage() / 2); // should maximize mempool size by only removing 5/7
+    pool.TrimToSize(pool.DynamicMemoryUsage() - 1); // without tx7 each is its own chunk, so only tx5 goes
     BOOST_CHECK(pool.exists(GenTxid::Txid(tx4.GetHash())));
     BOOST_CHECK(!pool.exists(GenTxid::Txid(tx5.GetHash())));
     BOOST_CHECK(pool.exists(GenTxid::Txid(tx6.GetHash())));
-    BOOST_CHECK(!pool.exists(GenTxid::Txid(tx7.GetHash())));
 
     pool.addUnchecked(entry.Fee(1000LL).FromTx(tx5));
     pool.addUnchecked(entry.Fee(9000LL).FromTx(tx7));
@@ -804,4 +815,221 @@ BOOST_AUTO_TEST_CASE(MempoolAncestryTestsDiamond)
     BOOST_CHECK_EQUAL(descendants, 4ULL);
 }
 
+BOOST_AUTO_TEST_CASE(MempoolEntryLinksTest)
+{
+    TestMemPoolEntryHelper entry;
+    const CTxMemPoolEntry e0{entry.FromTx(make_tx(/*output_values=*/{1 * COIN}))};
+    const CTxMemPoolEntry e1{entry.FromTx(make_tx(/*output_values=*/{2 * COIN}))};
+    const CTxMemPoolEntry e2{entry.FromTx(make_tx(/*output_values=*/{3 * COIN}))};
+    const CTxMemPoolEntry e3{entry.FromTx(make_tx(/*output_values=*/{4 * COIN}))};
+
+    // The links must iterate in the same order as a std::set with the same comparator.
+    CTxMemPoolEntry::Parents expected;
+    CTxMemPoolEntry::Links links;
+    BOOST_CHECK(links.empty());
+    BOOST_CHECK(!links.erase(e0));
+    const auto check_order = [&] {
+        BOOST_REQUIRE_EQUAL(links.size(), expected.size());
+        BOOST_CHECK(std::equal(links.begin(), links.end(), expected.begin(),
+                               [](const auto& a, const auto& b) { return &a.get() == &b.get(); }));
+    };
+
+    // Insert in an order that differs from the hash order, past the two inline links.
+    for (const auto* e : {&e2, &e0, &e3, &e1}) {
+        BOOST_CHECK(links.insert(*e));
+        expected.insert(*e);
+        check_order();
+    }
+    BOOST_CHECK(links.DynamicMemoryUsage() > 0);
+
+    // Duplicates are rejected and do not change the contents.
+    for (const auto* e : {&e0, &e1, &e2, &e3}) {
+        BOOST_CHECK(!links.insert(*e));
+        check_order();
+    }
+
+    // Erasing from the middle and the ends keeps the order; erasing twice fails.
+    for (const auto* e : {&e1, &e3, &e0}) {
+        BOOST_CHECK(links.erase(*e));
+        BOOST_CHECK(!links.erase(*e));
+        expected.erase(*e);
+        check_order();
+    }
+    BOOST_CHECK(links.erase(e2));
+    BOOST_CHECK(links.empty());
+
+    // An entry that is never inserted is never found, even among others.
+    BOOST_CHECK(links.insert(e0));
+    BOOST_CHECK(links.insert(e2));
+    BOOST_CHECK(!links.erase(e1));
+    BOOST_CHECK_EQUAL(links.size(), 2U);
+}
+
+BOOST_AUTO_TEST_CASE(MempoolLinearizeClusterTest)
+{
+    CTxMemPool& pool = *Assert(m_node.mempool);
+    LOCK2(::cs_main, pool.cs);
+    TestMemPoolEntryHelper entry;
+
+    // [ta] <- [tb] (CPFP child paying for its parent)
+    //   ^---- [tc] (low fee child)
+    CTransactionRef ta = make_tx(/*output_values=*/{5 * COIN, 5 * COIN});
+    CTransactionRef tb = make_tx(/*output_values=*/{4 * COIN}, /*inputs=*/{ta}, /*input_indices=*/{0});
+    CTransactionRef tc = make_tx(/*output_values=*/{4 * COIN}, /*inputs=*/{ta}, /*input_indices=*/{1});
+    CTransactionRef unrelated = make_tx(/*output_values=*/{1 * COIN});
+    BOOST_CHECK(!pool.LinearizeCluster(ta->GetHash(), /*max_iterations=*/100));
+
+    pool.addUnchecked(entry.Fee(0LL).FromTx(ta));
+    pool.addUnchecked(entry.Fee(20000LL).FromTx(tb));
+    pool.addUnchecked(entry.Fee(100LL).FromTx(tc));
+    pool.addUnchecked(entry.Fee(1000LL).FromTx(unrelated));
+
+    for (const auto& tx : {ta, tb, tc}) {
+        const auto lin{pool.LinearizeCluster(tx->GetHash(), /*max_iterations=*/100)};
+        BOOST_REQUIRE(lin);
+        BOOST_CHECK(lin->optimal);
+        BOOST_REQUIRE_EQUAL(lin->txs.size(), 3U);
+        BOOST_CHECK(lin->txs[0]->GetSharedTx() == ta);
+        BOOST_CHECK(lin->txs[1]->GetSharedTx() == tb);
+        BOOST_CHECK(lin->txs[2]->GetSharedTx() == tc);
+        BOOST_REQUIRE_EQUAL(lin->chunk_sizes.size(), 2U);
+        BOOST_CHECK_EQUAL(lin->chunk_sizes[0], 2U);
+        BOOST_CHECK_EQUAL(lin->chunk_sizes[1], 1U);
+        BOOST_CHECK_EQUAL(lin->chunk_feerates[0].fee, 20000);
+        BOOST_CHECK_EQUAL(lin->chunk_feerates[1].fee, 100);
+    }
+
+    const auto lin{pool.LinearizeCluster(unrelated->GetHash(), /*max_iterations=*/100)};
+    BOOST_REQUIRE(lin);
+    BOOST_CHECK_EQUAL(lin->txs.size(), 1U);
+}
+
+BOOST_AUTO_TEST_CASE(MempoolTrimDeterministicTest)
+{
+    CTxMemPool& pool = *Assert(m_node.mempool);
+    LOCK2(::cs_main, pool.cs);
+    TestMemPoolEntryHelper entry;
+
+    // [ta] <- [tb], [tc], [td]: children of the same size and fee, each its own
+    // chunk. Which of them is linearized last, and evicted, may depend neither
+    // on chance nor on the order they were added in.
+    CTransactionRef ta = make_tx(/*output_values=*/{1 * COIN, 1 * COIN, 1 * COIN});
+    std::vector<CTransactionRef> children;
+    for (uint32_t i = 0; i < 3; ++i) {
+        children.push_back(make_tx(/*output_values=*/{1 * COIN}, /*inputs=*/{ta}, /*input_indices=*/{i}));
+    }
+
+    std::optional<Txid> evicted;
+    for (const std::vector<size_t>& order : {std::vector<size_t>{0, 1, 2}, {2, 1, 0}, {1, 2, 0}, {2, 0, 1}}) {
+        pool.addUnchecked(entry.Fee(10000LL).FromTx(ta));
+        for (const size_t i : order) pool.addUnchecked(entry.Fee(1000LL).FromTx(children[i]));
+
+        pool.TrimToSize(pool.DynamicMemoryUsage() - 1);
+        BOOST_CHECK_EQUAL(pool.size(), 3U);
+        BOOST_CHECK(pool.exists(GenTxid::Txid(ta->GetHash())));
+        const auto it{std::find_if(children.begin(), children.end(), [&](const auto& tx) { return !pool.exists(GenTxid::Txid(tx->GetHash())); })};
+        BOOST_REQUIRE(it != children.end());
+        if (!evicted) evicted = (*it)->GetHash();
+        BOOST_CHECK(*evicted == (*it)->GetHash());
+
+        pool.removeRecursive(*ta, MemPoolRemovalReason::REPLACED);
+        BOOST_CHECK_EQUAL(pool.size(), 0U);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(MempoolProjectBlocksTest)
+{
+    CTxMemPool& pool = *Assert(m_node.mempool);
+    LOCK2(::cs_main, pool.cs);
+    TestMemPoolEntryHelper entry;
+
+    BOOST_CHECK(node::ProjectBlocks(pool, node::MAX_PROJECTED_BLOCKS).blocks.empty());
+
+    CTransactionRef ta = make_tx(/*output_values=*/{5 * COIN, 5 * COIN});
+    CTransactionRef tb = make_tx(/*output_values=*/{4 * COIN}, /*inputs=*/{ta}, /*input_indices=*/{0});
+    CTransactionRef tc = make_tx(/*output_values=*/{4 * COIN}, /*inputs=*/{ta}, /*input_indices=*/{1});
+    CTransactionRef unrelated = make_tx(/*output_values=*/{1 * COIN});
+    pool.addUnchecked(entry.Fee(0LL).FromTx(ta));
+    pool.addUnchecked(entry.Fee(20000LL).FromTx(tb));
+    pool.addUnchecked(entry.Fee(100LL).FromTx(tc));
+    pool.addUnchecked(entry.Fee(1000LL).FromTx(unrelated));
+
+    const auto vsize = [&](const CTransactionRef& tx) { return pool.GetIter(tx->GetHash()).value()->GetTxSize(); };
+    const auto projection{node::ProjectBlocks(pool, node::MAX_PROJECTED_BLOCKS)};
+    BOOST_CHECK_EQUAL(projection.mempool_sequence, pool.GetSequence());
+    BOOST_REQUIRE_EQUAL(projection.blocks.size(), 1U);
+    const auto& block{projection.blocks[0]};
+    BOOST_CHECK_EQUAL(block.tx_count, 4U);
+    BOOST_CHECK_EQUAL(block.fees, 21100);
+    BOOST_CHECK_EQUAL(block.vsize, vsize(ta) + vsize(tb) + vsize(tc) + vsize(unrelated));
+    BOOST_CHECK_EQUAL(block.weight, GetTransactionWeight(*ta) + GetTransactionWeight(*tb) + GetTransactionWeight(*tc) + GetTransactionWeight(*unrelated));
+    // ta is mined through tb's package, so both get the package feerate.
+    BOOST_CHECK(block.max_feerate == CFeeRate(20000, vsize(ta) + vsize(tb)));
+    BOOST_CHECK(block.min_feerate == CFeeRate(100, vsize(tc)));
+    int64_t histogram_vsize{0};
+    for (const auto bucket_vsize : block.feerate_histogram) histogram_vsize += bucket_vsize;
+    BOOST_CHECK_EQUAL(histogram_vsize, block.vsize);
+
+    BOOST_REQUIRE_EQUAL(projection.remainders.size(), 1U);
+    BOOST_CHECK(projection.remainders[0].median_feerate == block.median_feerate);
+
+    // Unchanged mempool: the cached projection is reused.
+    node::MempoolProjectionCache cache{pool};
+    const auto cached{cache.Get()};
+    BOOST_CHECK_EQUAL(cached->blocks.size(), 1U);
+    BOOST_CHECK(cached == cache.Get());
+
+    // Prioritising a transaction changes modified fees without touching the
+    // mempool sequence, and must not be served from the cache.
+    pool.PrioritiseTransaction(unrelated->GetHash(), 1000);
+    const auto prioritised{cache.Get()};
+    BOOST_CHECK(prioritised != cached);
+    BOOST_CHECK_EQUAL(prioritised->blocks[0].fees, 22100);
+}
+
+BOOST_AUTO_TEST_CASE(MempoolProjectRemainderTest)
+{
+    CTxMemPool& pool = *Assert(m_node.mempool);
+    LOCK2(::cs_main, pool.cs);
+    TestMemPoolEntryHelper entry;
+
+    // Six unrelated transactions of ~400k vbytes: two fit in a projected block.
+    std::vector<CTransactionRef> txs;
+    for (uint32_t i = 0; i < 6; ++i) {
+        CMutableTransaction tx;
+        tx.nLockTime = i;
+        tx.vout.resize(1);
+        tx.vout[0].scriptPubKey = CScript() << OP_RETURN << std::vector<unsigned char>(400000);
+        tx.vout[0].nValue = 0;
+        txs.push_back(MakeTransactionRef(tx));
+        pool.addUnchecked(entry.Fee((i + 1) * 100000LL).FromTx(txs.back()));
+    }
+    const auto rate = [&](size_t i) { return CFeeRate((i + 1) * 100000LL, pool.GetIter(txs[i]->GetHash()).value()->GetTxSize()); };
+
+    const auto full{node::ProjectBlocks(pool, node::MAX_PROJECTED_BLOCKS)};
+    BOOST_REQUIRE_EQUAL(full.blocks.size(), 3U);
+    BOOST_REQUIRE_EQUAL(full.remainders.size(), 3U);
+    BOOST_CHECK(full.blocks[1].median_feerate == rate(2));
+    BOOST_CHECK(full.blocks[2].median_feerate == rate(0));
+
+    // Stopping after two blocks puts the last four transactions in the second
+    // one, with the same statistics as the merged remainder of the full projection.
+    const auto two{node::ProjectBlocks(pool, 2)};
+    BOOST_REQUIRE_EQUAL(two.blocks.size(), 2U);
+    const auto& last{two.blocks[1]};
+    const auto& merged{full.remainders[1]};
+    BOOST_CHECK_EQUAL(last.tx_count, 4U);
+    BOOST_CHECK_EQUAL(merged.tx_count, 4U);
+    BOOST_CHECK_EQUAL(last.vsize, merged.vsize);
+    BOOST_CHECK_EQUAL(last.weight, merged.weight);
+    BOOST_CHECK_EQUAL(last.fees, merged.fees);
+    BOOST_CHECK(last.feerate_histogram == merged.feerate_histogram);
+    BOOST_CHECK(last.min_feerate == rate(0));
+    BOOST_CHECK(merged.min_feerate == rate(0));
+    BOOST_CHECK(last.max_feerate == rate(3));
+    BOOST_CHECK(merged.max_feerate == rate(3));
+    BOOST_CHECK(last.median_feerate == rate(1));
+    BOOST_CHECK(merged.median_feerate == rate(1));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -8,6 +8,7 @@
 #include <consensus/consensus.h>
 #include <consensus/merkle.h>
 #include <consensus/tx_verify.h>
+#include <node/mempool_projection.h>
 #include <node/miner.h>
 #include <policy/policy.h>
 #include <test/util/random.h>
@@ -47,10 +48,12 @@ struct MinerTestingSetup : public TestingSetup {
         // Delete the previous mempool to ensure with valgrind that the old
         // pointer is not accessed, when the new one should be accessed
         // instead.
+        m_node.mempool_projection.reset();
         m_node.mempool.reset();
         bilingual_str error;
         m_node.mempool = std::make_unique<CTxMemPool>(MemPoolOptionsForTest(m_node), error);
         Assert(error.empty());
+        m_node.mempool_projection = std::make_unique<node::MempoolProjectionCache>(*m_node.mempool);
         return *m_node.mempool;
     }
     BlockAssembler AssemblerForTest(CTxMemPool& tx_mempool);
@@ -28,6 +28,7 @@
 #include <algorithm>
 #include <ios>
 #include <memory>
+#include <numeric>
 #include <optional>
 #include <string>
 
@@ -1560,4 +1561,133 @@ BOOST_AUTO_TEST_CASE(v2transport_test)
     }
 }
 
+BOOST_AUTO_TEST_CASE(v1transport_gathered_send)
+{
+    V1Transport transport{/*node_id=*/0};
+    std::vector<Span<const uint8_t>> buffers;
+
+    std::vector<uint8_t> payload(100);
+    std::iota(payload.begin(), payload.end(), 0);
+    CSerializedNetMsg msg;
+    msg.m_type = "ping";
+    msg.data = payload;
+    BOOST_REQUIRE(transport.SetMessageToSend(msg));
+
+    // Header and payload are handed out together.
+    auto [more, msg_type] = transport.GetBuffersToSend(/*have_next_message=*/false, buffers);
+    BOOST_CHECK(!more);
+    BOOST_CHECK_EQUAL(msg_type, "ping");
+    BOOST_REQUIRE_EQUAL(buffers.size(), 2U);
+    BOOST_CHECK_EQUAL(buffers[0].size(), CMessageHeader::HEADER_SIZE);
+    BOOST_CHECK(buffers[1] == Span{payload});
+
+    // A partial write ending inside the payload resumes at the right offset.
+    transport.MarkBytesSent(CMessageHeader::HEADER_SIZE + 30);
+    transport.GetBuffersToSend(/*have_next_message=*/false, buffers);
+    BOOST_REQUIRE_EQUAL(buffers.size(), 1U);
+    BOOST_CHECK(buffers[0] == Span{payload}.subspan(30));
+    BOOST_CHECK(!transport.SetMessageToSend(msg));
+    transport.MarkBytesSent(70);
+    transport.GetBuffersToSend(/*have_next_message=*/false, buffers);
+    BOOST_CHECK(buffers[0].empty());
+
+    // A message without payload is a single buffer.
+    CSerializedNetMsg verack;
+    verack.m_type = "verack";
+    BOOST_REQUIRE(transport.SetMessageToSend(verack));
+    transport.GetBuffersToSend(/*have_next_message=*/true, buffers);
+    BOOST_REQUIRE_EQUAL(buffers.size(), 1U);
+    BOOST_CHECK_EQUAL(buffers[0].size(), CMessageHeader::HEADER_SIZE);
+    transport.MarkBytesSent(CMessageHeader::HEADER_SIZE);
+    BOOST_CHECK(transport.SetMessageToSend(msg));
+}
+
+BOOST_AUTO_TEST_CASE(send_buffer_limit_adapts)
+{
+    CNode node{/*id=*/0,
+               /*sock=*/nullptr,
+               CAddress{},
+               /*nKeyedNetGroupIn=*/0,
+               /*nLocalHostNonceIn=*/0,
+               CAddress{},
+               /*addrNameIn=*/"",
+               ConnectionType::OUTBOUND_FULL_RELAY,
+               /*inbound_onion=*/false};
+    constexpr size_t base{1'000'000};
+    LOCK(node.cs_vSend);
+    BOOST_CHECK_EQUAL(node.GetSendBufferLimit(base), base);
+
+    // Sends that never find the socket full say nothing about the peer's capacity.
+    node.RecordSendProgress(10'000'000, /*backlogged=*/false, 1s);
+    node.RecordSendProgress(10'000'000, /*backlogged=*/false, 10s);
+    BOOST_CHECK_EQUAL(node.GetSendBufferLimit(base), base);
+
+    // A fast peer: 5 MB drained per backlogged second allows up to 4x the base limit.
+    node.RecordSendProgress(0, /*backlogged=*/true, 20s);
+    node.RecordSendProgress(5'000'000, /*backlogged=*/true, 21s);
+    BOOST_CHECK_EQUAL(node.GetSendBufferLimit(base), base * SEND_BUFFER_LIMIT_SCALE);
+
+    // The rate is averaged with new samples; a very slow peer ends up at a quarter of the base.
+    for (int i = 0; i < 20; ++i) {
+        node.RecordSendProgress(1'000, /*backlogged=*/true, 22s + i * 1s);
+    }
+    BOOST_CHECK_EQUAL(node.GetSendBufferLimit(base), base / SEND_BUFFER_LIMIT_SCALE);
+
+    // In between the limit targets SEND_BUFFER_DRAIN_TARGET worth of data.
+    node.RecordSendProgress(0, /*backlogged=*/false, 100s);
+    node.m_send_rate = 0;
+    node.RecordSendProgress(0, /*backlogged=*/true, 200s);
+    node.RecordSendProgress(300'000, /*backlogged=*/false, 201s);
+    BOOST_CHECK_EQUAL(node.GetSendBufferLimit(base), 300'000 * count_seconds(SEND_BUFFER_DRAIN_TARGET));
+}
+
+BOOST_AUTO_TEST_CASE(send_buffer_pool)
+{
+    SendBufferPool pool;
+
+    // Small and oversized buffers are not pooled.
+    std::vector<unsigned char> small(100);
+    pool.Put(std::move(small));
+    BOOST_CHECK(small.empty());
+    BOOST_CHECK_GE(pool.Get(100).capacity(), 100U);
+
+    std::vector<unsigned char> buf(50'000);
+    const unsigned char* const data{buf.data()};
+    pool.Put(std::move(buf));
+    // Not reused for a request it would overstate by 2x or more...
+    BOOST_CHECK(pool.Get(20'000).data() != data);
+    // ...nor for one it cannot hold.
+    BOOST_CHECK(pool.Get(60'000).data() != data);
+    // Reused for a similar size, and handed out empty.
+    auto reused{pool.Get(40'000)};
+    BOOST_CHECK(reused.data() == data);
+    BOOST_CHECK(reused.empty());
+    BOOST_CHECK_GE(reused.capacity(), 40'000U);
+    // Only once.
+    BOOST_CHECK(pool.Get(40'000).data() != data);
+}
+
+BOOST_AUTO_TEST_CASE(msg_type_traffic)
+{
+    for (size_t i = 0; i < ALL_NET_MESSAGE_TYPES.size(); ++i) {
+        BOOST_CHECK_EQUAL(MsgTypeTraffic::Index(ALL_NET_MESSAGE_TYPES[i]), i);
+        BOOST_CHECK_EQUAL(MsgTypeTraffic::Type(i), ALL_NET_MESSAGE_TYPES[i]);
+    }
+    const size_t other{MsgTypeTraffic::COUNTERS - 1};
+    BOOST_CHECK_EQUAL(MsgTypeTraffic::Index("nonsense"), other);
+    BOOST_CHECK_EQUAL(MsgTypeTraffic::Type(other), NET_MESSAGE_TYPE_OTHER);
+
+    MsgTypeTraffic traffic;
+    traffic.AddSent(NetMsgType::PING, 32);
+    traffic.AddSent(NetMsgType::PING, 32);
+    traffic.AddRecv(NetMsgType::PONG, 32);
+    traffic.AddRecv("nonsense", 100);
+    const size_t ping{MsgTypeTraffic::Index(NetMsgType::PING)};
+    const size_t pong{MsgTypeTraffic::Index(NetMsgType::PONG)};
+    BOOST_CHECK_EQUAL(traffic.Sent(ping), 64U);
+    BOOST_CHECK_EQUAL(traffic.Recv(ping), 0U);
+    BOOST_CHECK_EQUAL(traffic.Recv(pong), 32U);
+    BOOST_CHECK_EQUAL(traffic.Recv(other), 100U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -5,6 +5,7 @@
 #include <policy/fees.h>
 #include <policy/fees_args.h>
 #include <policy/policy.h>
+#include <streams.h>
 #include <test/util/txmempool.h>
 #include <txmempool.h>
 #include <uint256.h>
@@ -263,6 +264,25 @@ BOOST_AUTO_TEST_CASE(BlockPolicyEstimates)
     for (int i = 2; i < 9; i++) { // At 9, the original estimate was already at the bottom (b/c scale = 2)
         BOOST_CHECK(feeEst.estimateFee(i).GetFeePerK() < origFeeEst[i-1] - deltaFee);
     }
+
+    // Repeated smart fee queries give the same answer
+    FeeCalculation calc1, calc2;
+    const CFeeRate smart1{feeEst.estimateSmartFee(4, &calc1, /*conservative=*/false)};
+    const CFeeRate smart2{feeEst.estimateSmartFee(4, &calc2, /*conservative=*/false)};
+    BOOST_CHECK(smart1 == smart2);
+    BOOST_CHECK(calc1.reason == calc2.reason);
+    BOOST_CHECK_EQUAL(calc1.returnedTarget, calc2.returnedTarget);
+
+    // Written estimates include the decay that is applied lazily in memory
+    const fs::path est_path{m_args.GetDataDirBase() / "fee_estimates_roundtrip.dat"};
+    {
+        AutoFile est_file{fsbridge::fopen(est_path, "wb")};
+        BOOST_REQUIRE(feeEst.Write(est_file));
+    }
+    CBlockPolicyEstimator feeEstRead{est_path, /*read_stale_estimates=*/true};
+    for (int i = 2; i < 10; i++) {
+        BOOST_CHECK(feeEstRead.estimateFee(i) == feeEst.estimateFee(i));
+    }
 }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <core_io.h>
+#include <httprpc.h>
 #include <interfaces/chain.h>
 #include <node/context.h>
 #include <rpc/blockchain.h>
@@ -638,4 +639,30 @@ BOOST_AUTO_TEST_CASE(rpc_arg_helper)
     CheckRpc(params, UniValue{JSON(R"([5, "hello", 4, "test", true, 1.23, "world"])")}, check_positional);
 }
 
+BOOST_AUTO_TEST_CASE(rpc_priority)
+{
+    // Known expensive methods, wherever the method is in the request.
+    BOOST_CHECK(GetJSONRPCPriority(R"({"method":"scantxoutset","params":["status"]})") == HTTPPriority::LOW);
+    BOOST_CHECK(GetJSONRPCPriority(" \n{\"id\": 1, \"method\" : \"scantxoutset\"}") == HTTPPriority::LOW);
+    // Batches, unknown methods and requests that cannot be scanned simply.
+    BOOST_CHECK(GetJSONRPCPriority(R"([{"method":"scantxoutset","params":["status"]}])") == HTTPPriority::NORMAL);
+    BOOST_CHECK(GetJSONRPCPriority(R"({"method":"nonexistent"})") == HTTPPriority::NORMAL);
+    BOOST_CHECK(GetJSONRPCPriority(R"({"method":"scan\u0074xoutset"})") == HTTPPriority::NORMAL);
+    BOOST_CHECK(GetJSONRPCPriority(R"({"params":[]})") == HTTPPriority::NORMAL);
+    // Only the method of the request itself counts, not keys of named params.
+    BOOST_CHECK(GetJSONRPCPriority(R"({"method":"getblockcount","params":{"method":"scantxoutset"}})") == HTTPPriority::NORMAL);
+    BOOST_CHECK(GetJSONRPCPriority(R"({"params":{"method":"scantxoutset"},"method":"getblockcount"})") == HTTPPriority::NORMAL);
+    BOOST_CHECK(GetJSONRPCPriority(R"({"params":["method","scantxoutset"],"id":"\"method\""})") == HTTPPriority::NORMAL);
+    BOOST_CHECK(GetJSONRPCPriority(R"({"params":{"a":[{}]},"method":"scantxoutset"})") == HTTPPriority::LOW);
+    BOOST_CHECK(GetJSONRPCPriority("") == HTTPPriority::NORMAL);
+
+    // Methods measured to be fast.
+    for (int i = 0; i < 10; ++i) CallRPC("getblockcount");
+    BOOST_CHECK(GetJSONRPCPriority(R"({"method":"getblockcount"})") == HTTPPriority::HIGH);
+    const auto fast{tableRPC.GetRecentMethodLatency("getblockcount")};
+    BOOST_REQUIRE(fast);
+    BOOST_CHECK(*fast < 10ms);
+    BOOST_CHECK(!tableRPC.GetRecentMethodLatency("nonexistent"));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
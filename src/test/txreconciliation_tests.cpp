@@ -4,8 +4,11 @@
 
 #include <node/txreconciliation.h>
 
+#include <arith_uint256.h>
 #include <test/util/setup_common.h>
 
+#include <algorithm>
+
 #include <boost/test/unit_test.hpp>
 
 BOOST_FIXTURE_TEST_SUITE(txreconciliation_tests, BasicTestingSetup)
@@ -81,4 +84,125 @@ BOOST_AUTO_TEST_CASE(IsPeerRegisteredTest)
     BOOST_CHECK(!tracker.IsPeerRegistered(peer_id0));
 }
 
+BOOST_AUTO_TEST_CASE(ReconciliationRoundTest)
+{
+    // Node A initiates reconciliations with node B (A's outbound connection), each knowing the
+    // other as peer 0.
+    TxReconciliationTracker tracker_a(TXRECONCILIATION_VERSION);
+    TxReconciliationTracker tracker_b(TXRECONCILIATION_VERSION);
+    const uint64_t salt_a{tracker_a.PreRegisterPeer(0)};
+    const uint64_t salt_b{tracker_b.PreRegisterPeer(0)};
+    BOOST_REQUIRE(tracker_a.RegisterPeer(0, /*is_peer_inbound=*/false, 1, salt_b) == ReconciliationRegisterResult::SUCCESS);
+    BOOST_REQUIRE(tracker_b.RegisterPeer(0, /*is_peer_inbound=*/true, 1, salt_a) == ReconciliationRegisterResult::SUCCESS);
+
+    const auto wtxid = [](uint8_t n) { return Wtxid::FromUint256(uint256{n}); };
+    const Wtxid shared{wtxid(1)}, only_b1{wtxid(3)}, only_b2{wtxid(4)};
+    // A floods to its outbound peer B, which drops what A announced from its own set.
+    BOOST_CHECK(!tracker_a.AddToSet(0, shared));
+    BOOST_CHECK(tracker_b.AddToSet(0, shared));
+    BOOST_CHECK(tracker_b.AddToSet(0, only_b1));
+    BOOST_CHECK(tracker_b.AddToSet(0, only_b2));
+    BOOST_CHECK(tracker_b.TryRemovingFromSet(0, shared));
+    BOOST_CHECK(!tracker_b.AddToSet(1, shared)); // not registered
+
+    // Only the initiator sends requests, and only once the interval elapsed.
+    BOOST_CHECK(!tracker_b.InitiateReconciliationRequest(0, 0s));
+    const auto request{tracker_a.InitiateReconciliationRequest(0, 0s)};
+    BOOST_REQUIRE(request);
+    BOOST_CHECK_EQUAL(request->first, 0);
+    BOOST_CHECK(!tracker_a.InitiateReconciliationRequest(0, 1s));
+    BOOST_CHECK(!tracker_a.HandleReconciliationRequest(0, 0, 0));
+
+    // No sketch before a request arrived, and no unsolicited ones.
+    BOOST_CHECK(!tracker_b.RespondToReconciliationRequest(0, 0s));
+    BOOST_CHECK(!tracker_b.HandleSketch(0, std::vector<uint8_t>(4)));
+
+    BOOST_REQUIRE(tracker_b.HandleReconciliationRequest(0, request->first, request->second));
+    // A second request while one is pending violates the protocol.
+    BOOST_CHECK(!tracker_b.HandleReconciliationRequest(0, request->first, request->second));
+    const auto sketch{tracker_b.RespondToReconciliationRequest(0, 0s)};
+    BOOST_REQUIRE(sketch);
+    BOOST_CHECK(!tracker_b.HandleReconciliationRequest(0, request->first, request->second));
+    // Nor does A send one before the round is over, however long it waits.
+    BOOST_CHECK(!tracker_a.InitiateReconciliationRequest(0, 2 * RECON_REQUEST_INTERVAL));
+    // Transactions added after the sketch was built wait for the next round.
+    BOOST_CHECK(tracker_b.AddToSet(0, wtxid(5)));
+
+    const auto result{tracker_a.HandleSketch(0, *sketch)};
+    BOOST_REQUIRE(result);
+    BOOST_CHECK(result->success);
+    BOOST_CHECK(result->txs_to_announce.empty());
+    BOOST_CHECK_EQUAL(result->txs_to_request.size(), 2U);
+    // The round is over on A's side.
+    BOOST_CHECK(!tracker_a.HandleSketch(0, *sketch));
+
+    const auto to_announce{tracker_b.HandleReconciliationDifference(0, result->success, result->txs_to_request)};
+    BOOST_REQUIRE(to_announce);
+    BOOST_CHECK_EQUAL(to_announce->size(), 2U);
+    BOOST_CHECK(std::find(to_announce->begin(), to_announce->end(), only_b1) != to_announce->end());
+    BOOST_CHECK(std::find(to_announce->begin(), to_announce->end(), only_b2) != to_announce->end());
+    BOOST_CHECK(!tracker_b.HandleReconciliationDifference(0, true, {}));
+
+    // Next round: B only has the late transaction. On failure B floods its snapshot.
+    const auto request2{tracker_a.InitiateReconciliationRequest(0, RECON_REQUEST_INTERVAL)};
+    BOOST_REQUIRE(request2);
+    BOOST_CHECK_EQUAL(request2->first, 0);
+    BOOST_REQUIRE(tracker_b.HandleReconciliationRequest(0, request2->first, request2->second));
+    BOOST_REQUIRE(tracker_b.RespondToReconciliationRequest(0, 0s));
+    const auto flood{tracker_b.HandleReconciliationDifference(0, /*success=*/false, {})};
+    BOOST_REQUIRE(flood);
+    BOOST_REQUIRE_EQUAL(flood->size(), 1U);
+    BOOST_CHECK((*flood)[0] == wtxid(5));
+}
+
+BOOST_AUTO_TEST_CASE(ReconciliationTimeoutTest)
+{
+    TxReconciliationTracker tracker_a(TXRECONCILIATION_VERSION);
+    TxReconciliationTracker tracker_b(TXRECONCILIATION_VERSION);
+    tracker_a.PreRegisterPeer(0);
+    tracker_b.PreRegisterPeer(0);
+    BOOST_REQUIRE(tracker_a.RegisterPeer(0, /*is_peer_inbound=*/false, 1, 1) == ReconciliationRegisterResult::SUCCESS);
+    BOOST_REQUIRE(tracker_b.RegisterPeer(0, /*is_peer_inbound=*/true, 1, 1) == ReconciliationRegisterResult::SUCCESS);
+
+    // The initiator waits for a sketch...
+    BOOST_CHECK(!tracker_a.HasRoundTimedOut(0, 1000s));
+    const auto request{tracker_a.InitiateReconciliationRequest(0, 0s)};
+    BOOST_REQUIRE(request);
+    BOOST_CHECK(!tracker_a.HasRoundTimedOut(0, RECON_RESPONSE_TIMEOUT));
+    BOOST_CHECK(tracker_a.HasRoundTimedOut(0, RECON_RESPONSE_TIMEOUT + 1s));
+
+    // ...but the responder may take its time to answer the request.
+    BOOST_REQUIRE(tracker_b.HandleReconciliationRequest(0, request->first, request->second));
+    BOOST_CHECK(!tracker_b.HasRoundTimedOut(0, 1000s));
+    const auto sketch{tracker_b.RespondToReconciliationRequest(0, 1000s)};
+    BOOST_REQUIRE(sketch);
+    BOOST_CHECK(!tracker_b.HasRoundTimedOut(0, 1000s + RECON_RESPONSE_TIMEOUT));
+    BOOST_CHECK(tracker_b.HasRoundTimedOut(0, 1000s + RECON_RESPONSE_TIMEOUT + 1s));
+
+    // Finishing the round clears the timeout on both sides.
+    const auto result{tracker_a.HandleSketch(0, *sketch)};
+    BOOST_REQUIRE(result);
+    BOOST_CHECK(!tracker_a.HasRoundTimedOut(0, 1000s + RECON_RESPONSE_TIMEOUT + 1s));
+    BOOST_REQUIRE(tracker_b.HandleReconciliationDifference(0, result->success, result->txs_to_request));
+    BOOST_CHECK(!tracker_b.HasRoundTimedOut(0, 1000s + RECON_RESPONSE_TIMEOUT + 1s));
+    BOOST_CHECK(!tracker_b.HasRoundTimedOut(1, 1000s + RECON_RESPONSE_TIMEOUT + 1s)); // not registered
+}
+
+BOOST_AUTO_TEST_CASE(ReconciliationSetLimitTest)
+{
+    TxReconciliationTracker tracker(TXRECONCILIATION_VERSION);
+    tracker.PreRegisterPeer(0);
+    BOOST_REQUIRE(tracker.RegisterPeer(0, /*is_peer_inbound=*/true, 1, 1) == ReconciliationRegisterResult::SUCCESS);
+
+    for (size_t i = 0; i < MAX_RECONSET_SIZE; ++i) {
+        BOOST_CHECK(tracker.AddToSet(0, Wtxid::FromUint256(ArithToUint256(i + 1))));
+    }
+    // A full set makes the caller fall back to flooding.
+    const Wtxid extra{Wtxid::FromUint256(ArithToUint256(MAX_RECONSET_SIZE + 1))};
+    BOOST_CHECK(!tracker.AddToSet(0, extra));
+    BOOST_CHECK(tracker.TryRemovingFromSet(0, Wtxid::FromUint256(ArithToUint256(1))));
+    BOOST_CHECK(!tracker.TryRemovingFromSet(0, Wtxid::FromUint256(ArithToUint256(1))));
+    BOOST_CHECK(tracker.AddToSet(0, extra));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
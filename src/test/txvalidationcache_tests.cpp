@@ -4,6 +4,7 @@
 
 #include <consensus/validation.h>
 #include <key.h>
+#include <policy/policy.h>
 #include <random.h>
 #include <script/sigcache.h>
 #include <script/sign.h>
@@ -385,4 +386,62 @@ BOOST_FIXTURE_TEST_CASE(checkinputs_test, Dersig100Setup)
     }
 }
 
+// Whether the signature of input n_in of tx, a P2PK spend of pubkey, is in the signature cache.
+static bool InSignatureCache(SignatureCache& cache, const CTransaction& tx, unsigned int n_in, const CPubKey& pubkey)
+{
+    CScript::const_iterator pc{tx.vin[n_in].scriptSig.begin()};
+    opcodetype opcode;
+    std::vector<unsigned char> sig;
+    if (!tx.vin[n_in].scriptSig.GetOp(pc, opcode, sig) || sig.empty()) return false;
+    sig.pop_back(); // hash type
+    const CScript script_code{CScript() << ToByteVector(pubkey) << OP_CHECKSIG};
+    const uint256 sighash{SignatureHash(script_code, tx, n_in, SIGHASH_ALL, 0, SigVersion::BASE)};
+    uint256 entry;
+    cache.ComputeEntryECDSA(entry, sighash, sig, pubkey);
+    return cache.Get(entry, /*erase=*/false);
+}
+
+BOOST_FIXTURE_TEST_CASE(reorg_prewarms_signature_cache, TestChain100Setup)
+{
+    const CScript p2pk{CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG};
+    SignatureCache& sigcache{m_node.chainman->m_validation_cache.m_signature_cache};
+    const auto count_cached = [&](const std::vector<CTransactionRef>& txs) {
+        size_t cached{0};
+        for (const auto& tx : txs) {
+            for (unsigned int i = 0; i < tx->vin.size(); ++i) cached += InSignatureCache(sigcache, *tx, i, coinbaseKey.GetPubKey());
+        }
+        return cached;
+    };
+    // Let the first coinbase outputs mature also after the reorg below.
+    for (int i = 0; i < 3; ++i) CreateAndProcessBlock({}, p2pk);
+
+    // A chain of two spends and a spend of three coinbase outputs: five signatures.
+    // tx_c also has an oversized OP_RETURN output, so it is valid in a block
+    // but rejected by the mempool policy before its scripts are checked. Its
+    // signatures can therefore only be cached by the prewarm of the reorg.
+    const auto tx_a{MakeTransactionRef(CreateValidMempoolTransaction(m_coinbase_txns[0], 0, 1, coinbaseKey, p2pk, 49 * COIN, /*submit=*/false))};
+    const auto tx_b{MakeTransactionRef(CreateValidMempoolTransaction(tx_a, 0, 101, coinbaseKey, p2pk, 48 * COIN, /*submit=*/false))};
+    std::vector<COutPoint> outpoints;
+    for (int i = 1; i <= 3; ++i) outpoints.emplace_back(m_coinbase_txns[i]->GetHash(), 0);
+    const CTxOut oversized_data{0, CScript() << OP_RETURN << std::vector<unsigned char>(MAX_OP_RETURN_RELAY, 0)};
+    const auto tx_c{MakeTransactionRef(CreateValidMempoolTransaction({m_coinbase_txns[1], m_coinbase_txns[2], m_coinbase_txns[3]}, outpoints, 2,
+                                                                     {coinbaseKey}, {CTxOut{149 * COIN, p2pk}, oversized_data}, /*submit=*/false))};
+
+    // Confirm the transactions. Connecting a block does not store signatures in the cache.
+    const CBlock block{CreateAndProcessBlock({CMutableTransaction{*tx_a}, CMutableTransaction{*tx_b}, CMutableTransaction{*tx_c}}, p2pk)};
+    BOOST_REQUIRE_EQUAL(WITH_LOCK(cs_main, return m_node.chainman->ActiveChain().Tip()->GetBlockHash()), block.GetHash());
+    BOOST_CHECK_EQUAL(count_cached({tx_a, tx_b, tx_c}), 0U);
+
+    // Disconnect the block: tx_a and tx_b re-enter the mempool, tx_c is rejected
+    // by policy, but all three were verified by the prewarm beforehand,
+    // including tx_b which spends an output of another resurrected transaction.
+    BlockValidationState state;
+    CBlockIndex* tip{WITH_LOCK(cs_main, return m_node.chainman->ActiveChain().Tip())};
+    BOOST_REQUIRE(m_node.chainman->ActiveChainstate().InvalidateBlock(state, tip));
+    BOOST_CHECK_EQUAL(m_node.mempool->size(), 2U);
+    BOOST_CHECK(!m_node.mempool->exists(GenTxid::Txid(tx_c->GetHash())));
+    BOOST_CHECK_EQUAL(count_cached({tx_c}), 3U);
+    BOOST_CHECK_EQUAL(count_cached({tx_a, tx_b, tx_c}), 5U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
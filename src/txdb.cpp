@@ -16,6 +16,7 @@
 
 #include <cassert>
 #include <cstdlib>
+#include <future>
 #include <iterator>
 #include <utility>
 
@@ -89,7 +90,25 @@ std::vector<uint256> CCoinsViewDB::GetHeadBlocks() const {
 }
 
 bool CCoinsViewDB::BatchWrite(CoinsViewCacheCursor& cursor, const uint256 &hashBlock) {
-    CDBBatch batch(*m_db);
+    // Partial batches are handed to a background thread for writing while the
+    // next one is serialized, so that serialization and disk I/O overlap. At
+    // most one write is in flight and they complete in order, so the
+    // DB_HEAD_BLOCKS marker in the first batch and DB_BEST_BLOCK in the last
+    // one keep their meaning. The future joins the writer on destruction.
+    CDBBatch batches[2]{CDBBatch{*m_db}, CDBBatch{*m_db}};
+    CDBBatch* batch{&batches[0]};
+    std::future<void> pending_write;
+    const auto wait_for_pending_write = [&] {
+        if (!pending_write.valid()) return;
+        pending_write.get();
+        if (m_options.simulate_crash_ratio) {
+            static FastRandomContext rng;
+            if (rng.randrange(m_options.simulate_crash_ratio) == 0) {
+                LogPrintf("Simulating a crash. Goodbye.\n");
+                _Exit(0);
+            }
+        }
+    };
     size_t count = 0;
     size_t changed = 0;
     assert(!hashBlock.IsNull());
@@ -111,40 +130,38 @@ bool CCoinsViewDB::BatchWrite(CoinsViewCacheCursor& cursor, const uint256 &hashB
     // transition from old_tip to hashBlock.
     // A vector is used for future extensibility, as we may want to support
     // interrupting after partial writes from multiple independent reorgs.
-    batch.Erase(DB_BEST_BLOCK);
-    batch.Write(DB_HEAD_BLOCKS, Vector(hashBlock, old_tip));
+    batch->Erase(DB_BEST_BLOCK);
+    batch->Write(DB_HEAD_BLOCKS, Vector(hashBlock, old_tip));
 
     for (auto it{cursor.Begin()}; it != cursor.End();) {
         if (it->second.IsDirty()) {
             CoinEntry entry(&it->first);
             if (it->second.coin.IsSpent())
-                batch.Erase(entry);
+                batch->Erase(entry);
             else
-                batch.Write(entry, it->second.coin);
+                batch->Write(entry, it->second.coin);
             changed++;
         }
         count++;
         it = cursor.NextAndMaybeErase(*it);
-        if (batch.SizeEstimate() > m_options.batch_write_bytes) {
-            LogPrint(BCLog::COINDB, "Writing partial batch of %.2f MiB\n", batch.SizeEstimate() * (1.0 / 1048576.0));
-            m_db->WriteBatch(batch);
-            batch.Clear();
-            if (m_options.simulate_crash_ratio) {
-                static FastRandomContext rng;
-                if (rng.randrange(m_options.simulate_crash_ratio) == 0) {
-                    LogPrintf("Simulating a crash. Goodbye.\n");
-                    _Exit(0);
-                }
-            }
+        if (batch->SizeEstimate() > m_options.batch_write_bytes) {
+            wait_for_pending_write();
+            LogPrint(BCLog::COINDB, "Writing partial batch of %.2f MiB\n", batch->SizeEstimate() * (1.0 / 1048576.0));
+            pending_write = std::async(std::launch::async, [this, full_batch = batch] {
+                m_db->WriteBatch(*full_batch);
+                full_batch->Clear();
+            });
+            batch = batch == &batches[0] ? &batches[1] : &batches[0];
         }
     }
+    wait_for_pending_write();
 
     // In the last batch, mark the database as consistent with hashBlock again.
-    batch.Erase(DB_HEAD_BLOCKS);
-    batch.Write(DB_BEST_BLOCK, hashBlock);
+    batch->Erase(DB_HEAD_BLOCKS);
+    batch->Write(DB_BEST_BLOCK, hashBlock);
 
-    LogPrint(BCLog::COINDB, "Writing final batch of %.2f MiB\n", batch.SizeEstimate() * (1.0 / 1048576.0));
-    bool ret = m_db->WriteBatch(batch);
+    LogPrint(BCLog::COINDB, "Writing final batch of %.2f MiB\n", batch->SizeEstimate() * (1.0 / 1048576.0));
+    bool ret = m_db->WriteBatch(*batch);
     LogPrint(BCLog::COINDB, "Committed %u changed transaction outputs (out of %u) to coin database...\n", (unsigned int)changed, (unsigned int)count);
     return ret;
 }
@@ -6,6 +6,7 @@
 #include <txmempool.h>
 
 #include <chain.h>
+#include <cluster_linearize.h>
 #include <coins.h>
 #include <common/system.h>
 #include <consensus/consensus.h>
@@ -16,6 +17,7 @@
 #include <policy/settings.h>
 #include <random.h>
 #include <tinyformat.h>
+#include <util/bitset.h>
 #include <util/check.h>
 #include <util/feefrac.h>
 #include <util/moneystr.h>
@@ -54,14 +56,14 @@ bool TestLockPointValidity(CChain& active_chain, const LockPoints& lp)
 void CTxMemPool::UpdateForDescendants(txiter updateIt, cacheMap& cachedDescendants,
                                       const std::set<uint256>& setExclude, std::set<uint256>& descendants_to_remove)
 {
-    CTxMemPoolEntry::Children stageEntries, descendants;
-    stageEntries = updateIt->GetMemPoolChildrenConst();
+    const CTxMemPoolEntry::Links& children_of_updated = updateIt->GetMemPoolChildrenConst();
+    CTxMemPoolEntry::Children stageEntries{children_of_updated.begin(), children_of_updated.end()}, descendants;
 
     while (!stageEntries.empty()) {
         const CTxMemPoolEntry& descendant = *stageEntries.begin();
         descendants.insert(descendant);
         stageEntries.erase(descendant);
-        const CTxMemPoolEntry::Children& children = descendant.GetMemPoolChildrenConst();
+        const CTxMemPoolEntry::Links& children = descendant.GetMemPoolChildrenConst();
         for (const CTxMemPoolEntry& childEntry : children) {
             cacheMap::iterator cacheIt = cachedDescendants.find(mapTx.iterator_to(childEntry));
             if (cacheIt != cachedDescendants.end()) {
@@ -182,7 +184,7 @@ util::Result<CTxMemPool::setEntries> CTxMemPool::CalculateAncestorsAndCheckLimit
             return util::Error{Untranslated(strprintf("exceeds ancestor size limit [limit: %u]", limits.ancestor_size_vbytes))};
         }
 
-        const CTxMemPoolEntry::Parents& parents = stageit->GetMemPoolParentsConst();
+        const CTxMemPoolEntry::Links& parents = stageit->GetMemPoolParentsConst();
         for (const CTxMemPoolEntry& parent : parents) {
             txiter parent_it = mapTx.iterator_to(parent);
 
@@ -262,7 +264,8 @@ util::Result<CTxMemPool::setEntries> CTxMemPool::CalculateMemPoolAncestors(
         // If we're not searching for parents, we require this to already be an
         // entry in the mempool and use the entry's cached parents.
         txiter it = mapTx.iterator_to(entry);
-        staged_ancestors = it->GetMemPoolParentsConst();
+        const CTxMemPoolEntry::Links& parents = it->GetMemPoolParentsConst();
+        staged_ancestors.insert(parents.begin(), parents.end());
     }
 
     return CalculateAncestorsAndCheckLimits(entry.GetTxSize(), /*entry_count=*/1, staged_ancestors,
@@ -285,7 +288,7 @@ CTxMemPool::setEntries CTxMemPool::AssumeCalculateMemPoolAncestors(
 
 void CTxMemPool::UpdateAncestorsOf(bool add, txiter it, setEntries &setAncestors)
 {
-    const CTxMemPoolEntry::Parents& parents = it->GetMemPoolParentsConst();
+    const CTxMemPoolEntry::Links& parents = it->GetMemPoolParentsConst();
     // add or remove this tx as a child of each parent
     for (const CTxMemPoolEntry& parent : parents) {
         UpdateChild(mapTx.iterator_to(parent), it, add);
@@ -314,7 +317,7 @@ void CTxMemPool::UpdateEntryForAncestors(txiter it, const setEntries &setAncesto
 
 void CTxMemPool::UpdateChildrenForRemoval(txiter it)
 {
-    const CTxMemPoolEntry::Children& children = it->GetMemPoolChildrenConst();
+    const CTxMemPoolEntry::Links& children = it->GetMemPoolChildrenConst();
     for (const CTxMemPoolEntry& updateIt : children) {
         UpdateParent(mapTx.iterator_to(updateIt), it, false);
     }
@@ -482,6 +485,7 @@ void CTxMemPool::addUnchecked(const CTxMemPoolEntry &entry, setEntries &setAnces
         entry.GetTxSize(),
         entry.GetFee()
     );
+    PublishStats();
 }
 
 void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
@@ -524,9 +528,18 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
     totalTxSize -= it->GetTxSize();
     m_total_fee -= it->GetFee();
     cachedInnerUsage -= it->DynamicMemoryUsage();
-    cachedInnerUsage -= memusage::DynamicUsage(it->GetMemPoolParentsConst()) + memusage::DynamicUsage(it->GetMemPoolChildrenConst());
+    cachedInnerUsage -= it->GetMemPoolParentsConst().DynamicMemoryUsage() + it->GetMemPoolChildrenConst().DynamicMemoryUsage();
     mapTx.erase(it);
     nTransactionsUpdated++;
+    PublishStats();
+}
+
+void CTxMemPool::PublishStats()
+{
+    AssertLockHeld(cs);
+    m_published_count.store(mapTx.size(), std::memory_order_relaxed);
+    m_published_tx_size.store(totalTxSize, std::memory_order_relaxed);
+    m_published_usage.store(DynamicMemoryUsage(), std::memory_order_relaxed);
 }
 
 // Calculates descendants of entry that are not already in setDescendants, and adds to
@@ -549,7 +562,7 @@ void CTxMemPool::CalculateDescendants(txiter entryit, setEntries& setDescendants
         setDescendants.insert(it);
         stage.erase(it);
 
-        const CTxMemPoolEntry::Children& children = it->GetMemPoolChildrenConst();
+        const CTxMemPoolEntry::Links& children = it->GetMemPoolChildrenConst();
         for (const CTxMemPoolEntry& child : children) {
             txiter childiter = mapTx.iterator_to(child);
             if (!setDescendants.count(childiter)) {
@@ -675,7 +688,7 @@ void CTxMemPool::check(const CCoinsViewCache& active_coins_tip, int64_t spendhei
         check_total_fee += it->GetFee();
         innerUsage += it->DynamicMemoryUsage();
         const CTransaction& tx = it->GetTx();
-        innerUsage += memusage::DynamicUsage(it->GetMemPoolParentsConst()) + memusage::DynamicUsage(it->GetMemPoolChildrenConst());
+        innerUsage += it->GetMemPoolParentsConst().DynamicMemoryUsage() + it->GetMemPoolChildrenConst().DynamicMemoryUsage();
         CTxMemPoolEntry::Parents setParentCheck;
         for (const CTxIn &txin : tx.vin) {
             // Check that every mempool transaction's inputs refer to available coins, or other mempool tx's.
@@ -878,6 +891,7 @@ void CTxMemPool::PrioritiseTransaction(const uint256& hash, const CAmount& nFeeD
 {
     {
         LOCK(cs);
+        ++m_fee_delta_version;
         CAmount &delta = mapDeltas[hash];
         delta = SaturatingAdd(delta, nFeeDelta);
         txiter it = mapTx.find(hash);
@@ -1074,22 +1088,22 @@ void CTxMemPool::addUnchecked(const CTxMemPoolEntry &entry)
 void CTxMemPool::UpdateChild(txiter entry, txiter child, bool add)
 {
     AssertLockHeld(cs);
-    CTxMemPoolEntry::Children s;
-    if (add && entry->GetMemPoolChildren().insert(*child).second) {
-        cachedInnerUsage += memusage::IncrementalDynamicUsage(s);
-    } else if (!add && entry->GetMemPoolChildren().erase(*child)) {
-        cachedInnerUsage -= memusage::IncrementalDynamicUsage(s);
+    CTxMemPoolEntry::Links& links = entry->GetMemPoolChildren();
+    const size_t usage_before{links.DynamicMemoryUsage()};
+    if (add ? links.insert(*child) : links.erase(*child)) {
+        cachedInnerUsage += links.DynamicMemoryUsage();
+        cachedInnerUsage -= usage_before;
     }
 }
 
 void CTxMemPool::UpdateParent(txiter entry, txiter parent, bool add)
 {
     AssertLockHeld(cs);
-    CTxMemPoolEntry::Parents s;
-    if (add && entry->GetMemPoolParents().insert(*parent).second) {
-        cachedInnerUsage += memusage::IncrementalDynamicUsage(s);
-    } else if (!add && entry->GetMemPoolParents().erase(*parent)) {
-        cachedInnerUsage -= memusage::IncrementalDynamicUsage(s);
+    CTxMemPoolEntry::Links& links = entry->GetMemPoolParents();
+    const size_t usage_before{links.DynamicMemoryUsage()};
+    if (add ? links.insert(*parent) : links.erase(*parent)) {
+        cachedInnerUsage += links.DynamicMemoryUsage();
+        cachedInnerUsage -= usage_before;
     }
 }
 
@@ -1130,20 +1144,42 @@ void CTxMemPool::TrimToSize(size_t sizelimit, std::vector<COutPoint>* pvNoSpends
 
     unsigned nTxnRemoved = 0;
     CFeeRate maxFeeRateRemoved(0);
+    uint64_t linearize_iterations_left{MAX_TRIM_LINEARIZE_ITERATIONS};
     while (!mapTx.empty() && DynamicMemoryUsage() > sizelimit) {
         indexed_transaction_set::index<descendant_score>::type::iterator it = mapTx.get<descendant_score>().begin();
 
+        // Evict the lowest feerate chunk of the cluster of the transaction with
+        // the worst descendant score. The last chunk of a linearization is
+        // closed under descendants, so removing it leaves a consistent mempool.
+        // Fall back to the descendants of that transaction for clusters too
+        // large to linearize. Once the iteration budget is spent, clusters are
+        // still linearized, from their ancestor sets only.
+        // Note that block assembly still selects by ancestor feerate, so the
+        // evicted chunk is not necessarily the cluster's last to be mined.
+        setEntries stage;
+        CAmount removed_fees;
+        int64_t removed_size;
+        const uint64_t iterations{std::min(DEFAULT_CLUSTER_LINEARIZE_ITERATIONS, linearize_iterations_left)};
+        linearize_iterations_left -= iterations;
+        if (const auto linearization{LinearizeCluster(it->GetTx().GetHash(), iterations)}) {
+            removed_fees = linearization->chunk_feerates.back().fee;
+            removed_size = linearization->chunk_feerates.back().size;
+            stage.insert(linearization->txs.end() - linearization->chunk_sizes.back(), linearization->txs.end());
+        } else {
+            removed_fees = it->GetModFeesWithDescendants();
+            removed_size = it->GetSizeWithDescendants();
+            CalculateDescendants(mapTx.project<0>(it), stage);
+        }
+
         // We set the new mempool min fee to the feerate of the removed set, plus the
         // "minimum reasonable fee rate" (ie some value under which we consider txn
         // to have 0 fee). This way, we don't allow txn to enter mempool with feerate
         // equal to txn which were removed with no block in between.
-        CFeeRate removed(it->GetModFeesWithDescendants(), it->GetSizeWithDescendants());
+        CFeeRate removed(removed_fees, removed_size);
         removed += m_opts.incremental_relay_feerate;
         trackPackageRemoved(removed);
         maxFeeRateRemoved = std::max(maxFeeRateRemoved, removed);
 
-        setEntries stage;
-        CalculateDescendants(mapTx.project<0>(it), stage);
         nTxnRemoved += stage.size();
 
         std::vector<CTransaction> txn;
@@ -1178,7 +1214,7 @@ uint64_t CTxMemPool::CalculateDescendantMaximum(txiter entry) const {
         txiter candidate = candidates.back();
         candidates.pop_back();
         if (!counted.insert(candidate).second) continue;
-        const CTxMemPoolEntry::Parents& parents = candidate->GetMemPoolParentsConst();
+        const CTxMemPoolEntry::Links& parents = candidate->GetMemPoolParentsConst();
         if (parents.size() == 0) {
             maximum = std::max(maximum, candidate->GetCountWithDescendants());
         } else {
@@ -1229,8 +1265,8 @@ std::vector<CTxMemPool::txiter> CTxMemPool::GatherClusters(const std::vector<uin
         // DoS protection: if there are 500 or more entries to process, just quit.
         if (clustered_txs.size() > 500) return {};
         const txiter& tx_iter = clustered_txs.at(i);
-        for (const auto& entries : {tx_iter->GetMemPoolParentsConst(), tx_iter->GetMemPoolChildrenConst()}) {
-            for (const CTxMemPoolEntry& entry : entries) {
+        for (const auto* entries : {&tx_iter->GetMemPoolParentsConst(), &tx_iter->GetMemPoolChildrenConst()}) {
+            for (const CTxMemPoolEntry& entry : *entries) {
                 const auto entry_it = mapTx.iterator_to(entry);
                 if (!visited(entry_it)) {
                     clustered_txs.push_back(entry_it);
@@ -1241,6 +1277,61 @@ std::vector<CTxMemPool::txiter> CTxMemPool::GatherClusters(const std::vector<uin
     return clustered_txs;
 }
 
+std::optional<CTxMemPool::ClusterLinearization> CTxMemPool::LinearizeCluster(const Txid& txid, uint64_t max_iterations) const
+{
+    AssertLockHeld(cs);
+    using SetType = BitSet<MAX_LINEARIZE_CLUSTER_COUNT>;
+
+    std::vector<txiter> cluster{GatherClusters({txid.ToUint256()})};
+    if (cluster.empty() || cluster.size() > MAX_LINEARIZE_CLUSTER_COUNT) return std::nullopt;
+
+    // Sorting by ancestor count gives a topologically valid starting linearization,
+    // and breaking ties by txid makes it independent of how the cluster was found.
+    std::sort(cluster.begin(), cluster.end(), [](txiter a, txiter b) {
+        if (a->GetCountWithAncestors() != b->GetCountWithAncestors()) {
+            return a->GetCountWithAncestors() < b->GetCountWithAncestors();
+        }
+        return a->GetTx().GetHash() < b->GetTx().GetHash();
+    });
+
+    std::map<const CTxMemPoolEntry*, cluster_linearize::ClusterIndex> positions;
+    cluster_linearize::DepGraph<SetType> depgraph;
+    for (const auto& it : cluster) {
+        positions.emplace(&*it, depgraph.AddTransaction(FeeFrac{it->GetModifiedFee(), it->GetTxSize()}));
+    }
+    for (const auto& it : cluster) {
+        for (const CTxMemPoolEntry& parent : it->GetMemPoolParentsConst()) {
+            depgraph.AddDependency(positions.at(&parent), positions.at(&*it));
+        }
+    }
+
+    std::vector<cluster_linearize::ClusterIndex> old_linearization(cluster.size());
+    std::iota(old_linearization.begin(), old_linearization.end(), 0);
+    // A fixed seed, so that the same cluster is always linearized (and evicted from) the same way.
+    auto [linearization, optimal] = cluster_linearize::Linearize(depgraph, max_iterations, /*rng_seed=*/0, old_linearization);
+    cluster_linearize::PostLinearize(depgraph, linearization);
+
+    ClusterLinearization result;
+    result.optimal = optimal;
+    result.chunk_feerates = cluster_linearize::ChunkLinearization(depgraph, linearization);
+    result.txs.reserve(linearization.size());
+    // Chunks are consecutive, so walk the linearization until each chunk's total is reached.
+    FeeFrac accumulated;
+    size_t chunk_size{0};
+    for (const auto idx : linearization) {
+        result.txs.push_back(cluster[idx]);
+        accumulated += depgraph.FeeRate(idx);
+        ++chunk_size;
+        if (accumulated == result.chunk_feerates[result.chunk_sizes.size()]) {
+            result.chunk_sizes.push_back(chunk_size);
+            accumulated = FeeFrac{};
+            chunk_size = 0;
+        }
+    }
+    Assume(result.chunk_sizes.size() == result.chunk_feerates.size());
+    return result;
+}
+
 std::optional<std::string> CTxMemPool::CheckConflictTopology(const setEntries& direct_conflicts)
 {
     for (const auto& direct_conflict : direct_conflicts) {
@@ -309,6 +309,12 @@ protected:
     CAmount m_total_fee GUARDED_BY(cs){0};       //!< sum of all mempool tx's fees (NOT modified fee)
     uint64_t cachedInnerUsage GUARDED_BY(cs){0}; //!< sum of dynamic memory usage of all the map elements (NOT the maps themselves)
 
+    //! size(), GetTotalTxSize() and DynamicMemoryUsage() as of the last
+    //! addition or removal, readable without cs.
+    std::atomic<uint64_t> m_published_count{0};
+    std::atomic<uint64_t> m_published_tx_size{0};
+    std::atomic<uint64_t> m_published_usage{0};
+
     mutable int64_t lastRollingFeeUpdate GUARDED_BY(cs){GetTime()};
     mutable bool blockSinceLastRollingFeeBump GUARDED_BY(cs){false};
     mutable double rollingMinimumFeeRate GUARDED_BY(cs){0}; //!< minimum fee to get into the pool, decreases exponentially
@@ -319,6 +325,10 @@ protected:
     // is added or removed from the mempool for any reason.
     mutable uint64_t m_sequence_number GUARDED_BY(cs){1};
 
+    // Incremented on every PrioritiseTransaction call, which changes modified
+    // fees without adding or removing transactions.
+    uint64_t m_fee_delta_version GUARDED_BY(cs){0};
+
     void trackPackageRemoved(const CFeeRate& rate) EXCLUSIVE_LOCKS_REQUIRED(cs);
 
     bool m_load_tried GUARDED_BY(cs){false};
@@ -585,6 +595,31 @@ public:
      * more transactions as a DoS protection. */
     std::vector<txiter> GatherClusters(const std::vector<uint256>& txids) const EXCLUSIVE_LOCKS_REQUIRED(cs);
 
+    /** Default iteration budget for LinearizeCluster callers. */
+    static constexpr uint64_t DEFAULT_CLUSTER_LINEARIZE_ITERATIONS{10'000};
+    /** Iteration budget of all the LinearizeCluster calls of one TrimToSize call, which holds cs. */
+    static constexpr uint64_t MAX_TRIM_LINEARIZE_ITERATIONS{5 * DEFAULT_CLUSTER_LINEARIZE_ITERATIONS};
+    /** Maximum number of transactions in a cluster that LinearizeCluster handles. */
+    static constexpr unsigned int MAX_LINEARIZE_CLUSTER_COUNT{64};
+
+    /** A cluster of transactions in linearized order, split into chunks. */
+    struct ClusterLinearization {
+        /** All transactions of the cluster, in a topologically valid order. */
+        std::vector<txiter> txs;
+        /** Fee and size of each chunk, in order of decreasing feerate. */
+        std::vector<FeeFrac> chunk_feerates;
+        /** Number of transactions in each chunk. Chunks cover consecutive ranges of txs. */
+        std::vector<size_t> chunk_sizes;
+        /** Whether the linearization is known to be optimal. */
+        bool optimal{false};
+    };
+
+    /** Linearize the cluster containing txid using the cluster_linearize engine, with
+     * modified fees. The result only depends on the cluster and max_iterations. Returns
+     * std::nullopt if txid is not in the mempool or its cluster has more than
+     * MAX_LINEARIZE_CLUSTER_COUNT transactions. */
+    std::optional<ClusterLinearization> LinearizeCluster(const Txid& txid, uint64_t max_iterations) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+
     /** Calculate all in-mempool ancestors of a set of transactions not already in the mempool and
      * check ancestor and descendant limits. Heuristics are used to estimate the ancestor and
      * descendant count of all entries if the package were to be added to the mempool.  The limits
@@ -656,6 +691,20 @@ public:
         return totalTxSize;
     }
 
+    struct PublishedStats {
+        uint64_t count;
+        uint64_t tx_size;
+        uint64_t usage;
+    };
+
+    /** Size statistics without taking cs, as of the last transaction added or removed. */
+    PublishedStats GetPublishedStats() const
+    {
+        return {m_published_count.load(std::memory_order_relaxed),
+                m_published_tx_size.load(std::memory_order_relaxed),
+                m_published_usage.load(std::memory_order_relaxed)};
+    }
+
     CAmount GetTotalFee() const EXCLUSIVE_LOCKS_REQUIRED(cs)
     {
         AssertLockHeld(cs);
@@ -724,6 +773,10 @@ public:
         return m_sequence_number;
     }
 
+    uint64_t GetFeeDeltaVersion() const EXCLUSIVE_LOCKS_REQUIRED(cs) {
+        return m_fee_delta_version;
+    }
+
     /**
      * Calculate the sorted chunks for the old and new mempool relating to the
      * clusters that would be affected by a potential replacement transaction.
@@ -797,6 +850,8 @@ private:
      *  removal.
      */
     void removeUnchecked(txiter entry, MemPoolRemovalReason reason) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    /** Update the statistics returned by GetPublishedStats(). */
+    void PublishStats() EXCLUSIVE_LOCKS_REQUIRED(cs);
 public:
     /** visited marks a CTxMemPoolEntry as having been traversed
      * during the lifetime of the most recently created Epoch::Guard
@@ -9,12 +9,15 @@
 #include <charconv>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <map>
+#include <memory>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 #include <system_error>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -97,6 +100,16 @@ public:
     std::string write(unsigned int prettyIndent = 0,
                       unsigned int indentLevel = 0) const;
 
+    using WriteFlushFn = std::function<void(std::string&)>;
+    /**
+     * Serialize by appending to s. Whenever s has grown to at least flush_size
+     * bytes after a complete array element or object member, flush is called to
+     * consume it (and is expected to clear s). This bounds the memory used for the
+     * serialized form of large values. The final part remains in s on return.
+     */
+    void write(std::string& s, const WriteFlushFn& flush, size_t flush_size,
+               unsigned int prettyIndent = 0) const;
+
     bool read(std::string_view raw);
 
 private:
@@ -104,11 +117,31 @@ private:
     std::string val;                       // numbers are stored as C++ strings
     std::vector<std::string> keys;
     std::vector<UniValue> values;
+    using KeyIndex = std::unordered_multimap<size_t, size_t>;
+    //! Owns a KeyIndex, if any, and copies it along with the UniValue.
+    struct KeyIndexPtr : std::unique_ptr<KeyIndex> {
+        KeyIndexPtr() = default;
+        KeyIndexPtr(KeyIndexPtr&&) noexcept = default;
+        KeyIndexPtr& operator=(KeyIndexPtr&&) noexcept = default;
+        KeyIndexPtr(const KeyIndexPtr& other) : std::unique_ptr<KeyIndex>{other ? std::make_unique<KeyIndex>(*other) : nullptr} {}
+        KeyIndexPtr& operator=(const KeyIndexPtr& other)
+        {
+            reset(other ? new KeyIndex{*other} : nullptr);
+            return *this;
+        }
+    };
+    //! Hash of key -> index into keys. Only allocated for objects with at
+    //! least KEY_INDEX_MIN_SIZE keys, so that other values stay small.
+    KeyIndexPtr m_key_index;
+
+    static constexpr size_t KEY_INDEX_MIN_SIZE{32};
 
     void checkType(const VType& expected) const;
-    bool findKey(const std::string& key, size_t& retIdx) const;
-    void writeArray(unsigned int prettyIndent, unsigned int indentLevel, std::string& s) const;
-    void writeObject(unsigned int prettyIndent, unsigned int indentLevel, std::string& s) const;
+    void indexLastKey();
+    bool findKey(std::string_view key, size_t& retIdx) const;
+    void writeTo(unsigned int prettyIndent, unsigned int indentLevel, std::string& s, const WriteFlushFn* flush, size_t flush_size) const;
+    void writeArray(unsigned int prettyIndent, unsigned int indentLevel, std::string& s, const WriteFlushFn* flush, size_t flush_size) const;
+    void writeObject(unsigned int prettyIndent, unsigned int indentLevel, std::string& s, const WriteFlushFn* flush, size_t flush_size) const;
 
 public:
     // Strict type-specific getters, these throw std::runtime_error if the
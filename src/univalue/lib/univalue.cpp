@@ -10,6 +10,8 @@
 #include <memory>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -21,6 +23,7 @@ void UniValue::clear()
     val.clear();
     keys.clear();
     values.clear();
+    m_key_index.reset();
 }
 
 void UniValue::setNull()
@@ -121,6 +124,7 @@ void UniValue::pushKVEnd(std::string key, UniValue val)
 
     keys.push_back(std::move(key));
     values.push_back(std::move(val));
+    indexLastKey();
 }
 
 void UniValue::pushKV(std::string key, UniValue val)
@@ -153,8 +157,37 @@ void UniValue::getObjMap(std::map<std::string,UniValue>& kv) const
         kv[keys[i]] = values[i];
 }
 
-bool UniValue::findKey(const std::string& key, size_t& retIdx) const
+void UniValue::indexLastKey()
 {
+    if (keys.size() < KEY_INDEX_MIN_SIZE) return;
+
+    const std::hash<std::string_view> hasher;
+    if (keys.size() == KEY_INDEX_MIN_SIZE) {
+        m_key_index.reset(new KeyIndex);
+        m_key_index->reserve(keys.size());
+        for (size_t i = 0; i < keys.size(); i++) {
+            m_key_index->emplace(hasher(keys[i]), i);
+        }
+    } else {
+        m_key_index->emplace(hasher(keys.back()), keys.size() - 1);
+    }
+}
+
+bool UniValue::findKey(std::string_view key, size_t& retIdx) const
+{
+    if (m_key_index) {
+        // Keys need not be unique, return the first match like the linear search
+        bool found{false};
+        const auto [first, last] = m_key_index->equal_range(std::hash<std::string_view>{}(key));
+        for (auto it = first; it != last; ++it) {
+            if (keys[it->second] == key && (!found || it->second < retIdx)) {
+                retIdx = it->second;
+                found = true;
+            }
+        }
+        return found;
+    }
+
     for (size_t i = 0; i < keys.size(); i++) {
         if (keys[i] == key) {
             retIdx = i;
@@ -232,11 +265,10 @@ const char *uvTypeName(UniValue::VType t)
 
 const UniValue& UniValue::find_value(std::string_view key) const
 {
-    for (unsigned int i = 0; i < keys.size(); ++i) {
-        if (keys[i] == key) {
-            return values.at(i);
-        }
-    }
-    return NullUniValue;
+    size_t index = 0;
+    if (!findKey(key, index))
+        return NullUniValue;
+
+    return values.at(index);
 }
 
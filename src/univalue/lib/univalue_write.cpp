@@ -5,35 +5,47 @@
 #include <univalue.h>
 #include <univalue_escapes.h>
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
 
-static std::string json_escape(const std::string& inS)
+static void json_escape(const std::string& inS, std::string& outS)
 {
-    std::string outS;
-    outS.reserve(inS.size() * 2);
-
-    for (unsigned int i = 0; i < inS.size(); i++) {
+    // Copy runs of characters that need no escaping in one go
+    size_t run_start = 0;
+    for (size_t i = 0; i < inS.size(); i++) {
         unsigned char ch = static_cast<unsigned char>(inS[i]);
         const char *escStr = escapes[ch];
 
-        if (escStr)
+        if (escStr) {
+            outS.append(inS, run_start, i - run_start);
             outS += escStr;
-        else
-            outS += static_cast<char>(ch);
+            run_start = i + 1;
+        }
     }
-
-    return outS;
+    outS.append(inS, run_start, inS.size() - run_start);
 }
 
-// NOLINTNEXTLINE(misc-no-recursion)
 std::string UniValue::write(unsigned int prettyIndent,
                             unsigned int indentLevel) const
 {
     std::string s;
     s.reserve(1024);
+    writeTo(prettyIndent, indentLevel, s, nullptr, 0);
+    return s;
+}
+
+void UniValue::write(std::string& s, const WriteFlushFn& flush, size_t flush_size,
+                     unsigned int prettyIndent) const
+{
+    writeTo(prettyIndent, 0, s, &flush, flush_size);
+}
 
+// NOLINTNEXTLINE(misc-no-recursion)
+void UniValue::writeTo(unsigned int prettyIndent, unsigned int indentLevel, std::string& s,
+                       const WriteFlushFn* flush, size_t flush_size) const
+{
     unsigned int modIndent = indentLevel;
     if (modIndent == 0)
         modIndent = 1;
@@ -43,13 +55,15 @@ std::string UniValue::write(unsigned int prettyIndent,
         s += "null";
         break;
     case VOBJ:
-        writeObject(prettyIndent, modIndent, s);
+        writeObject(prettyIndent, modIndent, s, flush, flush_size);
         break;
     case VARR:
-        writeArray(prettyIndent, modIndent, s);
+        writeArray(prettyIndent, modIndent, s, flush, flush_size);
         break;
     case VSTR:
-        s += "\"" + json_escape(val) + "\"";
+        s += '"';
+        json_escape(val, s);
+        s += '"';
         break;
     case VNUM:
         s += val;
@@ -58,8 +72,6 @@ std::string UniValue::write(unsigned int prettyIndent,
         s += (val == "1" ? "true" : "false");
         break;
     }
-
-    return s;
 }
 
 static void indentStr(unsigned int prettyIndent, unsigned int indentLevel, std::string& s)
@@ -67,8 +79,16 @@ static void indentStr(unsigned int prettyIndent, unsigned int indentLevel, std::
     s.append(prettyIndent * indentLevel, ' ');
 }
 
+static void maybeFlush(std::string& s, const UniValue::WriteFlushFn* flush, size_t flush_size)
+{
+    if (flush && s.size() >= flush_size) {
+        (*flush)(s);
+    }
+}
+
 // NOLINTNEXTLINE(misc-no-recursion)
-void UniValue::writeArray(unsigned int prettyIndent, unsigned int indentLevel, std::string& s) const
+void UniValue::writeArray(unsigned int prettyIndent, unsigned int indentLevel, std::string& s,
+                          const WriteFlushFn* flush, size_t flush_size) const
 {
     s += "[";
     if (prettyIndent)
@@ -77,12 +97,13 @@ void UniValue::writeArray(unsigned int prettyIndent, unsigned int indentLevel, s
     for (unsigned int i = 0; i < values.size(); i++) {
         if (prettyIndent)
             indentStr(prettyIndent, indentLevel, s);
-        s += values[i].write(prettyIndent, indentLevel + 1);
+        values[i].writeTo(prettyIndent, indentLevel + 1, s, flush, flush_size);
         if (i != (values.size() - 1)) {
             s += ",";
         }
         if (prettyIndent)
             s += "\n";
+        maybeFlush(s, flush, flush_size);
     }
 
     if (prettyIndent)
@@ -91,7 +112,8 @@ void UniValue::writeArray(unsigned int prettyIndent, unsigned int indentLevel, s
 }
 
 // NOLINTNEXTLINE(misc-no-recursion)
-void UniValue::writeObject(unsigned int prettyIndent, unsigned int indentLevel, std::string& s) const
+void UniValue::writeObject(unsigned int prettyIndent, unsigned int indentLevel, std::string& s,
+                           const WriteFlushFn* flush, size_t flush_size) const
 {
     s += "{";
     if (prettyIndent)
@@ -100,18 +122,20 @@ void UniValue::writeObject(unsigned int prettyIndent, unsigned int indentLevel,
     for (unsigned int i = 0; i < keys.size(); i++) {
         if (prettyIndent)
             indentStr(prettyIndent, indentLevel, s);
-        s += "\"" + json_escape(keys[i]) + "\":";
+        s += '"';
+        json_escape(keys[i], s);
+        s += "\":";
         if (prettyIndent)
             s += " ";
-        s += values.at(i).write(prettyIndent, indentLevel + 1);
+        values.at(i).writeTo(prettyIndent, indentLevel + 1, s, flush, flush_size);
         if (i != (values.size() - 1))
             s += ",";
         if (prettyIndent)
             s += "\n";
+        maybeFlush(s, flush, flush_size);
     }
 
     if (prettyIndent)
         indentStr(prettyIndent, indentLevel - 1, s);
     s += "}";
 }
-
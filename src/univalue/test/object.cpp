@@ -455,6 +455,69 @@ void univalue_readwrite()
     BOOST_CHECK(!v.read("{} 42"));
 }
 
+void univalue_write_flush()
+{
+    UniValue v(UniValue::VARR);
+    for (int i = 0; i < 100; ++i) {
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("index", i);
+        obj.pushKV("name", "entry \"" + std::to_string(i) + "\"");
+        obj.pushKV("values", UniValue(UniValue::VARR));
+        v.push_back(std::move(obj));
+    }
+
+    for (unsigned int indent : {0, 4}) {
+        std::string streamed;
+        std::string buffer;
+        size_t flushes = 0;
+        v.write(buffer, [&](std::string& s) {
+            BOOST_CHECK(s.size() >= 64);
+            streamed += s;
+            s.clear();
+            ++flushes;
+        }, /*flush_size=*/64, indent);
+        streamed += buffer;
+        BOOST_CHECK(flushes > 1);
+        BOOST_CHECK_EQUAL(streamed, v.write(indent));
+    }
+}
+
+void univalue_large_object()
+{
+    // Large enough that lookups go through the key index
+    UniValue obj(UniValue::VOBJ);
+    for (int i = 0; i < 100; ++i) {
+        obj.pushKVEnd("key" + std::to_string(i), i);
+    }
+    obj.pushKVEnd("key7", "duplicate");
+    obj.pushKV("key42", "replaced");
+    BOOST_CHECK_EQUAL(obj.size(), 101U);
+    BOOST_CHECK_EQUAL(obj["key0"].getInt<int>(), 0);
+    BOOST_CHECK_EQUAL(obj["key99"].getInt<int>(), 99);
+    BOOST_CHECK_EQUAL(obj["key7"].getInt<int>(), 7);
+    BOOST_CHECK_EQUAL(obj.find_value("key42").get_str(), "replaced");
+    BOOST_CHECK(!obj.exists("key100"));
+
+    // The index survives copies, round trips and clears
+    UniValue copy{obj};
+    BOOST_CHECK_EQUAL(copy["key55"].getInt<int>(), 55);
+    copy.pushKVEnd("key100", 100);
+    BOOST_CHECK_EQUAL(copy["key100"].getInt<int>(), 100);
+    BOOST_CHECK(!obj.exists("key100"));
+    copy = obj;
+    BOOST_CHECK(!copy.exists("key100"));
+    BOOST_CHECK_EQUAL(copy["key99"].getInt<int>(), 99);
+    UniValue parsed;
+    BOOST_CHECK(parsed.read(obj.write()));
+    BOOST_CHECK_EQUAL(parsed.size(), 101U);
+    BOOST_CHECK_EQUAL(parsed["key7"].getInt<int>(), 7);
+    BOOST_CHECK_EQUAL(parsed["key42"].get_str(), "replaced");
+    parsed.setObject();
+    BOOST_CHECK(!parsed.exists("key7"));
+    parsed.pushKV("key7", 1);
+    BOOST_CHECK_EQUAL(parsed["key7"].getInt<int>(), 1);
+}
+
 int main(int argc, char* argv[])
 {
     univalue_constructor();
@@ -464,5 +527,7 @@ int main(int argc, char* argv[])
     univalue_array();
     univalue_object();
     univalue_readwrite();
+    univalue_write_flush();
+    univalue_large_object();
     return 0;
 }
@@ -0,0 +1,184 @@
+// Copyright (c) 2024 The Krepto core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <util/flightrecorder.h>
+
+#include <crypto/common.h>
+#include <logging.h>
+#include <threadsafety.h>
+#include <util/fs_helpers.h>
+#include <util/syserror.h>
+#include <util/threadnames.h>
+#include <util/time.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <list>
+#include <string>
+#include <vector>
+
+#ifdef WIN32
+#include <cstdio>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace flightrecorder {
+namespace {
+
+constexpr char MAGIC[8]{'K', 'R', 'F', 'L', 'T', 'R', 'E', 'C'};
+
+/** One recording file. Never freed, so that a thread still holding a pointer to it stays safe. */
+struct Region {
+    unsigned char* base{nullptr};
+    size_t size{0};
+    size_t records_per_thread{0};
+    mutable std::atomic<size_t> slots_claimed{0};
+#ifdef WIN32
+    //! There is no portable shared file mapping; record to memory and write it out on Stop().
+    std::vector<unsigned char> memory;
+    fs::path path;
+#endif
+
+    unsigned char* SlotHeader(size_t slot) const { return base + FILE_HEADER_SIZE + slot * SLOT_HEADER_SIZE; }
+    unsigned char* Records(size_t slot) const
+    {
+        return base + FILE_HEADER_SIZE + MAX_THREADS * SLOT_HEADER_SIZE + slot * records_per_thread * RECORD_SIZE;
+    }
+};
+
+StdMutex g_mutex;
+std::list<Region> g_regions GUARDED_BY(g_mutex);
+std::atomic<Region*> g_region{nullptr};
+
+/** The current thread's slot in the region it last recorded to. */
+struct ThreadSlot {
+    const Region* region{nullptr};
+    unsigned char* header{nullptr};
+    unsigned char* records{nullptr};
+    uint64_t count{0};
+};
+thread_local ThreadSlot g_thread_slot;
+
+uint64_t ToNanos(std::chrono::nanoseconds since_epoch) { return static_cast<uint64_t>(since_epoch.count()); }
+
+} // namespace
+
+namespace detail {
+std::atomic<bool> g_enabled{false};
+
+void Record(Event event, uint32_t aux, uint64_t a, uint64_t b) noexcept
+{
+    const Region* region{g_region.load(std::memory_order_acquire)};
+    if (!region) return;
+    ThreadSlot& slot{g_thread_slot};
+    if (slot.region != region) {
+        slot = ThreadSlot{.region = region};
+        const size_t index{region->slots_claimed.fetch_add(1, std::memory_order_relaxed)};
+        if (index >= MAX_THREADS) return;
+        slot.header = region->SlotHeader(index);
+        slot.records = region->Records(index);
+        const std::string name{util::ThreadGetInternalName()};
+        std::memcpy(slot.header + 8, name.data(), std::min(name.size(), SLOT_HEADER_SIZE - 9));
+    }
+    if (!slot.records) return;
+
+    unsigned char* record{slot.records + (slot.count % region->records_per_thread) * RECORD_SIZE};
+    WriteLE64(record, ToNanos(SteadyClock::now().time_since_epoch()));
+    WriteLE16(record + 8, static_cast<uint16_t>(event));
+    WriteLE16(record + 10, 0);
+    WriteLE32(record + 12, aux);
+    WriteLE64(record + 16, a);
+    WriteLE64(record + 24, b);
+    // Only published once the record is complete, so the decoder never sees a
+    // partially written one unless the process died in between.
+    std::atomic_signal_fence(std::memory_order_release);
+    WriteLE64(slot.header, ++slot.count);
+}
+} // namespace detail
+
+bool Start(const fs::path& path, size_t records_per_thread)
+{
+    Stop();
+    records_per_thread = std::clamp<size_t>(records_per_thread, 1, MAX_RECORDS_PER_THREAD);
+    const size_t size{FILE_HEADER_SIZE + MAX_THREADS * (SLOT_HEADER_SIZE + records_per_thread * RECORD_SIZE)};
+
+    if (fs::exists(path) && !RenameOver(path, fs::path{path} += ".old")) {
+        LogPrintf("Unable to keep previous flight recorder file %s\n", fs::PathToString(path));
+    }
+
+    StdLockGuard lock{g_mutex};
+    Region& region{g_regions.emplace_back()};
+    region.size = size;
+    region.records_per_thread = records_per_thread;
+#ifdef WIN32
+    region.memory.assign(size, 0);
+    region.base = region.memory.data();
+    region.path = path;
+#else
+    const int fd{open(fs::PathToString(path).c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600)};
+    if (fd == -1) {
+        LogPrintf("Unable to create flight recorder file %s: %s\n", fs::PathToString(path), SysErrorString(errno));
+        g_regions.pop_back();
+        return false;
+    }
+    void* base{MAP_FAILED};
+    if (ftruncate(fd, size) == 0) {
+        base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    const int error{errno};
+    close(fd);
+    if (base == MAP_FAILED) {
+        LogPrintf("Unable to map flight recorder file %s: %s\n", fs::PathToString(path), SysErrorString(error));
+        g_regions.pop_back();
+        return false;
+    }
+    region.base = static_cast<unsigned char*>(base);
+#endif
+
+    std::memcpy(region.base, MAGIC, sizeof(MAGIC));
+    WriteLE32(region.base + 8, FORMAT_VERSION);
+    WriteLE32(region.base + 12, RECORD_SIZE);
+    WriteLE32(region.base + 16, MAX_THREADS);
+    WriteLE32(region.base + 20, records_per_thread);
+    WriteLE64(region.base + 24, ToNanos(SteadyClock::now().time_since_epoch()));
+    WriteLE64(region.base + 32, ToNanos(SystemClock::now().time_since_epoch()));
+
+    g_region.store(&region, std::memory_order_release);
+    detail::g_enabled.store(true, std::memory_order_relaxed);
+    LogPrintf("Flight recorder writing %u records per thread to %s\n", records_per_thread, fs::PathToString(path));
+    return true;
+}
+
+void Stop()
+{
+    detail::g_enabled.store(false, std::memory_order_relaxed);
+    Region* region{g_region.exchange(nullptr)};
+    if (!region) return;
+#ifdef WIN32
+    if (FILE* file{fsbridge::fopen(region->path, "wb")}) {
+        fwrite(region->base, 1, region->size, file);
+        fclose(file);
+    }
+#else
+    msync(region->base, region->size, MS_SYNC);
+#endif
+}
+
+bool IsEnabled()
+{
+    return detail::g_enabled.load(std::memory_order_relaxed);
+}
+
+uint64_t PackMessageType(std::string_view msg_type) noexcept
+{
+    unsigned char packed[8]{};
+    std::memcpy(packed, msg_type.data(), std::min(msg_type.size(), sizeof(packed)));
+    return ReadLE64(packed);
+}
+
+} // namespace flightrecorder
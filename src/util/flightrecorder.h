@@ -0,0 +1,104 @@
+// Copyright (c) 2024 The Krepto core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_UTIL_FLIGHTRECORDER_H
+#define BITCOIN_UTIL_FLIGHTRECORDER_H
+
+#include <util/fs.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * Always-on binary event recorder for latency diagnosis.
+ *
+ * Every thread that records an event is given its own ring of fixed-size
+ * records inside a single file that is memory-mapped for the lifetime of the
+ * process, so recording is a handful of stores with no locking and no system
+ * calls, and the most recent events survive a crash or a hang. The file is
+ * decoded offline by contrib/flightrecorder/decode.py; its layout (all
+ * integers little-endian) is:
+ *
+ *  - a FILE_HEADER_SIZE byte file header: magic, format version, record size,
+ *    number of thread slots, records per slot, and the steady clock and system
+ *    clock (both in nanoseconds) at startup.
+ *  - MAX_THREADS slot headers of SLOT_HEADER_SIZE bytes: the number of records
+ *    the thread has written so far and its name.
+ *  - MAX_THREADS rings of records_per_thread RECORD_SIZE byte records: steady
+ *    clock nanoseconds, event type (u16), a reserved u16, an event specific
+ *    u32 and two event specific u64 values.
+ */
+namespace flightrecorder {
+
+static constexpr bool DEFAULT_FLIGHTRECORDER{false};
+static constexpr size_t DEFAULT_RECORDS_PER_THREAD{8192};
+static constexpr size_t MAX_RECORDS_PER_THREAD{1 << 20};
+//! Threads that record after all slots are taken are not recorded.
+static constexpr size_t MAX_THREADS{64};
+
+static constexpr uint32_t FORMAT_VERSION{1};
+static constexpr size_t FILE_HEADER_SIZE{64};
+static constexpr size_t SLOT_HEADER_SIZE{64};
+static constexpr size_t RECORD_SIZE{32};
+
+/** Event types. The meaning of the event specific fields is given as (u32, u64, u64). */
+enum class Event : uint16_t {
+    //! (ConnectPhase, block height, phase duration in ns)
+    CONNECT_PHASE = 1,
+    //! (FlushStateMode, number of coins, flush duration in ns)
+    COINS_FLUSH = 2,
+    //! (message size, peer id, message type as returned by PackMessageType)
+    MESSAGE_RECV = 3,
+    //! (message size, peer id, message type as returned by PackMessageType)
+    MESSAGE_SEND = 4,
+    //! (virtual size, first 8 bytes of the wtxid, validation duration in ns)
+    MEMPOOL_ACCEPT = 5,
+    //! (TxValidationResult, first 8 bytes of the wtxid, validation duration in ns)
+    MEMPOOL_REJECT = 6,
+};
+
+/** The phases of Chainstate::ConnectTip(), in order. */
+enum class ConnectPhase : uint32_t {
+    LOAD_BLOCK = 0,
+    CONNECT_BLOCK = 1,
+    FLUSH_VIEW = 2,
+    WRITE_CHAINSTATE = 3,
+    POSTPROCESS = 4,
+};
+
+/**
+ * Create the recording file at path (an existing file is kept as path.old)
+ * and start recording, keeping the last records_per_thread records of each
+ * thread, clamped to [1, MAX_RECORDS_PER_THREAD]. Returns false if the file
+ * could not be created.
+ */
+bool Start(const fs::path& path, size_t records_per_thread);
+
+/**
+ * Stop recording and flush the file to disk. The mapping itself is kept, as
+ * other threads may still be writing their last record to it.
+ */
+void Stop();
+
+bool IsEnabled();
+
+/** Pack the first 8 characters of a message type into an integer, so that its bytes spell it out. */
+uint64_t PackMessageType(std::string_view msg_type) noexcept;
+
+namespace detail {
+extern std::atomic<bool> g_enabled;
+void Record(Event event, uint32_t aux, uint64_t a, uint64_t b) noexcept;
+} // namespace detail
+
+/** Record an event. Costs a single relaxed load when the recorder is off. */
+inline void Record(Event event, uint32_t aux, uint64_t a, uint64_t b) noexcept
+{
+    if (detail::g_enabled.load(std::memory_order_relaxed)) detail::Record(event, aux, a, b);
+}
+
+} // namespace flightrecorder
+
+#endif // BITCOIN_UTIL_FLIGHTRECORDER_H
@@ -0,0 +1,68 @@
+// Copyright (c) 2024 The Krepto core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <util/latencyhistogram.h>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+size_t LatencyHistogram::BucketIndex(uint64_t value) noexcept
+{
+    if (value < SUB_BUCKETS) return value;
+    const int shift{static_cast<int>(std::bit_width(value)) - 1 - SUB_BUCKET_BITS};
+    return ((shift + 1) << SUB_BUCKET_BITS) + ((value >> shift) - SUB_BUCKETS);
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(size_t index) noexcept
+{
+    if (index < SUB_BUCKETS) return index;
+    const int shift{static_cast<int>(index >> SUB_BUCKET_BITS) - 1};
+    const uint64_t mantissa{(index & (SUB_BUCKETS - 1)) + SUB_BUCKETS};
+    return (mantissa << shift) + ((uint64_t{1} << shift) - 1);
+}
+
+void LatencyHistogram::Record(uint64_t value) noexcept
+{
+    m_buckets[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+    uint64_t max{m_max.load(std::memory_order_relaxed)};
+    while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {}
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::GetSnapshot() const
+{
+    Snapshot ret;
+    ret.count = m_count.load(std::memory_order_relaxed);
+    ret.sum = m_sum.load(std::memory_order_relaxed);
+    ret.max = m_max.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        ret.buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+    }
+    return ret;
+}
+
+void LatencyHistogram::Reset() noexcept
+{
+    for (auto& bucket : m_buckets) bucket.store(0, std::memory_order_relaxed);
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::Snapshot::Percentile(double percentile) const
+{
+    uint64_t total{0};
+    for (uint64_t n : buckets) total += n;
+    if (total == 0) return 0;
+    // Rank of the wanted value, counting from 1.
+    const uint64_t rank{std::clamp<uint64_t>(static_cast<uint64_t>(std::ceil(total * std::clamp(percentile, 0.0, 100.0) / 100)), 1, total)};
+    uint64_t seen{0};
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) return std::min(BucketUpperBound(i), max);
+    }
+    return max;
+}
@@ -0,0 +1,64 @@
+// Copyright (c) 2024 The Krepto core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_UTIL_LATENCYHISTOGRAM_H
+#define BITCOIN_UTIL_LATENCYHISTOGRAM_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Lock-free histogram of non-negative integers (typically latencies in
+ * microseconds) with log-linear buckets, as in HdrHistogram: values below
+ * 2^SUB_BUCKET_BITS each get a bucket of their own, and every larger power of
+ * two range is split into 2^SUB_BUCKET_BITS equal buckets. Percentiles are thus
+ * accurate to within 1/2^SUB_BUCKET_BITS of the value over the full 64-bit
+ * range, at a fixed memory cost.
+ *
+ * Record() is safe to call concurrently with itself, GetSnapshot() and Reset().
+ * A snapshot taken concurrently with Record() calls may include some of them
+ * only partially (e.g. in the count but not yet in the sum).
+ */
+class LatencyHistogram
+{
+public:
+    static constexpr int SUB_BUCKET_BITS{4};
+    static constexpr size_t SUB_BUCKETS{size_t{1} << SUB_BUCKET_BITS};
+    static constexpr size_t BUCKETS{(64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS};
+
+    struct Snapshot {
+        uint64_t count{0};
+        uint64_t sum{0};
+        uint64_t max{0};
+        std::array<uint64_t, BUCKETS> buckets{};
+
+        /**
+         * Smallest value v such that at least percentile% of the recorded
+         * values are <= v, rounded up to its bucket's upper bound (but never
+         * more than the largest value recorded). 0 if nothing was recorded.
+         */
+        uint64_t Percentile(double percentile) const;
+    };
+
+    void Record(uint64_t value) noexcept;
+    Snapshot GetSnapshot() const;
+    //! Cheaper than GetSnapshot() when the distribution is not needed.
+    uint64_t GetCount() const noexcept { return m_count.load(std::memory_order_relaxed); }
+    uint64_t GetSum() const noexcept { return m_sum.load(std::memory_order_relaxed); }
+    void Reset() noexcept;
+
+    static size_t BucketIndex(uint64_t value) noexcept;
+    //! Largest value counted in the given bucket.
+    static uint64_t BucketUpperBound(size_t index) noexcept;
+
+private:
+    std::atomic<uint64_t> m_count{0};
+    std::atomic<uint64_t> m_sum{0};
+    std::atomic<uint64_t> m_max{0};
+    std::array<std::atomic<uint64_t>, BUCKETS> m_buckets{};
+};
+
+#endif // BITCOIN_UTIL_LATENCYHISTOGRAM_H
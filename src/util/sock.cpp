@@ -11,6 +11,7 @@
 #include <util/threadinterrupt.h>
 #include <util/time.h>
 
+#include <array>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -19,6 +20,10 @@
 #include <poll.h>
 #endif
 
+#ifndef WIN32
+#include <sys/uio.h>
+#endif
+
 static inline bool IOErrorIsPermanent(int err)
 {
     return err != WSAEAGAIN && err != WSAEINTR && err != WSAEWOULDBLOCK && err != WSAEINPROGRESS;
@@ -47,6 +52,31 @@ ssize_t Sock::Send(const void* data, size_t len, int flags) const
     return send(m_socket, static_cast<const char*>(data), len, flags);
 }
 
+ssize_t Sock::SendMany(Span<const Span<const unsigned char>> bufs, int flags) const
+{
+#ifdef WIN32
+    for (const auto& buf : bufs) {
+        if (!buf.empty()) return Send(buf.data(), buf.size(), flags);
+    }
+    return 0;
+#else
+    static constexpr size_t MAX_IOVECS{16};
+    std::array<iovec, MAX_IOVECS> iov;
+    size_t count{0};
+    for (const auto& buf : bufs) {
+        if (buf.empty()) continue;
+        if (count == iov.size()) break;
+        iov[count].iov_base = const_cast<unsigned char*>(buf.data());
+        iov[count].iov_len = buf.size();
+        ++count;
+    }
+    msghdr msg{};
+    msg.msg_iov = iov.data();
+    msg.msg_iovlen = count;
+    return sendmsg(m_socket, &msg, flags);
+#endif
+}
+
 ssize_t Sock::Recv(void* buf, size_t len, int flags) const
 {
     return recv(m_socket, static_cast<char*>(buf), len, flags);
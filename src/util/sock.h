@@ -6,6 +6,7 @@
 #define BITCOIN_UTIL_SOCK_H
 
 #include <compat/compat.h>
+#include <span.h>
 #include <util/threadinterrupt.h>
 #include <util/time.h>
 
@@ -64,6 +65,14 @@ public:
      */
     [[nodiscard]] virtual ssize_t Send(const void* data, size_t len, int flags) const;
 
+    /**
+     * sendmsg(2) wrapper that sends the concatenation of `bufs` in a single call. Where
+     * sendmsg(2) is not available only the first non-empty buffer is sent, which the caller
+     * sees as a short write. Code that uses this wrapper can be unit tested if this method
+     * is overridden by a mock Sock implementation.
+     */
+    [[nodiscard]] virtual ssize_t SendMany(Span<const Span<const unsigned char>> bufs, int flags) const;
+
     /**
      * recv(2) wrapper. Equivalent to `recv(m_socket, buf, len, flags);`. Code that uses this
      * wrapper can be unit tested if this method is overridden by a mock Sock implementation.
@@ -49,6 +49,7 @@
 #include <uint256.h>
 #include <undo.h>
 #include <util/check.h>
+#include <util/flightrecorder.h>
 #include <util/fs.h>
 #include <util/fs_helpers.h>
 #include <util/hasher.h>
@@ -292,6 +293,46 @@ static bool IsCurrentForFeeEstimation(Chainstate& active_chainstate) EXCLUSIVE_L
     return true;
 }
 
+/**
+ * Verify the input scripts of resurrected transactions on the script check
+ * queue so that the signature cache is warm when they are re-accepted to the
+ * mempool one at a time. txs must be in the order they were confirmed in.
+ * This is best effort: failures are ignored here and left for
+ * AcceptToMemoryPool to report.
+ */
+static void PrewarmSignatureCacheForReorg(ChainstateManager& chainman, CCoinsViewCache& coins_tip,
+                                          const std::vector<CTransactionRef>& txs)
+    EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    AssertLockHeld(cs_main);
+    if (txs.size() < 2 || !chainman.GetCheckQueue().HasThreads()) return;
+
+    const auto time_start{SteadyClock::now()};
+    // Outputs of earlier resurrected transactions are added to this view so
+    // that chains of them can be checked together.
+    CCoinsViewCache view{&coins_tip};
+    // Keep txsdata alive until control has run the checks; it is never resized.
+    std::vector<PrecomputedTransactionData> txsdata(txs.size());
+    CCheckQueueControl<CScriptCheck> control(&chainman.GetCheckQueue());
+    for (size_t i{0}; i < txs.size(); ++i) {
+        const CTransaction& tx{*txs[i]};
+        if (tx.IsCoinBase()) continue;
+        if (!std::all_of(tx.vin.begin(), tx.vin.end(), [&](const CTxIn& txin) { return view.HaveCoin(txin.prevout); })) {
+            continue;
+        }
+        std::vector<CScriptCheck> checks;
+        TxValidationState state;
+        if (CheckInputScripts(tx, state, view, STANDARD_SCRIPT_VERIFY_FLAGS, /*cacheSigStore=*/true,
+                              /*cacheFullScriptStore=*/false, txsdata[i], chainman.m_validation_cache, &checks)) {
+            control.Add(std::move(checks));
+        }
+        AddCoins(view, tx, MEMPOOL_HEIGHT);
+    }
+    control.Wait();
+    LogDebug(BCLog::MEMPOOL, "Prewarmed signature cache for %u resurrected transactions in %.2fms\n",
+             txs.size(), Ticks<MillisecondsDouble>(SteadyClock::now() - time_start));
+}
+
 void Chainstate::MaybeUpdateMempoolForReorg(
     DisconnectedBlockTransactions& disconnectpool,
     bool fAddToMempool)
@@ -308,6 +349,9 @@ void Chainstate::MaybeUpdateMempoolForReorg(
         // back to the mempool starting with the earliest transaction that had
         // been previously seen in a block.
         const auto queuedTx = disconnectpool.take();
+        if (fAddToMempool) {
+            PrewarmSignatureCacheForReorg(m_chainman, CoinsTip(), {queuedTx.rbegin(), queuedTx.rend()});
+        }
         auto it = queuedTx.rbegin();
         while (it != queuedTx.rend()) {
             // ignore validation errors in resurrected transactions
@@ -1862,6 +1906,7 @@ MempoolAcceptResult AcceptToMemoryPool(Chainstate& active_chainstate, const CTra
     assert(active_chainstate.GetMempool() != nullptr);
     CTxMemPool& pool{*active_chainstate.GetMempool()};
 
+    const auto time_start{SteadyClock::now()};
     std::vector<COutPoint> coins_to_uncache;
     auto args = MemPoolAccept::ATMPArgs::SingleAccept(chainparams, accept_time, bypass_limits, coins_to_uncache, test_accept);
     MempoolAcceptResult result = MemPoolAccept(pool, active_chainstate).AcceptSingleTransaction(tx, args);
@@ -1877,6 +1922,11 @@ MempoolAcceptResult AcceptToMemoryPool(Chainstate& active_chainstate, const CTra
                 tx->GetHash().data(),
                 result.m_state.GetRejectReason().c_str()
         );
+        flightrecorder::Record(flightrecorder::Event::MEMPOOL_REJECT, static_cast<uint32_t>(result.m_state.GetResult()),
+                               tx->GetWitnessHash().ToUint256().GetUint64(0), Ticks<std::chrono::nanoseconds>(SteadyClock::now() - time_start));
+    } else {
+        flightrecorder::Record(flightrecorder::Event::MEMPOOL_ACCEPT, result.m_vsize.value_or(0),
+                               tx->GetWitnessHash().ToUint256().GetUint64(0), Ticks<std::chrono::nanoseconds>(SteadyClock::now() - time_start));
     }
     // After we've (potentially) uncached entries, ensure our coins cache is still within its size limits
     BlockValidationState state_dummy;
@@ -1973,6 +2023,8 @@ void Chainstate::InitCoinsDB(
             .memory_only = in_memory,
             .wipe_data = should_wipe,
             .obfuscate = true,
+            // Every new transaction output is looked up before it is added.
+            .tuning = {.bloom_filter = true, .max_file_size = DB_MAX_TABLE_FILE_SIZE},
             .options = m_chainman.m_options.coins_db},
         m_chainman.m_options.coins_view);
 }
@@ -2487,6 +2539,7 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
 
     const auto time_1{SteadyClock::now()};
     m_chainman.time_check += time_1 - time_start;
+    m_chainman.RecordValidationTime(ValidationPhase::CHECK_BLOCK, time_1 - time_start);
     LogPrint(BCLog::BENCH, "    - Sanity checks: %.2fms [%.2fs (%.2fms/blk)]\n",
              Ticks<MillisecondsDouble>(time_1 - time_start),
              Ticks<SecondsDouble>(m_chainman.time_check),
@@ -2589,6 +2642,7 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
 
     const auto time_2{SteadyClock::now()};
     m_chainman.time_forks += time_2 - time_1;
+    m_chainman.RecordValidationTime(ValidationPhase::FORKS, time_2 - time_1);
     LogPrint(BCLog::BENCH, "    - Fork checks: %.2fms [%.2fs (%.2fms/blk)]\n",
              Ticks<MillisecondsDouble>(time_2 - time_1),
              Ticks<SecondsDouble>(m_chainman.time_forks),
@@ -2680,6 +2734,7 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
     }
     const auto time_3{SteadyClock::now()};
     m_chainman.time_connect += time_3 - time_2;
+    m_chainman.RecordValidationTime(ValidationPhase::CONNECT_TRANSACTIONS, time_3 - time_2);
     LogPrint(BCLog::BENCH, "      - Connect %u transactions: %.2fms (%.3fms/tx, %.3fms/txin) [%.2fs (%.2fms/blk)]\n", (unsigned)block.vtx.size(),
              Ticks<MillisecondsDouble>(time_3 - time_2), Ticks<MillisecondsDouble>(time_3 - time_2) / block.vtx.size(),
              nInputs <= 1 ? 0 : Ticks<MillisecondsDouble>(time_3 - time_2) / (nInputs - 1),
@@ -2698,6 +2753,7 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
     }
     const auto time_4{SteadyClock::now()};
     m_chainman.time_verify += time_4 - time_2;
+    m_chainman.RecordValidationTime(ValidationPhase::VERIFY_INPUTS, time_4 - time_2);
     LogPrint(BCLog::BENCH, "    - Verify %u txins: %.2fms (%.3fms/txin) [%.2fs (%.2fms/blk)]\n", nInputs - 1,
              Ticks<MillisecondsDouble>(time_4 - time_2),
              nInputs <= 1 ? 0 : Ticks<MillisecondsDouble>(time_4 - time_2) / (nInputs - 1),
@@ -2713,6 +2769,7 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
 
     const auto time_5{SteadyClock::now()};
     m_chainman.time_undo += time_5 - time_4;
+    m_chainman.RecordValidationTime(ValidationPhase::WRITE_UNDO, time_5 - time_4);
     LogPrint(BCLog::BENCH, "    - Write undo data: %.2fms [%.2fs (%.2fms/blk)]\n",
              Ticks<MillisecondsDouble>(time_5 - time_4),
              Ticks<SecondsDouble>(m_chainman.time_undo),
@@ -2728,6 +2785,7 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
 
     const auto time_6{SteadyClock::now()};
     m_chainman.time_index += time_6 - time_5;
+    m_chainman.RecordValidationTime(ValidationPhase::WRITE_INDEX, time_6 - time_5);
     LogPrint(BCLog::BENCH, "    - Index writing: %.2fms [%.2fs (%.2fms/blk)]\n",
              Ticks<MillisecondsDouble>(time_6 - time_5),
              Ticks<SecondsDouble>(m_chainman.time_index),
@@ -2745,6 +2803,27 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
     return true;
 }
 
+std::string_view ValidationPhaseName(ValidationPhase phase)
+{
+    switch (phase) {
+    case ValidationPhase::CHECK_BLOCK: return "check_block";
+    case ValidationPhase::FORKS: return "forks";
+    case ValidationPhase::CONNECT_TRANSACTIONS: return "connect_transactions";
+    case ValidationPhase::VERIFY_INPUTS: return "verify_inputs";
+    case ValidationPhase::WRITE_UNDO: return "write_undo";
+    case ValidationPhase::WRITE_INDEX: return "write_index";
+    case ValidationPhase::LOAD_BLOCK: return "load_block";
+    case ValidationPhase::CONNECT_BLOCK: return "connect_block";
+    case ValidationPhase::FLUSH_VIEW: return "flush_view";
+    case ValidationPhase::WRITE_CHAINSTATE: return "write_chainstate";
+    case ValidationPhase::CONNECT_POSTPROCESS: return "connect_postprocess";
+    case ValidationPhase::CONNECT_TIP: return "connect_tip";
+    case ValidationPhase::FLUSH_STATE: return "flush_state";
+    case ValidationPhase::ACTIVATE_BEST_CHAIN_STEP: return "activate_best_chain_step";
+    } // no default case, so the compiler can warn about missing cases
+    assert(false);
+}
+
 CoinsCacheSizeState Chainstate::GetCoinsCacheSizeState()
 {
     AssertLockHeld(::cs_main);
@@ -2784,8 +2863,10 @@ bool Chainstate::FlushStateToDisk(
 {
     LOCK(cs_main);
     assert(this->CanFlushToDisk());
+    const auto time_start{SteadyClock::now()};
     std::set<int> setFilesToPrune;
     bool full_flush_completed = false;
+    bool wrote_to_disk = false;
 
     const size_t coins_count = CoinsTip().GetCacheSize();
     const size_t coins_mem_usage = CoinsTip().DynamicMemoryUsage();
@@ -2858,6 +2939,7 @@ bool Chainstate::FlushStateToDisk(
         fDoFullFlush = (mode == FlushStateMode::ALWAYS) || fCacheLarge || fCacheCritical || fPeriodicFlush || fFlushForPrune;
         // Write blocks and block index to disk.
         if (fDoFullFlush || fPeriodicWrite) {
+            wrote_to_disk = true;
             // Ensure we can write block index
             if (!CheckDiskSpace(m_blockman.m_opts.blocks_dir)) {
                 return FatalError(m_chainman.GetNotifications(), state, _("Disk space is too low!"));
@@ -2915,6 +2997,8 @@ bool Chainstate::FlushStateToDisk(
                    (uint64_t)coins_count,
                    (uint64_t)coins_mem_usage,
                    (bool)fFlushForPrune);
+            flightrecorder::Record(flightrecorder::Event::COINS_FLUSH, static_cast<uint32_t>(mode), coins_count,
+                                   Ticks<std::chrono::nanoseconds>(SteadyClock::now() - nNow));
         }
     }
     if (full_flush_completed && m_chainman.m_options.signals) {
@@ -2924,6 +3008,12 @@ bool Chainstate::FlushStateToDisk(
     } catch (const std::runtime_error& e) {
         return FatalError(m_chainman.GetNotifications(), state, strprintf(_("System error while flushing: %s"), e.what()));
     }
+    if (wrote_to_disk) m_chainman.RecordValidationTime(ValidationPhase::FLUSH_STATE, SteadyClock::now() - time_start);
+    if (this == &m_chainman.ActiveChainstate()) {
+        m_chainman.m_published_tip_height.store(m_chain.Height(), std::memory_order_relaxed);
+        m_chainman.m_published_coins_tip_usage.store(CoinsTip().DynamicMemoryUsage(), std::memory_order_relaxed);
+        m_chainman.m_published_coins_tip_count.store(CoinsTip().GetCacheSize(), std::memory_order_relaxed);
+    }
     return true;
 }
 
@@ -3141,6 +3231,10 @@ bool Chainstate::ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew,
     if (m_mempool) AssertLockHeld(m_mempool->cs);
 
     assert(pindexNew->pprev == m_chain.Tip());
+    const auto record_phase{[&](flightrecorder::ConnectPhase phase, SteadyClock::duration duration) {
+        flightrecorder::Record(flightrecorder::Event::CONNECT_PHASE, static_cast<uint32_t>(phase), pindexNew->nHeight,
+                               Ticks<std::chrono::nanoseconds>(duration));
+    }};
     // Read block from disk.
     const auto time_1{SteadyClock::now()};
     std::shared_ptr<const CBlock> pthisBlock;
@@ -3162,6 +3256,8 @@ bool Chainstate::ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew,
     // num_blocks_total may be zero until the ConnectBlock() call below.
     LogPrint(BCLog::BENCH, "  - Load block from disk: %.2fms\n",
              Ticks<MillisecondsDouble>(time_2 - time_1));
+    record_phase(flightrecorder::ConnectPhase::LOAD_BLOCK, time_2 - time_1);
+    if (!pblock) m_chainman.RecordValidationTime(ValidationPhase::LOAD_BLOCK, time_2 - time_1);
     {
         CCoinsViewCache view(&CoinsTip());
         bool rv = ConnectBlock(blockConnecting, state, pindexNew, view);
@@ -3176,6 +3272,8 @@ bool Chainstate::ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew,
         }
         time_3 = SteadyClock::now();
         m_chainman.time_connect_total += time_3 - time_2;
+        m_chainman.RecordValidationTime(ValidationPhase::CONNECT_BLOCK, time_3 - time_2);
+        record_phase(flightrecorder::ConnectPhase::CONNECT_BLOCK, time_3 - time_2);
         assert(m_chainman.num_blocks_total > 0);
         LogPrint(BCLog::BENCH, "  - Connect total: %.2fms [%.2fs (%.2fms/blk)]\n",
                  Ticks<MillisecondsDouble>(time_3 - time_2),
@@ -3186,6 +3284,8 @@ bool Chainstate::ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew,
     }
     const auto time_4{SteadyClock::now()};
     m_chainman.time_flush += time_4 - time_3;
+    m_chainman.RecordValidationTime(ValidationPhase::FLUSH_VIEW, time_4 - time_3);
+    record_phase(flightrecorder::ConnectPhase::FLUSH_VIEW, time_4 - time_3);
     LogPrint(BCLog::BENCH, "  - Flush: %.2fms [%.2fs (%.2fms/blk)]\n",
              Ticks<MillisecondsDouble>(time_4 - time_3),
              Ticks<SecondsDouble>(m_chainman.time_flush),
@@ -3196,6 +3296,8 @@ bool Chainstate::ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew,
     }
     const auto time_5{SteadyClock::now()};
     m_chainman.time_chainstate += time_5 - time_4;
+    m_chainman.RecordValidationTime(ValidationPhase::WRITE_CHAINSTATE, time_5 - time_4);
+    record_phase(flightrecorder::ConnectPhase::WRITE_CHAINSTATE, time_5 - time_4);
     LogPrint(BCLog::BENCH, "  - Writing chainstate: %.2fms [%.2fs (%.2fms/blk)]\n",
              Ticks<MillisecondsDouble>(time_5 - time_4),
              Ticks<SecondsDouble>(m_chainman.time_chainstate),
@@ -3211,7 +3313,10 @@ bool Chainstate::ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew,
 
     const auto time_6{SteadyClock::now()};
     m_chainman.time_post_connect += time_6 - time_5;
+    m_chainman.RecordValidationTime(ValidationPhase::CONNECT_POSTPROCESS, time_6 - time_5);
+    record_phase(flightrecorder::ConnectPhase::POSTPROCESS, time_6 - time_5);
     m_chainman.time_total += time_6 - time_1;
+    m_chainman.RecordValidationTime(ValidationPhase::CONNECT_TIP, time_6 - time_1);
     LogPrint(BCLog::BENCH, "  - Connect postprocess: %.2fms [%.2fs (%.2fms/blk)]\n",
              Ticks<MillisecondsDouble>(time_6 - time_5),
              Ticks<SecondsDouble>(m_chainman.time_post_connect),
@@ -3496,7 +3601,10 @@ bool Chainstate::ActivateBestChain(BlockValidationState& state, std::shared_ptr<
 
                 bool fInvalidFound = false;
                 std::shared_ptr<const CBlock> nullBlockPtr;
-                if (!ActivateBestChainStep(state, pindexMostWork, pblock && pblock->GetHash() == pindexMostWork->GetBlockHash() ? pblock : nullBlockPtr, fInvalidFound, connectTrace)) {
+                const auto step_start{SteadyClock::now()};
+                const bool step_ok{ActivateBestChainStep(state, pindexMostWork, pblock && pblock->GetHash() == pindexMostWork->GetBlockHash() ? pblock : nullBlockPtr, fInvalidFound, connectTrace)};
+                m_chainman.RecordValidationTime(ValidationPhase::ACTIVATE_BEST_CHAIN_STEP, SteadyClock::now() - step_start);
+                if (!step_ok) {
                     // A system error occurred
                     return false;
                 }
@@ -30,10 +30,13 @@
 #include <util/check.h>
 #include <util/fs.h>
 #include <util/hasher.h>
+#include <util/latencyhistogram.h>
 #include <util/result.h>
+#include <util/time.h>
 #include <util/translation.h>
 #include <versionbits.h>
 
+#include <array>
 #include <atomic>
 #include <map>
 #include <memory>
@@ -41,6 +44,7 @@
 #include <set>
 #include <stdint.h>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <type_traits>
 #include <utility>
@@ -840,6 +844,31 @@ enum class SnapshotCompletionResult {
     BASE_BLOCKHASH_MISMATCH,
 };
 
+/** Timed parts of block validation, see ChainstateManager::GetValidationTiming(). */
+enum class ValidationPhase : size_t {
+    // ConnectBlock()
+    CHECK_BLOCK,          //!< CheckBlock() and the checks preceding the UTXO updates
+    FORKS,                //!< Deployment activation and BIP30 checks
+    CONNECT_TRANSACTIONS, //!< Updating the UTXO view and queueing script checks
+    VERIFY_INPUTS,        //!< CONNECT_TRANSACTIONS plus waiting for the script checks
+    WRITE_UNDO,           //!< Writing undo data
+    WRITE_INDEX,          //!< Updating the block index
+    // ConnectTip()
+    LOAD_BLOCK,           //!< Reading the block from disk, if it was not supplied
+    CONNECT_BLOCK,        //!< ConnectBlock() as a whole
+    FLUSH_VIEW,           //!< Flushing the block's view into the coins cache
+    WRITE_CHAINSTATE,     //!< FlushStateToDisk() after the block
+    CONNECT_POSTPROCESS,  //!< Mempool and tip updates after the block
+    CONNECT_TIP,          //!< ConnectTip() as a whole
+    // Others
+    FLUSH_STATE,          //!< FlushStateToDisk() calls that wrote to disk
+    ACTIVATE_BEST_CHAIN_STEP, //!< ActivateBestChainStep()
+};
+static constexpr size_t VALIDATION_PHASE_COUNT{static_cast<size_t>(ValidationPhase::ACTIVATE_BEST_CHAIN_STEP) + 1};
+
+/** Name of a ValidationPhase as reported by the getvalidationtimings RPC. */
+std::string_view ValidationPhaseName(ValidationPhase phase);
+
 /**
  * Provides an interface for creating and interacting with one or two
  * chainstates: an IBD chainstate generated by downloading blocks, and
@@ -969,6 +998,20 @@ private:
     SteadyClock::duration GUARDED_BY(::cs_main) time_chainstate{};
     SteadyClock::duration GUARDED_BY(::cs_main) time_post_connect{};
 
+    //! Latency distributions, in microseconds, of the same and a few more
+    //! parts of validation. Lock-free, so they can be read without cs_main.
+    //! The first set is never reset, as /metrics exports it as counters that
+    //! must not go backwards; getvalidationtimings reports and resets the second.
+    std::array<LatencyHistogram, VALIDATION_PHASE_COUNT> m_validation_timings;
+    std::array<LatencyHistogram, VALIDATION_PHASE_COUNT> m_validation_timings_since_reset;
+
+    void RecordValidationTime(ValidationPhase phase, SteadyClock::duration duration)
+    {
+        const auto micros{Ticks<std::chrono::microseconds>(duration)};
+        m_validation_timings[static_cast<size_t>(phase)].Record(micros);
+        m_validation_timings_since_reset[static_cast<size_t>(phase)].Record(micros);
+    }
+
 public:
     using Options = kernel::ChainstateManagerOpts;
 
@@ -1263,6 +1306,21 @@ public:
     //! ResizeCoinsCaches() as needed.
     void MaybeRebalanceCaches() EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 
+    //! State of the active chainstate as of its last FlushStateToDisk() call
+    //! (which follows every block connection), readable without cs_main.
+    std::atomic<int> m_published_tip_height{-1};
+    std::atomic<size_t> m_published_coins_tip_usage{0};
+    std::atomic<size_t> m_published_coins_tip_count{0};
+
+    //! Distribution of the time spent in a part of block validation since startup, in microseconds.
+    const LatencyHistogram& GetValidationTiming(ValidationPhase phase) const { return m_validation_timings[static_cast<size_t>(phase)]; }
+    //! The same, since the last ResetValidationTimings() call.
+    const LatencyHistogram& GetValidationTimingSinceReset(ValidationPhase phase) const { return m_validation_timings_since_reset[static_cast<size_t>(phase)]; }
+    void ResetValidationTimings()
+    {
+        for (auto& histogram : m_validation_timings_since_reset) histogram.Reset();
+    }
+
     /** Update uncommitted block structures (currently: only the witness reserved value). This is safe for submitted blocks. */
     void UpdateUncommittedBlockStructures(CBlock& block, const CBlockIndex* pindexPrev) const;
 
@@ -23,6 +23,8 @@ namespace wallet {
 static constexpr CAmount CHANGE_LOWER{50000};
 //! upper bound for randomly-chosen target change amount
 static constexpr CAmount CHANGE_UPPER{1000000};
+//! minimum number of output groups for which the knapsack solver runs concurrently with the other algorithms
+static constexpr size_t PARALLEL_SELECTION_MIN_GROUPS{1000};
 
 /** A UTXO under consideration for use in funding a new transaction. */
 struct COutput {
@@ -297,9 +297,15 @@ Balance GetBalance(const CWallet& wallet, const int min_depth, bool avoid_reuse)
     {
         LOCK(wallet.cs_wallet);
         std::set<uint256> trusted_parents;
-        for (const auto& entry : wallet.mapWallet)
+        // Transactions without any unspent output of ours cannot add to the
+        // balance, so only visit the ones referenced by the unspent output index.
+        // Outpoints are ordered by txid, so each transaction is seen in one run.
+        const CWalletTx* prev_wtx{nullptr};
+        for (const COutPoint& outpoint : wallet.GetUnspentTxos())
         {
-            const CWalletTx& wtx = entry.second;
+            const CWalletTx& wtx = wallet.mapWallet.at(outpoint.hash.ToUint256());
+            if (&wtx == prev_wtx) continue;
+            prev_wtx = &wtx;
             const bool is_trusted{CachedTxIsTrusted(wallet, wtx, trusted_parents)};
             const int tx_depth{wallet.GetTxDepthInMainChain(wtx)};
             const CAmount tx_credit_mine{CachedTxGetAvailableCredit(wallet, wtx, ISMINE_SPENDABLE | reuse_filter)};
@@ -185,8 +185,6 @@ RPCHelpMan importprivkey()
         CHECK_NONFATAL(key.VerifyPubKey(pubkey));
         CKeyID vchAddress = pubkey.GetID();
         {
-            pwallet->MarkDirty();
-
             // We don't know which corresponding address will be used;
             // label all new addresses, and label existing addresses if a
             // label was passed.
@@ -205,6 +203,9 @@ RPCHelpMan importprivkey()
             if (pubkey.IsCompressed()) {
                 pwallet->ImportScripts({GetScriptForDestination(WitnessV0KeyHash(vchAddress))}, /*timestamp=*/0);
             }
+
+            // Outputs of transactions already in the wallet may have become ours
+            pwallet->MarkDirty();
         }
     }
     if (fRescan) {
@@ -288,8 +289,6 @@ RPCHelpMan importaddress()
                 throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Bech32m addresses cannot be imported into legacy wallets");
             }
 
-            pwallet->MarkDirty();
-
             pwallet->ImportScriptPubKeys(strLabel, {GetScriptForDestination(dest)}, /*have_solving_data=*/false, /*apply_label=*/true, /*timestamp=*/1);
         } else if (IsHex(request.params[0].get_str())) {
             std::vector<unsigned char> data(ParseHex(request.params[0].get_str()));
@@ -306,6 +305,9 @@ RPCHelpMan importaddress()
         } else {
             throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid Bitcoin address or script");
         }
+
+        // Outputs of transactions already in the wallet may have become ours
+        pwallet->MarkDirty();
     }
     if (fRescan)
     {
@@ -467,11 +469,12 @@ RPCHelpMan importpubkey()
             script_pub_keys.insert(GetScriptForDestination(dest));
         }
 
-        pwallet->MarkDirty();
-
         pwallet->ImportScriptPubKeys(strLabel, script_pub_keys, /*have_solving_data=*/true, /*apply_label=*/true, /*timestamp=*/1);
 
         pwallet->ImportPubKeys({pubKey.GetID()}, {{pubKey.GetID(), pubKey}} , /*key_origins=*/{}, /*add_keypool=*/false, /*internal=*/false, /*timestamp=*/1);
+
+        // Outputs of transactions already in the wallet may have become ours
+        pwallet->MarkDirty();
     }
     if (fRescan)
     {
@@ -1193,7 +1196,6 @@ static UniValue ProcessImport(CWallet& wallet, const UniValue& data, const int64
         }
 
         // All good, time to import
-        wallet.MarkDirty();
         if (!wallet.ImportScripts(import_data.import_scripts, timestamp)) {
             throw JSONRPCError(RPC_WALLET_ERROR, "Error adding script to wallet");
         }
@@ -1206,6 +1208,8 @@ static UniValue ProcessImport(CWallet& wallet, const UniValue& data, const int64
         if (!wallet.ImportScriptPubKeys(label, script_pub_keys, have_solving_data, !internal, timestamp)) {
             throw JSONRPCError(RPC_WALLET_ERROR, "Error adding address to wallet");
         }
+        // Outputs of transactions already in the wallet may have become ours
+        wallet.MarkDirty();
 
         result.pushKV("success", UniValue(true));
     } catch (const UniValue& e) {
@@ -19,7 +19,10 @@
 #include <util/translation.h>
 #include <wallet/scriptpubkeyman.h>
 
+#include <algorithm>
+#include <future>
 #include <optional>
+#include <thread>
 
 using common::PSBTError;
 using util::ToString;
@@ -2232,20 +2235,29 @@ bool DescriptorScriptPubKeyMan::TopUpWithDB(WalletBatch& batch, unsigned int siz
     provider.keys = GetKeys();
 
     uint256 id = GetID();
-    for (int32_t i = m_max_cached_index + 1; i < new_range_end; ++i) {
+    // Expanding an index is dominated by BIP32 derivation and does not depend on
+    // the other new indexes, so this is done up front (and for large top ups, on
+    // several threads) before the results are added to the maps in index order.
+    struct Expansion {
+        bool ok{false};
+        std::vector<CScript> scripts;
         FlatSigningProvider out_keys;
-        std::vector<CScript> scripts_temp;
-        DescriptorCache temp_cache;
+        DescriptorCache cache;
+    };
+    const Descriptor& descriptor{*m_wallet_descriptor.descriptor};
+    const auto expand = [&](int32_t i, const DescriptorCache& read_cache, Expansion& exp) {
         // Maybe we have a cached xpub and we can expand from the cache first
-        if (!m_wallet_descriptor.descriptor->ExpandFromCache(i, m_wallet_descriptor.cache, scripts_temp, out_keys)) {
-            if (!m_wallet_descriptor.descriptor->Expand(i, provider, scripts_temp, out_keys, &temp_cache)) return false;
-        }
+        exp.ok = descriptor.ExpandFromCache(i, read_cache, exp.scripts, exp.out_keys) ||
+                 descriptor.Expand(i, provider, exp.scripts, exp.out_keys, &exp.cache);
+    };
+    const auto add_expansion = [&](int32_t i, Expansion& exp) EXCLUSIVE_LOCKS_REQUIRED(cs_desc_man) {
+        if (!exp.ok) return false;
         // Add all of the scriptPubKeys to the scriptPubKey set
-        new_spks.insert(scripts_temp.begin(), scripts_temp.end());
-        for (const CScript& script : scripts_temp) {
+        new_spks.insert(exp.scripts.begin(), exp.scripts.end());
+        for (const CScript& script : exp.scripts) {
             m_map_script_pub_keys[script] = i;
         }
-        for (const auto& pk_pair : out_keys.pubkeys) {
+        for (const auto& pk_pair : exp.out_keys.pubkeys) {
             const CPubKey& pubkey = pk_pair.second;
             if (m_map_pubkeys.count(pubkey) != 0) {
                 // We don't need to give an error here.
@@ -2255,11 +2267,44 @@ bool DescriptorScriptPubKeyMan::TopUpWithDB(WalletBatch& batch, unsigned int siz
             m_map_pubkeys[pubkey] = i;
         }
         // Merge and write the cache
-        DescriptorCache new_items = m_wallet_descriptor.cache.MergeAndDiff(temp_cache);
+        DescriptorCache new_items = m_wallet_descriptor.cache.MergeAndDiff(exp.cache);
         if (!batch.WriteDescriptorCacheItems(id, new_items)) {
             throw std::runtime_error(std::string(__func__) + ": writing cache items failed");
         }
         m_max_cached_index++;
+        return true;
+    };
+
+    // The first new index may populate the cache with the parent xpubs the other indexes can be derived from
+    if (m_max_cached_index + 1 < new_range_end) {
+        Expansion first;
+        expand(m_max_cached_index + 1, m_wallet_descriptor.cache, first);
+        if (!add_expansion(m_max_cached_index + 1, first)) return false;
+    }
+
+    const int32_t begin_index{m_max_cached_index + 1};
+    std::vector<Expansion> expansions(std::max(0, new_range_end - begin_index));
+    const size_t num_threads{std::clamp<size_t>(expansions.size() / TOPUP_MIN_INDEXES_PER_THREAD, 1, std::max(1U, std::thread::hardware_concurrency()))};
+    const DescriptorCache& cache{m_wallet_descriptor.cache};
+    const auto expand_range = [&](size_t begin, size_t end) {
+        for (size_t n = begin; n < end; ++n) {
+            expand(begin_index + static_cast<int32_t>(n), cache, expansions[n]);
+        }
+    };
+    if (num_threads > 1) {
+        // The cache is only read until all workers are done
+        std::vector<std::future<void>> workers;
+        const size_t per_thread{(expansions.size() + num_threads - 1) / num_threads};
+        for (size_t begin = per_thread; begin < expansions.size(); begin += per_thread) {
+            workers.emplace_back(std::async(std::launch::async, expand_range, begin, std::min(begin + per_thread, expansions.size())));
+        }
+        expand_range(0, per_thread);
+        for (auto& worker : workers) worker.get();
+    } else {
+        expand_range(0, expansions.size());
+    }
+    for (size_t n = 0; n < expansions.size(); ++n) {
+        if (!add_expansion(begin_index + static_cast<int32_t>(n), expansions[n])) return false;
     }
     m_wallet_descriptor.range_end = new_range_end;
     batch.WriteDescriptor(GetID(), m_wallet_descriptor);
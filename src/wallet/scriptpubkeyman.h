@@ -63,6 +63,9 @@ static constexpr int64_t UNKNOWN_TIME = std::numeric_limits<int64_t>::max();
 //! Default for -keypool
 static const unsigned int DEFAULT_KEYPOOL_SIZE = 1000;
 
+//! Minimum number of new descriptor indexes per thread when expanding descriptors during a top up
+static constexpr size_t TOPUP_MIN_INDEXES_PER_THREAD{250};
+
 std::vector<CKeyID> GetAffectedKeys(const CScript& spk, const SigningProvider& provider);
 
 /** A key from a CWallet's keypool
@@ -29,6 +29,7 @@
 #include <wallet/wallet.h>
 
 #include <cmath>
+#include <future>
 
 using common::StringForFeeReason;
 using common::TransactionErrorString;
@@ -324,10 +325,17 @@ CoinsResult AvailableCoins(const CWallet& wallet,
     std::vector<COutPoint> outpoints;
 
     std::set<uint256> trusted_parents;
-    for (const auto& entry : wallet.mapWallet)
+    // Only transactions with outputs in the wallet's unspent output index can
+    // provide coins. The index is ordered by txid, so the per-transaction checks
+    // below run once for each run of outpoints belonging to the same transaction.
+    const auto& unspent_txos{wallet.GetUnspentTxos()};
+    for (auto txo_it = unspent_txos.begin(); txo_it != unspent_txos.end();)
     {
-        const uint256& txid = entry.first;
-        const CWalletTx& wtx = entry.second;
+        const Txid txid{txo_it->hash};
+        const CWalletTx& wtx = wallet.mapWallet.at(txid.ToUint256());
+        const auto tx_txos_begin{txo_it};
+        while (txo_it != unspent_txos.end() && txo_it->hash == txid) ++txo_it;
+        const auto tx_txos_end{txo_it};
 
         if (wallet.IsTxImmatureCoinBase(wtx) && !params.include_immature_coinbase)
             continue;
@@ -384,9 +392,9 @@ CoinsResult AvailableCoins(const CWallet& wallet,
 
         bool tx_from_me = CachedTxIsFromMe(wallet, wtx, ISMINE_ALL);
 
-        for (unsigned int i = 0; i < wtx.tx->vout.size(); i++) {
-            const CTxOut& output = wtx.tx->vout[i];
-            const COutPoint outpoint(Txid::FromUint256(txid), i);
+        for (auto tx_txo_it = tx_txos_begin; tx_txo_it != tx_txos_end; ++tx_txo_it) {
+            const COutPoint& outpoint{*tx_txo_it};
+            const CTxOut& output = wtx.tx->vout[outpoint.n];
 
             if (output.nValue < params.min_amount || output.nValue > params.max_amount)
                 continue;
@@ -533,13 +541,26 @@ FilteredOutputGroups GroupOutputs(const CWallet& wallet,
 {
     FilteredOutputGroups filtered_groups;
 
+    // Only unconfirmed outputs can have in-mempool ancestry. Look it up once per
+    // transaction instead of once per output, as every lookup takes the mempool lock.
+    std::unordered_map<Txid, std::pair<size_t, size_t>, SaltedTxidHasher> ancestry_cache;
+    const auto get_ancestry = [&](const COutput& output, size_t& ancestors, size_t& descendants) {
+        ancestors = descendants = 0;
+        if (output.depth > 0) return;
+        auto [it, inserted] = ancestry_cache.try_emplace(output.outpoint.hash);
+        if (inserted) {
+            wallet.chain().getTransactionAncestry(output.outpoint.hash, it->second.first, it->second.second);
+        }
+        std::tie(ancestors, descendants) = it->second;
+    };
+
     if (!coin_sel_params.m_avoid_partial_spends) {
         // Allowing partial spends means no grouping. Each COutput gets its own OutputGroup
         for (const auto& [type, outputs] : coins.coins) {
             for (const COutput& output : outputs) {
                 // Get mempool info
                 size_t ancestors, descendants;
-                wallet.chain().getTransactionAncestry(output.outpoint.hash, ancestors, descendants);
+                get_ancestry(output, ancestors, descendants);
 
                 // Create a new group per output and add it to the all groups vector
                 OutputGroup group(coin_sel_params);
@@ -596,7 +617,7 @@ FilteredOutputGroups GroupOutputs(const CWallet& wallet,
     for (const auto& [type, outs] : coins.coins) {
         for (const COutput& output : outs) {
             size_t ancestors, descendants;
-            wallet.chain().getTransactionAncestry(output.outpoint.hash, ancestors, descendants);
+            get_ancestry(output, ancestors, descendants);
 
             const auto& shared_output = std::make_shared<COutput>(output);
             // Filter for positive only before adding the output
@@ -703,6 +724,19 @@ util::Result<SelectionResult> ChooseSelectionResult(interfaces::Chain& chain, co
         return util::Error{_("Maximum transaction weight is less than transaction weight without inputs")};
     }
 
+    // The knapsack solver has some legacy behavior where it will spend dust outputs. We retain this behavior, so don't filter for positive only here.
+    // It only reads the mixed group and shares the rng with SRD alone, so for large pools run it concurrently with
+    // BnB and CoinGrinder. Results are still collected in the same order as a sequential run. Note that the future
+    // returned by std::async joins the worker on destruction, so early returns below remain safe.
+    const int knapsack_max_weight{max_selection_weight - coin_selection_params.change_output_size * WITNESS_SCALE_FACTOR};
+    const auto run_knapsack = [&] {
+        return KnapsackSolver(groups.mixed_group, nTargetValue, coin_selection_params.m_min_change_target, coin_selection_params.rng_fast, knapsack_max_weight);
+    };
+    std::future<util::Result<SelectionResult>> knapsack_future;
+    if (groups.mixed_group.size() >= PARALLEL_SELECTION_MIN_GROUPS) {
+        knapsack_future = std::async(std::launch::async, run_knapsack);
+    }
+
     // SFFO frequently causes issues in the context of changeless input sets: skip BnB when SFFO is active
     if (!coin_selection_params.m_subtract_fee_outputs) {
         if (auto bnb_result{SelectCoinsBnB(groups.positive_group, nTargetValue, coin_selection_params.m_cost_of_change, max_selection_weight)}) {
@@ -717,17 +751,21 @@ util::Result<SelectionResult> ChooseSelectionResult(interfaces::Chain& chain, co
         return util::Error{_("Maximum transaction weight is too low, can not accommodate change output")};
     }
 
-    // The knapsack solver has some legacy behavior where it will spend dust outputs. We retain this behavior, so don't filter for positive only here.
-    if (auto knapsack_result{KnapsackSolver(groups.mixed_group, nTargetValue, coin_selection_params.m_min_change_target, coin_selection_params.rng_fast, max_selection_weight)}) {
+    std::optional<util::Result<SelectionResult>> cg_result;
+    if (coin_selection_params.m_effective_feerate > CFeeRate{3 * coin_selection_params.m_long_term_feerate}) { // Minimize input set for feerates of at least 3×LTFRE (default: 30 ṩ/vB+)
+        cg_result.emplace(CoinGrinder(groups.positive_group, nTargetValue, coin_selection_params.m_min_change_target, max_selection_weight));
+    }
+
+    if (auto knapsack_result{knapsack_future.valid() ? knapsack_future.get() : run_knapsack()}) {
         results.push_back(*knapsack_result);
     } else append_error(std::move(knapsack_result));
 
-    if (coin_selection_params.m_effective_feerate > CFeeRate{3 * coin_selection_params.m_long_term_feerate}) { // Minimize input set for feerates of at least 3×LTFRE (default: 30 ṩ/vB+)
-        if (auto cg_result{CoinGrinder(groups.positive_group, nTargetValue, coin_selection_params.m_min_change_target, max_selection_weight)}) {
-            cg_result->RecalculateWaste(coin_selection_params.min_viable_change, coin_selection_params.m_cost_of_change, coin_selection_params.m_change_fee);
-            results.push_back(*cg_result);
+    if (cg_result) {
+        if (*cg_result) {
+            (*cg_result)->RecalculateWaste(coin_selection_params.min_viable_change, coin_selection_params.m_cost_of_change, coin_selection_params.m_change_fee);
+            results.push_back(**cg_result);
         } else {
-            append_error(std::move(cg_result));
+            append_error(std::move(*cg_result));
         }
     }
 
@@ -1510,6 +1510,42 @@ BOOST_AUTO_TEST_CASE(check_max_selection_weight)
     }
 }
 
+BOOST_AUTO_TEST_CASE(parallel_selection_deterministic)
+{
+    // With enough groups the knapsack solver runs concurrently with BnB and CoinGrinder.
+    // The outcome must only depend on the rng seed, exactly like a sequential run.
+    const auto run_selection = [&] {
+        FastRandomContext rand{/*fDeterministic=*/true};
+        CoinSelectionParams cs_params{
+            rand,
+            /*change_output_size=*/31,
+            /*change_spend_size=*/68,
+            /*min_change_target=*/CENT,
+            /*effective_feerate=*/CFeeRate(50'000),
+            /*long_term_feerate=*/CFeeRate(10'000),
+            /*discard_feerate=*/CFeeRate(3000),
+            /*tx_noinputs_size=*/10 + 31,
+            /*avoid_partial=*/false,
+        };
+        return select_coins(
+            7 * COIN, cs_params, CCoinControl{}, [&](CWallet& wallet) {
+                CoinsResult available_coins;
+                for (size_t j = 0; j < PARALLEL_SELECTION_MIN_GROUPS + 500; ++j) {
+                    add_coin(available_coins, wallet, CAmount(1 + (j * 37) % 997) * 100'000, CFeeRate(50'000), 144, false, 0, true);
+                }
+                return available_coins;
+            },
+            m_node);
+    };
+
+    const auto first{run_selection()};
+    const auto second{run_selection()};
+    BOOST_REQUIRE(first);
+    BOOST_REQUIRE(second);
+    BOOST_CHECK(first->GetAlgo() == second->GetAlgo());
+    BOOST_CHECK(EquivalentResult(*first, *second));
+}
+
 BOOST_AUTO_TEST_CASE(SelectCoins_effective_value_test)
 {
     // Test that the effective value is used to check whether preset inputs provide sufficient funds when subtract_fee_outputs is not used.
@@ -3,6 +3,8 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <key.h>
+#include <key_io.h>
+#include <script/descriptor.h>
 #include <test/util/setup_common.h>
 #include <script/solver.h>
 #include <wallet/scriptpubkeyman.h>
@@ -40,5 +42,41 @@ BOOST_AUTO_TEST_CASE(CanProvide)
     BOOST_CHECK(keyman.CanProvide(p2sh_script, data));
 }
 
+// Test that a large DescriptorScriptPubKeyMan top up, whose expansion may be spread
+// over several threads, maps every derived script to the index it was derived at.
+BOOST_AUTO_TEST_CASE(DescriptorLargeTopUp)
+{
+    CWallet wallet(m_node.chain.get(), "", CreateMockableWalletDatabase());
+    wallet.SetWalletFlag(WALLET_FLAG_DESCRIPTORS);
+
+    CExtKey xkey;
+    xkey.SetSeed(std::vector<std::byte>(32, std::byte{1}));
+    const std::string desc_str{"wpkh(" + EncodeExtPubKey(xkey.Neuter()) + "/0/*)"};
+    FlatSigningProvider keys;
+    std::string error;
+    std::unique_ptr<Descriptor> desc = Parse(desc_str, keys, error, /*require_checksum=*/false);
+    BOOST_REQUIRE(desc);
+    const std::unique_ptr<Descriptor> expected_desc = Parse(desc_str, keys, error, /*require_checksum=*/false);
+
+    LOCK(wallet.cs_wallet);
+    WalletDescriptor w_desc(std::move(desc), /*creation_time=*/1, /*range_start=*/0, /*range_end=*/1, /*next_index=*/0);
+    auto* spkm = dynamic_cast<DescriptorScriptPubKeyMan*>(wallet.AddWalletDescriptor(w_desc, keys, /*label=*/"", /*internal=*/false));
+    BOOST_REQUIRE(spkm);
+
+    const int32_t size{static_cast<int32_t>(TOPUP_MIN_INDEXES_PER_THREAD * 8)};
+    BOOST_CHECK(spkm->TopUp(size));
+    BOOST_CHECK_EQUAL(spkm->GetEndRange(), size);
+    BOOST_CHECK_EQUAL(spkm->GetScriptPubKeys().size(), size_t(size));
+
+    for (int32_t i : {0, 1, size / 3, size / 2, size - 1}) {
+        std::vector<CScript> scripts;
+        FlatSigningProvider out_keys;
+        BOOST_REQUIRE(expected_desc->Expand(i, keys, scripts, out_keys));
+        BOOST_REQUIRE_EQUAL(scripts.size(), 1U);
+        BOOST_CHECK(spkm->GetScriptPubKeys(i).count(scripts[0]));
+        BOOST_CHECK(!spkm->GetScriptPubKeys(i + 1).count(scripts[0]));
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 } // namespace wallet
@@ -716,6 +716,80 @@ BOOST_FIXTURE_TEST_CASE(BasicOutputTypesTest, ListCoinsTest)
     }
 }
 
+BOOST_FIXTURE_TEST_CASE(UnspentTxosTest, ListCoinsTestingSetup)
+{
+    const auto change_outpoint = [&](const CWalletTx& wtx) EXCLUSIVE_LOCKS_REQUIRED(wallet->cs_wallet) {
+        for (uint32_t i = 0; i < wtx.tx->vout.size(); ++i) {
+            if (wallet->IsMine(wtx.tx->vout[i])) return COutPoint{wtx.GetHash(), i};
+        }
+        BOOST_FAIL("transaction has no change output");
+        return COutPoint{};
+    };
+
+    // Spend the only mature coinbase output. Its outpoint stays indexed since
+    // spent coinbase outputs are kept, while the new change output is added.
+    const CWalletTx& first = AddTx(CRecipient{PubKeyDestination{{}}, 1 * COIN, /*subtract_fee=*/false});
+    COutPoint first_change;
+    {
+        LOCK(wallet->cs_wallet);
+        const COutPoint coinbase_outpoint{first.tx->vin.at(0).prevout};
+        first_change = change_outpoint(first);
+        BOOST_CHECK(wallet->IsSpent(coinbase_outpoint));
+        BOOST_CHECK(wallet->GetUnspentTxos().count(coinbase_outpoint));
+        BOOST_CHECK(wallet->GetUnspentTxos().count(first_change));
+        BOOST_CHECK_EQUAL(GetBalance(*wallet).m_mine_trusted, AvailableCoins(*wallet).GetTotalAmount());
+    }
+
+    // Spent outputs leave the index unless they are coinbase outputs, and the
+    // new change is added. Coin selection may pick the change or a coinbase
+    // output that matured in the meantime.
+    const CWalletTx& second = AddTx(CRecipient{PubKeyDestination{{}}, 1 * COIN, /*subtract_fee=*/false});
+    {
+        LOCK(wallet->cs_wallet);
+        for (const CTxIn& txin : second.tx->vin) {
+            BOOST_CHECK_EQUAL(wallet->GetUnspentTxos().count(txin.prevout), wallet->GetWalletTx(txin.prevout.hash)->IsCoinBase() ? 1U : 0U);
+        }
+        BOOST_CHECK_EQUAL(wallet->GetUnspentTxos().count(first_change), wallet->IsSpent(first_change) ? 0U : 1U);
+        BOOST_CHECK(wallet->GetUnspentTxos().count(change_outpoint(second)));
+        BOOST_CHECK_EQUAL(GetBalance(*wallet).m_mine_trusted, AvailableCoins(*wallet).GetTotalAmount());
+    }
+
+    // Rebuilding the index from scratch yields the same outputs
+    const std::set<COutPoint> txos{WITH_LOCK(wallet->cs_wallet, return wallet->GetUnspentTxos())};
+    wallet->MarkDirty();
+    BOOST_CHECK(txos == WITH_LOCK(wallet->cs_wallet, return wallet->GetUnspentTxos()));
+}
+
+BOOST_FIXTURE_TEST_CASE(UnspentTxosImportTest, ListCoinsTestingSetup)
+{
+    // Pay to a key the wallet does not have yet
+    const CKey key{GenerateRandomKey()};
+    const CScript script{GetScriptForDestination(WitnessV0KeyHash{key.GetPubKey()})};
+    const CWalletTx& wtx = AddTx(CRecipient{WitnessV0KeyHash{key.GetPubKey()}, 1 * COIN, /*subtract_fee=*/false});
+    COutPoint imported;
+    CAmount balance;
+    {
+        LOCK(wallet->cs_wallet);
+        for (uint32_t i = 0; i < wtx.tx->vout.size(); ++i) {
+            if (wtx.tx->vout[i].scriptPubKey == script) imported = COutPoint{wtx.GetHash(), i};
+        }
+        BOOST_REQUIRE(!imported.IsNull());
+        BOOST_CHECK(!wallet->GetUnspentTxos().count(imported));
+        balance = GetBalance(*wallet).m_mine_trusted;
+    }
+
+    // Importing a descriptor for the key makes the output of the existing
+    // transaction ours, without a rescan
+    AddKey(*wallet, key);
+    {
+        LOCK(wallet->cs_wallet);
+        BOOST_CHECK(wallet->GetUnspentTxos().count(imported));
+        BOOST_CHECK_EQUAL(GetBalance(*wallet).m_mine_trusted, balance + 1 * COIN);
+        const auto coins{AvailableCoins(*wallet).All()};
+        BOOST_CHECK(std::any_of(coins.begin(), coins.end(), [&](const COutput& coin) { return coin.outpoint == imported; }));
+    }
+}
+
 BOOST_FIXTURE_TEST_CASE(wallet_disableprivkeys, TestChain100Setup)
 {
     {
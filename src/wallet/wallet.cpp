@@ -775,6 +775,19 @@ bool CWallet::IsSpent(const COutPoint& outpoint) const
     return false;
 }
 
+void CWallet::UpdateUnspentTxos(const CWalletTx& wtx)
+{
+    AssertLockHeld(cs_wallet);
+    for (unsigned int i = 0; i < wtx.tx->vout.size(); ++i) {
+        const COutPoint outpoint(wtx.GetHash(), i);
+        if (IsMine(wtx.tx->vout[i]) != ISMINE_NO && (wtx.IsCoinBase() || !IsSpent(outpoint))) {
+            m_unspent_txos.insert(outpoint);
+        } else {
+            m_unspent_txos.erase(outpoint);
+        }
+    }
+}
+
 void CWallet::AddToSpends(const COutPoint& outpoint, const uint256& wtxid, WalletBatch* batch)
 {
     mapTxSpends.insert(std::make_pair(outpoint, wtxid));
@@ -979,6 +992,11 @@ void CWallet::MarkDirty()
         LOCK(cs_wallet);
         for (std::pair<const uint256, CWalletTx>& item : mapWallet)
             item.second.MarkDirty();
+        // Ownership of outputs may have changed, so rebuild the index from scratch
+        m_unspent_txos.clear();
+        for (const auto& [_, wtx] : mapWallet) {
+            UpdateUnspentTxos(wtx);
+        }
     }
 }
 
@@ -1157,6 +1175,12 @@ CWalletTx* CWallet::AddToWallet(CTransactionRef tx, const TxState& state, const
     // Break debit/credit balance caches:
     wtx.MarkDirty();
 
+    // Refresh the unspent output index for this transaction and the outputs it spends
+    UpdateUnspentTxos(wtx);
+    for (const CTxIn& txin : wtx.tx->vin) {
+        if (const CWalletTx* prev = GetWalletTx(txin.prevout.hash)) UpdateUnspentTxos(*prev);
+    }
+
     // Notify UI of new or updated transaction
     NotifyTransactionChanged(hash, fInsertedNew ? CT_NEW : CT_UPDATED);
 
@@ -1207,10 +1231,12 @@ bool CWallet::LoadToWallet(const uint256& hash, const UpdateWalletTxFn& fill_wtx
         wtx.m_it_wtxOrdered = wtxOrdered.insert(std::make_pair(wtx.nOrderPos, &wtx));
     }
     AddToSpends(wtx);
+    UpdateUnspentTxos(wtx);
     for (const CTxIn& txin : wtx.tx->vin) {
         auto it = mapWallet.find(txin.prevout.hash);
         if (it != mapWallet.end()) {
             CWalletTx& prevtx = it->second;
+            UpdateUnspentTxos(prevtx);
             if (auto* prev = prevtx.state<TxStateBlockConflicted>()) {
                 MarkConflicted(prev->conflicting_block_hash, prev->conflicting_block_height, wtx.GetHash());
             }
@@ -1302,6 +1328,7 @@ void CWallet::MarkInputsDirty(const CTransactionRef& tx)
         auto it = mapWallet.find(txin.prevout.hash);
         if (it != mapWallet.end()) {
             it->second.MarkDirty();
+            UpdateUnspentTxos(it->second);
         }
     }
 }
@@ -3950,6 +3977,9 @@ ScriptPubKeyMan* CWallet::AddWalletDescriptor(WalletDescriptor& desc, const Flat
     // Save the descriptor to DB
     spk_man->WriteDescriptor();
 
+    // Outputs of transactions already in the wallet may have become ours
+    MarkDirty();
+
     return spk_man;
 }
 
@@ -336,6 +336,18 @@ private:
     void AddToSpends(const COutPoint& outpoint, const uint256& wtxid, WalletBatch* batch = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
     void AddToSpends(const CWalletTx& wtx, WalletBatch* batch = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
 
+    /**
+     * Index of the wallet's own outputs that are not spent by another wallet
+     * transaction. Outputs of coinbase transactions are kept even when spent,
+     * since their immature credit still counts towards the balance. Updated
+     * whenever a transaction or one of its spenders changes state, so balance
+     * and coin availability queries only visit transactions that can still
+     * contribute to them instead of the whole wallet history.
+     */
+    std::set<COutPoint> m_unspent_txos GUARDED_BY(cs_wallet);
+    /** Recompute the m_unspent_txos entries of all outputs of a wallet transaction */
+    void UpdateUnspentTxos(const CWalletTx& wtx) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+
     /**
      * Add a transaction to the wallet, or update it.  confirm.block_* should
      * be set when the transaction was known to be included in a block.  When
@@ -532,6 +544,9 @@ public:
 
     bool IsSpent(const COutPoint& outpoint) const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
 
+    /** Outputs which may still contribute to the balance, ordered by txid (see m_unspent_txos). */
+    const std::set<COutPoint>& GetUnspentTxos() const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet) { AssertLockHeld(cs_wallet); return m_unspent_txos; }
+
     // Whether this or any known scriptPubKey with the same single key has been spent.
     bool IsSpentKey(const CScript& scriptPubKey) const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
     void SetSpentKeyState(WalletBatch& batch, const uint256& hash, unsigned int n, bool used, std::set<CTxDestination>& tx_destinations) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
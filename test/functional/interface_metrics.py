@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+# Copyright (c) 2024 The Krepto core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test the /metrics endpoint."""
+
+import base64
+import http.client
+import urllib.parse
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+from test_framework.wallet import MiniWallet
+
+
+class MetricsTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 2
+        self.extra_args = [["-metrics"], []]
+        self.supports_cli = False
+
+    def get_metrics(self, node, method="GET", status=200, auth=None):
+        url = urllib.parse.urlparse(node.url)
+        if auth is None:
+            auth = f"{url.username}:{url.password}"
+        headers = {"Authorization": "Basic " + base64.b64encode(auth.encode()).decode()} if auth else {}
+        conn = http.client.HTTPConnection(url.hostname, url.port)
+        conn.request(method, "/metrics", headers=headers)
+        resp = conn.getresponse()
+        assert_equal(resp.status, status)
+        if status != 200:
+            return None
+        assert resp.getheader("Content-Type").startswith("text/plain; version=0.0.4")
+        metrics = {}
+        for line in resp.read().decode().splitlines():
+            if line.startswith("#"):
+                continue
+            name, value = line.rsplit(" ", 1)
+            metrics[name] = float(value)
+        return metrics
+
+    def run_test(self):
+        node = self.nodes[0]
+        wallet = MiniWallet(node)
+
+        self.log.info("Check that the endpoint is disabled by default")
+        self.get_metrics(self.nodes[1], status=404)
+        self.log.info("Check that RPC credentials are required")
+        self.get_metrics(node, status=401, auth="")
+        self.get_metrics(node, status=401, auth="user:wrongpassword")
+        self.log.info("Check that only GET is accepted")
+        self.get_metrics(node, method="POST", status=405)
+
+        self.log.info("Check chain, mempool and validation metrics")
+        self.generate(wallet, 1)
+        wallet.send_self_transfer(from_node=node)
+        metrics = self.get_metrics(node)
+        assert_equal(metrics["krepto_chain_tip_height"], node.getblockcount())
+        mempool = node.getmempoolinfo()
+        assert_equal(metrics["krepto_mempool_transactions"], mempool["size"])
+        assert_equal(metrics["krepto_mempool_vsize_bytes"], mempool["bytes"])
+        assert_equal(metrics["krepto_mempool_usage_bytes"], mempool["usage"])
+        assert metrics["krepto_coins_cache_entries"] > 0
+        assert metrics['krepto_validation_duration_seconds_count{phase="connect_block"}'] > 0
+
+        self.log.info("Check that resetting getvalidationtimings does not reset the exported summaries")
+        connect_block = 'krepto_validation_duration_seconds_count{phase="connect_block"}'
+        count = metrics[connect_block]
+        assert_equal(node.getvalidationtimings(reset=True)["connect_block"]["count"], count)
+        assert_equal(node.getvalidationtimings()["connect_block"]["count"], 0)
+        assert_equal(self.get_metrics(node)[connect_block], count)
+
+        self.log.info("Check P2P traffic and RPC metrics")
+        assert metrics['krepto_net_message_bytes_total{direction="sent",msgtype="inv"}'] > 0
+        assert metrics['krepto_net_message_bytes_total{direction="recv",msgtype="version"}'] > 0
+        count = metrics.get('krepto_rpc_duration_seconds_count{method="getblockcount"}', 0)
+        node.getblockcount()
+        metrics = self.get_metrics(node)
+        assert_equal(metrics['krepto_rpc_duration_seconds_count{method="getblockcount"}'], count + 1)
+
+
+if __name__ == '__main__':
+    MetricsTest(__file__).main()
@@ -177,6 +177,26 @@ class RPCInterfaceTest(BitcoinTestFramework):
             request_fields={"jsonrpc": "2.1"},
             response_fields={"result": None, "error": {"code": RPC_INVALID_REQUEST, "message": "JSON-RPC version not supported"}}))
 
+    def test_parallel_batch(self):
+        self.log.info("Testing batch of read-only calls executed concurrently...")
+        node = self.nodes[0]
+        height = node.getblockcount()
+        hashes = [node.getblockhash(h) for h in range(height + 1)]
+        batch = [{"jsonrpc": "2.0", "method": "getblockhash", "params": [i % (height + 1)], "id": i} for i in range(500)]
+        # Calls with side effects and failing calls split the batch, but responses stay in order.
+        batch.insert(100, {"jsonrpc": "2.0", "method": "setmocktime", "params": [0], "id": "mocktime"})
+        batch.insert(200, {"jsonrpc": "2.0", "method": "getblockhash", "params": [height + 1], "id": "error"})
+        batch.insert(300, {"jsonrpc": "2.0", "method": "getblockhash", "params": [0]})
+        response, status = send_json_rpc(node, batch)
+        assert_equal(status, 200)
+        assert_equal(len(response), 502)
+        assert_equal(response[100], {"jsonrpc": "2.0", "result": None, "id": "mocktime"})
+        assert_equal(response[200]["id"], "error")
+        assert_equal(response[200]["error"]["code"], RPC_INVALID_PARAMETER)
+        results = [r for r in response if isinstance(r["id"], int)]
+        assert_equal([r["id"] for r in results], list(range(500)))
+        assert all(r["result"] == hashes[r["id"] % (height + 1)] for r in results)
+
     def test_http_status_codes(self):
         self.log.info("Testing HTTP status codes for JSON-RPC 1.1 requests...")
         # OK
@@ -241,6 +261,7 @@ class RPCInterfaceTest(BitcoinTestFramework):
     def run_test(self):
         self.test_getrpcinfo()
         self.test_batch_requests()
+        self.test_parallel_batch()
         self.test_http_status_codes()
         self.test_work_queue_exceeded()
 
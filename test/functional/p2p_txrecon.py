@@ -0,0 +1,206 @@
+#!/usr/bin/env python3
+# Copyright (c) 2024 The Krepto core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test transaction reconciliation rounds (BIP-330).
+
+- The node responds to an inbound peer's REQRECON with a sketch of the
+  transactions it held back from it, and announces those the peer asks for in
+  RECONCILDIFF.
+- The node floods transactions to an outbound peer, requests sketches from it,
+  and asks for the transactions it is missing.
+- An outbound peer that does not answer a REQRECON is disconnected.
+"""
+
+import time
+
+from test_framework.crypto.siphash import siphash256
+from test_framework.key import TaggedHash
+from test_framework.messages import (
+    CInv,
+    MSG_WTX,
+    msg_inv,
+    msg_reconcildiff,
+    msg_reqrecon,
+    msg_sendtxrcncl,
+    msg_sketch,
+    msg_tx,
+)
+from test_framework.p2p import P2PInterface
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+from test_framework.wallet import MiniWallet
+
+RECON_REQUEST_INTERVAL = 8
+RECON_RESPONSE_TIMEOUT = 60
+# Modulus of GF(2^32) used by minisketch for 32-bit elements: x^32 + x^7 + x^3 + x^2 + 1
+GF32_MODULUS = (1 << 32) | 0x8d
+
+
+def gf32_mul(a, b):
+    r = 0
+    while b:
+        if b & 1:
+            r ^= a
+        b >>= 1
+        a <<= 1
+        if a >> 32:
+            a ^= GF32_MODULUS
+    return r
+
+
+def create_sketch(short_ids, capacity):
+    """Serialize a minisketch of 32-bit elements: the odd power sums x^1, x^3, ...
+    of the elements, little-endian."""
+    syndromes = [0] * capacity
+    for short_id in short_ids:
+        sqr = gf32_mul(short_id, short_id)
+        power = short_id
+        for i in range(capacity):
+            syndromes[i] ^= power
+            power = gf32_mul(power, sqr)
+    return b"".join(s.to_bytes(4, "little") for s in syndromes)
+
+
+class ReconciliationPeer(P2PInterface):
+    def __init__(self):
+        super().__init__()
+        self.salt = 0x1234
+        self.node_salt = None
+        # Short IDs of our own transactions, sketched in reply to the node's requests
+        self.recon_set = []
+        self.answer_reqrecon = True
+        self.reqrecons = []
+        self.sketches = []
+        self.reconcildiffs = []
+        self.wtxid_invs = []
+
+    def on_version(self, message):
+        sendtxrcncl = msg_sendtxrcncl()
+        sendtxrcncl.version = 1
+        sendtxrcncl.salt = self.salt
+        self.send_message(sendtxrcncl)
+        super().on_version(message)
+
+    def on_sendtxrcncl(self, message):
+        self.node_salt = message.salt
+
+    def on_reqrecon(self, message):
+        self.reqrecons.append(message)
+        if self.answer_reqrecon:
+            self.send_message(msg_sketch(create_sketch(self.recon_set, capacity=len(self.recon_set) + 1)))
+
+    def on_sketch(self, message):
+        self.sketches.append(message)
+
+    def on_reconcildiff(self, message):
+        self.reconcildiffs.append(message)
+
+    def on_inv(self, message):
+        super().on_inv(message)
+        self.wtxid_invs += [inv.hash for inv in message.inv if inv.type == MSG_WTX]
+
+    def short_id(self, wtxid):
+        """BIP-330 short ID, salted with both sides' contributions in ascending order."""
+        salt1, salt2 = sorted([self.salt, self.node_salt])
+        salt = TaggedHash("Tx Relay Salting", salt1.to_bytes(8, "little") + salt2.to_bytes(8, "little"))
+        k0 = int.from_bytes(salt[0:8], "little")
+        k1 = int.from_bytes(salt[8:16], "little")
+        return 1 + siphash256(k0, k1, wtxid) % 0xFFFFFFFF
+
+
+class TxReconciliationTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.extra_args = [['-txreconciliation']]
+
+    def bump_mocktime(self, seconds):
+        self.mocktime += seconds
+        self.nodes[0].setmocktime(self.mocktime)
+
+    def test_responder(self):
+        self.log.info('Reconcile with an inbound peer, the node responding with a sketch')
+        node = self.nodes[0]
+        peer = node.add_p2p_connection(ReconciliationPeer())
+        assert peer.node_salt is not None
+
+        tx = self.wallet.send_self_transfer(from_node=node)
+        wtxid = int(tx["wtxid"], 16)
+        # The transaction waits for the next round instead of being announced.
+        self.bump_mocktime(60)
+        peer.sync_with_ping()
+        assert wtxid not in peer.wtxid_invs
+        assert_equal(len(peer.sketches), 0)
+
+        # The sketch is sent along with the next announcements; its capacity is the
+        # estimated difference plus one.
+        peer.send_and_ping(msg_reqrecon(set_size=0, q=0))
+        self.bump_mocktime(60)
+        peer.wait_until(lambda: len(peer.sketches) == 1)
+        assert_equal(peer.sketches[0].skdata, create_sketch([peer.short_id(wtxid)], capacity=2))
+
+        # Ask for it, and get it announced.
+        peer.send_and_ping(msg_reconcildiff(success=True, ask_shortids=[peer.short_id(wtxid)]))
+        self.bump_mocktime(60)
+        peer.wait_until(lambda: wtxid in peer.wtxid_invs)
+        node.disconnect_p2ps()
+
+    def test_initiator(self):
+        self.log.info('Reconcile with an outbound peer, the node requesting sketches')
+        node = self.nodes[0]
+        peer = node.add_outbound_p2p_connection(ReconciliationPeer(), p2p_idx=0)
+        assert peer.node_salt is not None
+        # The first request is sent right away; both sets are empty.
+        peer.wait_until(lambda: len(peer.reconcildiffs) == 1)
+        assert peer.reconcildiffs[0].success
+        assert_equal(peer.reconcildiffs[0].ask_shortids, [])
+
+        # Transactions are still flooded to outbound peers, so the node's set stays empty.
+        flooded = self.wallet.send_self_transfer(from_node=node)
+        self.bump_mocktime(30)
+        peer.wait_until(lambda: int(flooded["wtxid"], 16) in peer.wtxid_invs)
+        peer.wait_until(lambda: len(peer.reconcildiffs) == 2)
+        assert all(reqrecon.set_size == 0 for reqrecon in peer.reqrecons)
+
+        # The peer has a transaction the node is missing, which the node asks for in the next round.
+        missing = self.wallet.create_self_transfer()
+        missing_wtxid = int(missing["wtxid"], 16)
+        peer.recon_set = [peer.short_id(missing_wtxid)]
+        self.bump_mocktime(RECON_REQUEST_INTERVAL)
+        peer.wait_until(lambda: len(peer.reconcildiffs) == 3)
+        assert peer.reconcildiffs[2].success
+        assert_equal(peer.reconcildiffs[2].ask_shortids, [peer.short_id(missing_wtxid)])
+
+        # Announce it as BIP-330 says, and let the node fetch it.
+        peer.send_and_ping(msg_inv([CInv(MSG_WTX, missing_wtxid)]))
+        self.bump_mocktime(1)
+        peer.wait_for_getdata([missing_wtxid])
+        peer.send_and_ping(msg_tx(missing["tx"]))
+        assert missing["txid"] in node.getrawmempool()
+        node.disconnect_p2ps()
+
+    def test_timeout(self):
+        self.log.info('Disconnect an outbound peer that does not answer a reconciliation request')
+        node = self.nodes[0]
+        peer = ReconciliationPeer()
+        peer.answer_reqrecon = False
+        node.add_outbound_p2p_connection(peer, p2p_idx=1)
+        peer.wait_until(lambda: len(peer.reqrecons) == 1)
+        self.bump_mocktime(RECON_RESPONSE_TIMEOUT)
+        peer.sync_with_ping()
+        assert peer.is_connected
+        self.bump_mocktime(1)
+        peer.wait_for_disconnect()
+
+    def run_test(self):
+        self.wallet = MiniWallet(self.nodes[0])
+        self.mocktime = int(time.time())
+        self.nodes[0].setmocktime(self.mocktime)
+
+        self.test_responder()
+        self.test_initiator()
+        self.test_timeout()
+
+
+if __name__ == '__main__':
+    TxReconciliationTest(__file__).main()
@@ -1896,6 +1896,65 @@ class msg_sendtxrcncl:
         return "msg_sendtxrcncl(version=%lu, salt=%lu)" %\
             (self.version, self.salt)
 
+
+class msg_reqrecon:
+    __slots__ = ("set_size", "q")
+    msgtype = b"reqrecon"
+
+    def __init__(self, set_size=0, q=0):
+        self.set_size = set_size
+        self.q = q
+
+    def deserialize(self, f):
+        self.set_size = int.from_bytes(f.read(2), "little")
+        self.q = int.from_bytes(f.read(2), "little")
+
+    def serialize(self):
+        return self.set_size.to_bytes(2, "little") + self.q.to_bytes(2, "little")
+
+    def __repr__(self):
+        return "msg_reqrecon(set_size=%lu, q=%lu)" % (self.set_size, self.q)
+
+
+class msg_sketch:
+    __slots__ = ("skdata",)
+    msgtype = b"sketch"
+
+    def __init__(self, skdata=b""):
+        self.skdata = skdata
+
+    def deserialize(self, f):
+        self.skdata = deser_string(f)
+
+    def serialize(self):
+        return ser_string(self.skdata)
+
+    def __repr__(self):
+        return "msg_sketch(skdata=%s)" % self.skdata.hex()
+
+
+class msg_reconcildiff:
+    __slots__ = ("success", "ask_shortids")
+    msgtype = b"reconcildiff"
+
+    def __init__(self, success=False, ask_shortids=None):
+        self.success = success
+        self.ask_shortids = ask_shortids or []
+
+    def deserialize(self, f):
+        self.success = bool(f.read(1)[0])
+        self.ask_shortids = [int.from_bytes(f.read(4), "little") for _ in range(deser_compact_size(f))]
+
+    def serialize(self):
+        r = bytes([int(self.success)])
+        r += ser_compact_size(len(self.ask_shortids))
+        for short_id in self.ask_shortids:
+            r += short_id.to_bytes(4, "little")
+        return r
+
+    def __repr__(self):
+        return "msg_reconcildiff(success=%i, ask_shortids=%s)" % (self.success, self.ask_shortids)
+
 class TestFrameworkScript(unittest.TestCase):
     def test_addrv2_encode_decode(self):
         def check_addrv2(ip, net):
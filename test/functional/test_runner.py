@@ -197,6 +197,7 @@ BASE_SCRIPTS = [
     'p2p_1p1c_network.py',
     'p2p_opportunistic_1p1c.py',
     'interface_rest.py',
+    'interface_metrics.py',
     'mempool_spend_coinbase.py',
     'wallet_avoid_mixing_output_types.py --descriptors',
     'mempool_reorg.py',
@@ -378,6 +379,7 @@ BASE_SCRIPTS = [
     'p2p_tx_privacy.py',
     'rpc_scanblocks.py',
     'p2p_sendtxrcncl.py',
+    'p2p_txrecon.py',
     'rpc_scantxoutset.py',
     'feature_unsupported_utxo_db.py',
     'feature_logging.py',